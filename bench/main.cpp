@@ -0,0 +1,514 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "rasterizer_bench.h"
+#include "tool_src/profile.h"
+#include "src/export.h"
+#include "src/mlet_gen.h"
+#include "src/rasterizer/rasterizer_config.h"
+#include "sxp_src/core/math/geo3.h"
+#include "sxp_src/core/fsys/fsys.h"
+#include "sxp_src/core/streams.h"
+#include "sxp_src/core/main.h"
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// config
+//============================================================================
+static const char *s_bench_name="Meshlete Benchmark v0.1";
+static const char *s_bench_format="meshlete_bench 2";  // bump when the report columns change
+static const char *s_usage_message="Usage: bench [options]   (-h for help)";
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  //==========================================================================
+  // e_bench_mesh_type
+  //==========================================================================
+  enum e_bench_mesh_type
+  {
+    benchmesh_sphere,   // single tessellated sphere
+    benchmesh_terrain,  // noisy heightfield grid
+    benchmesh_shells,   // many small disconnected spheres
+  };
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // bench_mesh_desc
+  //==========================================================================
+  struct bench_mesh_desc
+  {
+    const char *name;
+    e_bench_mesh_type type;
+    uint32_t num_tris;  // approximate triangle count
+    unsigned num_segs;
+  };
+  //----
+
+  static const bench_mesh_desc s_bench_meshes[]=
+  {
+    {"sphere_1m",   benchmesh_sphere,   1000000, 1},
+    {"terrain_1m",  benchmesh_terrain,  1000000, 4},
+    {"shells_1m",   benchmesh_shells,   1000000, 8},
+    {"sphere_5m",   benchmesh_sphere,   5000000, 1},
+    {"terrain_5m",  benchmesh_terrain,  5000000, 4},
+    {"shells_5m",   benchmesh_shells,   5000000, 8},
+    {"sphere_20m",  benchmesh_sphere,  20000000, 1},
+    {"terrain_20m", benchmesh_terrain, 20000000, 4},
+    {"shells_20m",  benchmesh_shells,  20000000, 8},
+  };
+  enum {num_bench_meshes=sizeof(s_bench_meshes)/sizeof(*s_bench_meshes)};
+  enum {bench_max_vcone_mlets=65535};  // generate_vcones() rasterizes all meshlets in one commit with 16-bit cluster indices
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // bench_arguments
+  //==========================================================================
+  struct bench_arguments
+  {
+    bench_arguments()
+    {
+      tri_scale_percent=100;
+      mlet_max_vtx=64;
+      mlet_max_tris=128;
+      num_vcone_views=64;
+      vcone_render_res=256;
+      vcones=true;
+      rasterizer=false;
+      num_rasterizer_frames=20;
+    }
+    //----
+
+    heap_str mesh_filter;
+    heap_str output_file;
+    uint32_t tri_scale_percent;
+    uint8_t mlet_max_vtx;
+    uint8_t mlet_max_tris;
+    uint32_t num_vcone_views;
+    uint32_t vcone_render_res;
+    bool vcones;
+    bool rasterizer;
+    uint32_t num_rasterizer_frames;
+  };
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // bench_mesh
+  //==========================================================================
+  struct bench_mesh
+  {
+    array<vec3f> vertices;
+    array<uint32_t> indices;
+    array<mesh_geometry_segment> segs;
+  };
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // hash_float
+  //==========================================================================
+  float hash_float(uint32_t v_)
+  {
+    // deterministic hash to [0, 1) so that the meshes are identical on all platforms
+    v_^=v_>>16;
+    v_*=0x7feb352d;
+    v_^=v_>>15;
+    v_*=0x846ca68b;
+    v_^=v_>>16;
+    return float(v_>>8)*(1.0f/16777216.0f);
+  }
+  //----
+
+  float value_noise(float x_, float y_, uint32_t seed_)
+  {
+    // bilinearly interpolated lattice noise in range [0, 1)
+    float fx=floor(x_), fy=floor(y_);
+    uint32_t ix=uint32_t(int32_t(fx)), iy=uint32_t(int32_t(fy));
+    float tx=x_-fx, ty=y_-fy;
+    tx=tx*tx*(3.0f-2.0f*tx);
+    ty=ty*ty*(3.0f-2.0f*ty);
+    float v00=hash_float(seed_^(ix*0x8da6b343)^(iy*0xd8163841));
+    float v10=hash_float(seed_^((ix+1)*0x8da6b343)^(iy*0xd8163841));
+    float v01=hash_float(seed_^(ix*0x8da6b343)^((iy+1)*0xd8163841));
+    float v11=hash_float(seed_^((ix+1)*0x8da6b343)^((iy+1)*0xd8163841));
+    return lerp(lerp(v00, v10, tx), lerp(v01, v11, tx), ty);
+  }
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // add_uv_sphere
+  //==========================================================================
+  void add_uv_sphere(bench_mesh &mesh_, const vec3f &pos_, float rad_, uint32_t num_rings_, uint32_t num_sectors_)
+  {
+    // add pole vertices and (num_rings_-1) rings of num_sectors_ vertices (2*num_sectors_*(num_rings_-1) triangles)
+    PFC_ASSERT(num_rings_>=2 && num_sectors_>=3);
+    uint32_t base_vidx=(uint32_t)mesh_.vertices.size();
+    mesh_.vertices.push_back(pos_+vec3f(0.0f, 0.0f, rad_));
+    for(uint32_t ri=1; ri<num_rings_; ++ri)
+    {
+      float theta=mathf::pi*float(ri)/float(num_rings_);
+      float z=cos(theta), r=sin(theta);
+      for(uint32_t si=0; si<num_sectors_; ++si)
+      {
+        float phi=2.0f*mathf::pi*float(si)/float(num_sectors_);
+        mesh_.vertices.push_back(pos_+vec3f(r*cos(phi), r*sin(phi), z)*rad_);
+      }
+    }
+    mesh_.vertices.push_back(pos_-vec3f(0.0f, 0.0f, rad_));
+
+    // add cap and band triangles
+    uint32_t last_ring=base_vidx+1+(num_rings_-2)*num_sectors_;
+    uint32_t bottom_pole=last_ring+num_sectors_;
+    for(uint32_t si=0; si<num_sectors_; ++si)
+    {
+      uint32_t sn=(si+1)%num_sectors_;
+      uint32_t tri[3]={base_vidx, base_vidx+1+si, base_vidx+1+sn};
+      mesh_.indices.insert_back(3, tri);
+    }
+    for(uint32_t ri=0; ri<num_rings_-2; ++ri)
+    {
+      uint32_t ring0=base_vidx+1+ri*num_sectors_, ring1=ring0+num_sectors_;
+      for(uint32_t si=0; si<num_sectors_; ++si)
+      {
+        uint32_t sn=(si+1)%num_sectors_;
+        uint32_t quad[6]={ring0+si, ring1+si, ring1+sn, ring0+si, ring1+sn, ring0+sn};
+        mesh_.indices.insert_back(6, quad);
+      }
+    }
+    for(uint32_t si=0; si<num_sectors_; ++si)
+    {
+      uint32_t sn=(si+1)%num_sectors_;
+      uint32_t tri[3]={bottom_pole, last_ring+sn, last_ring+si};
+      mesh_.indices.insert_back(3, tri);
+    }
+  }
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // generate_bench_mesh
+  //==========================================================================
+  void generate_bench_mesh(bench_mesh &mesh_, e_bench_mesh_type type_, uint32_t num_tris_, unsigned num_segs_)
+  {
+    uint32_t seg_tri_granularity=1;
+    switch(type_)
+    {
+      // sphere with 4*n^2 triangles
+      case benchmesh_sphere:
+      {
+        uint32_t n=max(2u, uint32_t(sqrt(float(num_tris_)/4.0f)+0.5f));
+        add_uv_sphere(mesh_, vec3f(0.0f, 0.0f, 0.0f), 10.0f, n+1, 2*n);
+      } break;
+
+      // 1km^2 terrain grid with 2*n^2 triangles and a few octaves of value noise
+      case benchmesh_terrain:
+      {
+        uint32_t n=max(1u, uint32_t(sqrt(float(num_tris_)/2.0f)+0.5f));
+        float cell_size=1000.0f/float(n);
+        mesh_.vertices.resize((n+1)*(n+1));
+        for(uint32_t y=0; y<=n; ++y)
+          for(uint32_t x=0; x<=n; ++x)
+          {
+            float h=0.0f, amp=60.0f, freq=4.0f/float(n);
+            for(uint32_t octave=0; octave<6; ++octave, amp*=0.5f, freq*=2.0f)
+              h+=amp*value_noise(float(x)*freq, float(y)*freq, octave);
+            mesh_.vertices[y*(n+1)+x]=vec3f(float(x)*cell_size, float(y)*cell_size, h);
+          }
+        for(uint32_t y=0; y<n; ++y)
+          for(uint32_t x=0; x<n; ++x)
+          {
+            uint32_t v00=y*(n+1)+x, v10=v00+1, v01=v00+n+1, v11=v01+1;
+            uint32_t quad[6]={v00, v10, v11, v00, v11, v01};
+            mesh_.indices.insert_back(6, quad);
+          }
+        seg_tri_granularity=2*n;
+      } break;
+
+      // randomly scattered small spheres of 36 triangles
+      case benchmesh_shells:
+      {
+        enum {shell_rings=4, shell_sectors=6, shell_tris=2*shell_sectors*(shell_rings-1)};
+        uint32_t num_shells=max(1u, num_tris_/shell_tris);
+        float extent=2.0f*pow(float(num_shells), 1.0f/3.0f);
+        for(uint32_t i=0; i<num_shells; ++i)
+        {
+          vec3f pos(hash_float(i*3+0)*extent, hash_float(i*3+1)*extent, hash_float(i*3+2)*extent);
+          add_uv_sphere(mesh_, pos, 0.3f+0.5f*hash_float(~i), shell_rings, shell_sectors);
+        }
+        seg_tri_granularity=shell_tris;
+      } break;
+    }
+
+    // split the triangles to segments of contiguous ranges
+    uint32_t num_units=uint32_t(mesh_.indices.size()/3)/seg_tri_granularity;
+    num_segs_=max(1u, min(num_segs_, num_units));
+    for(unsigned si=0; si<num_segs_; ++si)
+    {
+      uint32_t start_tri=(num_units*si/num_segs_)*seg_tri_granularity;
+      uint32_t end_tri=si+1<num_segs_?(num_units*(si+1)/num_segs_)*seg_tri_granularity:uint32_t(mesh_.indices.size()/3);
+      mesh_geometry_segment &seg=mesh_.segs.push_back();
+      seg.material_id=si;
+      seg.start_tri_idx=start_tri*3;
+      seg.num_tris=end_tri-start_tri;
+      seg.sbox=seed_oobox3_discrete(mesh_.vertices.data(), seg.num_tris*3, discrete_axes3_49, mesh_.indices.data()+seg.start_tri_idx);
+    }
+  }
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // parse_bench_arguments
+  //==========================================================================
+  bool parse_uint_arg(uint32_t &res_, const char *arg_, uint32_t min_, uint32_t max_, heap_str &error_msg_)
+  {
+    int v=0;
+    if(!str_to_int(v, arg_) || v<int(min_) || v>int(max_))
+    {
+      error_msg_.push_back_format("> Error: Invalid parameter \"%s\" (must be %i-%i)\r\n", arg_, min_, max_);
+      return false;
+    }
+    res_=uint32_t(v);
+    return true;
+  }
+  //----
+
+  bool parse_bench_arguments(bench_arguments &ba_, const char **args_, unsigned num_args_)
+  {
+    heap_str error_msg;
+    for(unsigned arg_idx=0; arg_idx<num_args_; ++arg_idx)
+    {
+      const char *carg=args_[arg_idx];
+      bool has_param=arg_idx<num_args_-1;
+      uint32_t v;
+      if(str_eq(carg, "-h"))
+      {
+        logf("%s\r\n"
+             "\r\n"
+             "%s\r\n"
+             "\r\n"
+             "Runs the conversion stages over procedurally generated meshes and reports\r\n"
+             "triangles/sec and peak memory per stage (one whitespace separated line per\r\n"
+             "mesh and stage). With -r runs the software rasterizer benchmark instead,\r\n"
+             "which sweeps tile size, depth format, hi-z, vertex cache size and overdraw\r\n"
+             "(plus a P3G sphere rendered with meshlet culling) and fails if the rendered\r\n"
+             "images differ between configs.\r\n"
+             "\r\n"
+             "Options:\r\n"
+             "  -m <name>    Run only meshes whose name starts with <name> (e.g. \"terrain\", \"sphere_5m\")\r\n"
+             "  -s <pct>     Scale triangle counts by percentage (1-100, default: 100)\r\n"
+             "  -o <file>    Also write the report to a file\r\n"
+             "  -mv <num>    Max meshlet vertices (8-255, default: 64)\r\n"
+             "  -mt <num>    Max meshlet triangles (8-255, default: 128)\r\n"
+             "  -nc          Skip visibility cone generation\r\n"
+             "  -mcv <num>   Number of visibility cone views (default: 64)\r\n"
+             "  -mcr <res>   Visibility cone render resolution (default: 256)\r\n"
+             "  -r           Run the rasterizer benchmark\r\n"
+             "  -rf <num>    Rasterizer benchmark frames per config (1-10000, default: 20)\r\n"
+             "  -h           Print this screen\r\n", s_bench_name, s_usage_message);
+        return false;
+      }
+      else if(str_eq(carg, "-m") && has_param)
+        ba_.mesh_filter=args_[++arg_idx];
+      else if(str_eq(carg, "-o") && has_param)
+        ba_.output_file=args_[++arg_idx];
+      else if(str_eq(carg, "-s") && has_param)
+        parse_uint_arg(ba_.tri_scale_percent, args_[++arg_idx], 1, 100, error_msg);
+      else if(str_eq(carg, "-mv") && has_param)
+      {
+        if(parse_uint_arg(v, args_[++arg_idx], 8, 255, error_msg))
+          ba_.mlet_max_vtx=uint8_t(v);
+      }
+      else if(str_eq(carg, "-mt") && has_param)
+      {
+        if(parse_uint_arg(v, args_[++arg_idx], 8, 255, error_msg))
+          ba_.mlet_max_tris=uint8_t(v);
+      }
+      else if(str_eq(carg, "-nc"))
+        ba_.vcones=false;
+      else if(str_eq(carg, "-mcv") && has_param)
+        parse_uint_arg(ba_.num_vcone_views, args_[++arg_idx], 1, 65536, error_msg);
+      else if(str_eq(carg, "-mcr") && has_param)
+        parse_uint_arg(ba_.vcone_render_res, args_[++arg_idx], 16, 4096, error_msg);
+      else if(str_eq(carg, "-r"))
+        ba_.rasterizer=true;
+      else if(str_eq(carg, "-rf") && has_param)
+        parse_uint_arg(ba_.num_rasterizer_frames, args_[++arg_idx], 1, 10000, error_msg);
+      else
+        error_msg.push_back_format("> Error: Unknown option \"%s\"\r\n", carg);
+    }
+    if(error_msg.size())
+    {
+      errorf("%s%s\r\n", error_msg.c_str(), s_usage_message);
+      return false;
+    }
+    return true;
+  }
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // run_bench_mesh
+  //==========================================================================
+  bool run_bench_mesh(heap_str &report_, const bench_arguments &ba_, const bench_mesh_desc &desc_)
+  {
+    // generate the mesh
+    uint32_t target_tris=uint32_t(uint64_t(desc_.num_tris)*ba_.tri_scale_percent/100);
+    logf("> Generating mesh \"%s\" (~%i triangles)...\r\n", desc_.name, target_tris);
+    bench_mesh mesh;
+    generate_bench_mesh(mesh, desc_.type, target_tris, desc_.num_segs);
+    mesh_geometry mgeo;
+    mgeo.vertices=mesh.vertices.data();
+    mgeo.indices=mesh.indices.data();
+    mgeo.num_vertices=mesh.vertices.size();
+    mgeo.num_indices=mesh.indices.size();
+    seed_oobox3f sbox=seed_oobox3_discrete(mesh.vertices.data(), mesh.vertices.size(), discrete_axes3_49);
+    mgeo.bvol=bounding_sphere3_exp(mesh.vertices.data(), mesh.vertices.size(), sbox, true);
+    mgeo.segs=mesh.segs.data();
+    mgeo.num_segs=mesh.segs.size();
+    mgeo.vbuf=mesh.vertices.data();
+    mgeo.vbuf_size=mesh.vertices.size()*sizeof(vec3f);
+    mgeo.vfmt_id=0;
+
+    // run the conversion stages
+    profiler prof;
+    p3g_mesh_geometry p3g_geo;
+    meshlet_gen_cfg mgen_cfg;
+    mgen_cfg.max_mlet_vtx=ba_.mlet_max_vtx;
+    mgen_cfg.max_mlet_tris=ba_.mlet_max_tris;
+    mgen_cfg.mlet_stripify=false;
+    prof.begin_stage("generate_meshlets");
+    generate_meshlets(mgen_cfg, mgeo, p3g_geo);
+    prof.end_stage();
+    prof.begin_stage("generate_bvols");
+    generate_bvols(mgeo, p3g_geo);
+    prof.end_stage();
+    bool vcones=ba_.vcones;
+    if(vcones)
+    {
+      // skip visibility cones for meshes exceeding the rasterizer cluster limits
+      bool is_vcone_mesh=p3g_geo.mlets.size()<=bench_max_vcone_mlets;
+      for(usize_t seg_idx=0; seg_idx<p3g_geo.segs.size(); ++seg_idx)
+        is_vcone_mesh&=p3g_geo.segs[seg_idx].num_mlets<rasterizer_max_local_clusters;
+      if(!is_vcone_mesh)
+      {
+        warnf("> Warning: Skipping visibility cones for \"%s\" (%zi meshlets exceed the rasterizer cluster limits)\r\n", desc_.name, p3g_geo.mlets.size());
+        vcones=false;
+      }
+    }
+    if(vcones)
+    {
+      prof.begin_stage("generate_vcones");
+      generate_vcones(mgeo, p3g_geo, ba_.num_vcone_views, uint16_t(ba_.vcone_render_res));
+      prof.end_stage();
+    }
+    array<uint8_t> p3g_data;
+    {
+      export_cfg_p3g p3g_cfg;
+      p3g_cfg.export_meshlet_bvols=true;
+      p3g_cfg.export_meshlet_vcones=vcones;
+      p3g_cfg.local_vbuf=false;
+      p3g_cfg.packed_vidx=false;
+      p3g_cfg.packed_tidx=false;
+      p3g_cfg.vbuf_align=4;
+      p3g_cfg.log_stats=true;
+      container_output_stream<array<uint8_t> > cout(p3g_data);
+      prof.begin_stage("export_p3g");
+      bool is_exported=export_p3g(cout, p3g_cfg, mgeo, p3g_geo);
+      prof.end_stage();
+      if(!is_exported)
+      {
+        errorf("> Error: P3G export failed for \"%s\"\r\n", desc_.name);
+        return false;
+      }
+    }
+
+    // append a report line per stage
+    const uint32_t num_tris=uint32_t(mesh.indices.size()/3);
+    for(const profile_stage &stage:prof.stages())
+    {
+      double tris_per_sec=stage.wall_time>0.0?num_tris/stage.wall_time:0.0;
+      usize_t line_start=report_.size();
+      report_.push_back_format("%-12s %-18s %10i %9zi %10.4f %14.0f %10.1f %10.1f\r\n",
+                               desc_.name, stage.name.c_str(), num_tris, p3g_geo.mlets.size(), stage.wall_time, tris_per_sec,
+                               double(stage.peak_mem)/(1024.0*1024.0), double(stage.stage_peak_mem)/(1024.0*1024.0));
+      logf("%s", report_.c_str()+line_start);
+    }
+    return true;
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// main
+//============================================================================
+PFC_MAIN(const char *args_[], unsigned num_args_)
+{
+  // parse arguments
+  bench_arguments ba;
+  if(!parse_bench_arguments(ba, args_, num_args_))
+    return -1;
+
+  // run the rasterizer benchmark or conversion benchmarks for the selected
+  // meshes. peak memory is the process high-water mark, so meshes run in
+  // increasing size order
+  heap_str report;
+  if(ba.rasterizer)
+  {
+    if(!run_rasterizer_bench(report, ba.num_rasterizer_frames))
+      return -1;
+  }
+  else
+  {
+    report.push_back_format("# %s\r\n"
+                            "# settings: scale=%i%% mv=%i mt=%i vcones=%i mcv=%i mcr=%i\r\n",
+                            s_bench_format, ba.tri_scale_percent, ba.mlet_max_vtx, ba.mlet_max_tris, ba.vcones?1:0, ba.num_vcone_views, ba.vcone_render_res);
+    report.push_back_format("%-12s %-18s %10s %9s %10s %14s %10s %10s\r\n", "#mesh", "stage", "triangles", "meshlets", "seconds", "tris_per_sec", "peak_mb", "stage_mb");
+    logf("%s", report.c_str());
+    usize_t filter_size=ba.mesh_filter.size();
+    unsigned num_run=0;
+    for(unsigned i=0; i<num_bench_meshes; ++i)
+    {
+      const bench_mesh_desc &desc=s_bench_meshes[i];
+      if(filter_size && (str_size(desc.name)<filter_size || !mem_eq(desc.name, ba.mesh_filter.c_str(), filter_size)))
+        continue;
+      if(!run_bench_mesh(report, ba, desc))
+        return -1;
+      ++num_run;
+    }
+    if(!num_run)
+    {
+      errorf("> Error: No benchmark meshes match \"%s\"\r\n", ba.mesh_filter.c_str());
+      return -1;
+    }
+  }
+
+  // write the report file
+  if(ba.output_file.size())
+  {
+    owner_ref<file_system_base> fsys=create_default_file_system(true);
+    owner_ptr<bin_output_stream_base> fout=fsys->open_write(ba.output_file.c_str());
+    if(!fout.data)
+    {
+      errorf("> Error: Unable to write report file \"%s\"\r\n", ba.output_file.c_str());
+      return -1;
+    }
+    fout.data->write_bytes(report.c_str(), report.size());
+  }
+  return 0;
+}
+//----------------------------------------------------------------------------
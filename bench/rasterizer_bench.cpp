@@ -0,0 +1,701 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "rasterizer_bench.h"
+#include "src/export.h"
+#include "src/mlet_gen.h"
+#include "src/p3g_shader.h"
+#include "src/rasterizer/rasterizer.h"
+#include "sxp_src/core/containers.h"
+#include "sxp_src/core/streams.h"
+#include <chrono>
+#include <thread>
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  //==========================================================================
+  // config
+  //==========================================================================
+  enum {rbench_width=1280, rbench_height=720};
+  enum {rbench_grid_size=40};                                                         // clusters per layer row/column
+  enum {rbench_patch_quads=7};                                                        // quads per cluster row/column
+  enum {rbench_cluster_vtx=(rbench_patch_quads+1)*(rbench_patch_quads+1)};            // 64 vertices per cluster
+  enum {rbench_cluster_tris=2*rbench_patch_quads*rbench_patch_quads};                 // 98 triangles per cluster
+  enum {rbench_max_layers=4};
+  enum {rbench_max_clusters=rbench_grid_size*rbench_grid_size*rbench_max_layers};
+  enum {rbench_max_cluster_strips=32768};
+  enum {rbench_max_dispatches=rbench_max_layers};
+  enum {rbench_shader_store_size=rbench_max_dispatches*256};
+  enum {rbench_p3g_rings=128, rbench_p3g_sectors=256};                                // P3G sphere tessellation (65024 triangles)
+  enum {rbench_p3g_vcone_views=32, rbench_p3g_vcone_res=256};
+  //----
+
+  static const rasterizer_tile_size_t s_rbench_tile_sizes[]={32, 64, 128};
+  static const e_rasterizer_depth_format s_rbench_depth_formats[]={rtzr_depthfmt_uint8, rtzr_depthfmt_uint16, rtzr_depthfmt_float32};
+  static const char *s_rbench_depth_format_names[]={"none", "uint8", "uint16", "float32"};
+  static const usize_t s_rbench_vcache_sizes[]={0, 16384, 262144};
+  static const unsigned s_rbench_overdraws[]={1, rbench_max_layers, 0};  // 0 = render the P3G sphere instead of the layers
+  static const char *s_rbench_scene_names[]={"1x", "4x", "p3g"};
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  static const unsigned s_rbench_num_worker_modes=2;  // single-threaded and all hardware threads
+#else
+  static const unsigned s_rbench_num_worker_modes=1;
+#endif
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // rbench_scene
+  //==========================================================================
+  struct rbench_cluster
+  {
+    uint32_t start_vtx;
+    vec2f bmin, bmax;  // object space xy bounds
+  };
+  //----
+
+  struct rbench_scene
+  {
+    array<vec3f> vertices;  // xy in [-1, 1], z is a small depth offset in [0, 0.02]
+    array<rbench_cluster> clusters;
+    uint8_t tidx[rbench_cluster_tris*3];
+    array<uint8_t> p3g_data;  // unit sphere exported to P3G with meshlet bounds and visibility cones
+    p3g_view p3g;
+    uint32_t p3g_num_tris;
+  };
+  //----
+
+  struct rbench_vout
+  {
+    vec4f pos;
+    vec3f col;
+  };
+  //----
+
+  float rbench_hash(uint32_t v_)
+  {
+    v_^=v_>>16;
+    v_*=0x7feb352d;
+    v_^=v_>>15;
+    v_*=0x846ca68b;
+    v_^=v_>>16;
+    return float(v_>>8)*(1.0f/16777216.0f);
+  }
+  //----
+
+  void generate_rbench_scene(rbench_scene &scene_)
+  {
+    // setup shared cluster topology of patch_quads x patch_quads quads
+    uint8_t *tidx=scene_.tidx;
+    for(unsigned y=0; y<rbench_patch_quads; ++y)
+      for(unsigned x=0; x<rbench_patch_quads; ++x)
+      {
+        uint8_t v00=uint8_t(y*(rbench_patch_quads+1)+x), v10=v00+1, v01=uint8_t(v00+rbench_patch_quads+1), v11=v01+1;
+        *tidx++=v00; *tidx++=v01; *tidx++=v11;
+        *tidx++=v00; *tidx++=v11; *tidx++=v10;
+      }
+
+    // setup grid of cluster patches with jittered depth
+    const float cell_size=2.0f/rbench_grid_size;
+    for(unsigned cy=0; cy<rbench_grid_size; ++cy)
+      for(unsigned cx=0; cx<rbench_grid_size; ++cx)
+      {
+        rbench_cluster &c=scene_.clusters.push_back();
+        c.start_vtx=(uint32_t)scene_.vertices.size();
+        c.bmin=vec2f(-1.0f+cx*cell_size, -1.0f+cy*cell_size);
+        c.bmax=vec2f(c.bmin.x+cell_size, c.bmin.y+cell_size);
+        for(unsigned y=0; y<=rbench_patch_quads; ++y)
+          for(unsigned x=0; x<=rbench_patch_quads; ++x)
+          {
+            float dz=0.02f*rbench_hash(c.start_vtx+y*(rbench_patch_quads+1)+x);
+            scene_.vertices.push_back(vec3f(c.bmin.x+cell_size*x/rbench_patch_quads, c.bmin.y+cell_size*y/rbench_patch_quads, dz));
+          }
+      }
+  }
+  //----
+
+  bool generate_rbench_p3g(rbench_scene &scene_)
+  {
+    // generate unit sphere with pole vertices and (rings-1) rings of sectors vertices
+    array<vec3f> vertices;
+    array<uint32_t> indices;
+    vertices.push_back(vec3f(0.0f, 0.0f, 1.0f));
+    for(uint32_t ri=1; ri<rbench_p3g_rings; ++ri)
+    {
+      float theta=mathf::pi*float(ri)/float(rbench_p3g_rings);
+      for(uint32_t si=0; si<rbench_p3g_sectors; ++si)
+      {
+        float phi=2.0f*mathf::pi*float(si)/float(rbench_p3g_sectors);
+        vertices.push_back(vec3f(sin(theta)*cos(phi), sin(theta)*sin(phi), cos(theta)));
+      }
+    }
+    vertices.push_back(vec3f(0.0f, 0.0f, -1.0f));
+    const uint32_t last_ring=1+(rbench_p3g_rings-2)*rbench_p3g_sectors, bottom_pole=last_ring+rbench_p3g_sectors;
+    for(uint32_t si=0; si<rbench_p3g_sectors; ++si)
+    {
+      uint32_t sn=(si+1)%rbench_p3g_sectors;
+      uint32_t tri[3]={0, 1+si, 1+sn};
+      indices.insert_back(3, tri);
+    }
+    for(uint32_t ri=0; ri<rbench_p3g_rings-2; ++ri)
+    {
+      uint32_t ring0=1+ri*rbench_p3g_sectors, ring1=ring0+rbench_p3g_sectors;
+      for(uint32_t si=0; si<rbench_p3g_sectors; ++si)
+      {
+        uint32_t sn=(si+1)%rbench_p3g_sectors;
+        uint32_t quad[6]={ring0+si, ring1+si, ring1+sn, ring0+si, ring1+sn, ring0+sn};
+        indices.insert_back(6, quad);
+      }
+    }
+    for(uint32_t si=0; si<rbench_p3g_sectors; ++si)
+    {
+      uint32_t sn=(si+1)%rbench_p3g_sectors;
+      uint32_t tri[3]={bottom_pole, last_ring+sn, last_ring+si};
+      indices.insert_back(3, tri);
+    }
+    scene_.p3g_num_tris=uint32_t(indices.size()/3);
+
+    // setup single segment mesh geometry with positions as the vertex format
+    mesh_geometry_segment seg;
+    seg.material_id=0;
+    seg.start_tri_idx=0;
+    seg.num_tris=scene_.p3g_num_tris;
+    seg.sbox=seed_oobox3_discrete(vertices.data(), seg.num_tris*3, discrete_axes3_49, indices.data());
+    mesh_geometry mgeo;
+    mgeo.bvol=sphere3f(vec3f(0.0f, 0.0f, 0.0f), 1.0f);
+    mgeo.segs=&seg;
+    mgeo.num_segs=1;
+    mgeo.vertices=vertices.data();
+    mgeo.indices=indices.data();
+    mgeo.num_vertices=vertices.size();
+    mgeo.num_indices=indices.size();
+    mgeo.vbuf=vertices.data();
+    mgeo.vbuf_size=vertices.size()*sizeof(vec3f);
+    mgeo.vfmt_id=0;
+
+    // generate meshlets within the rasterizer bench cluster limits and export them to P3G
+    p3g_mesh_geometry p3g_geo;
+    meshlet_gen_cfg mgen_cfg;
+    mgen_cfg.max_mlet_vtx=rbench_cluster_vtx;
+    mgen_cfg.max_mlet_tris=rbench_cluster_tris;
+    mgen_cfg.mlet_stripify=false;
+    generate_meshlets(mgen_cfg, mgeo, p3g_geo);
+    generate_bvols(mgeo, p3g_geo);
+    generate_vcones(mgeo, p3g_geo, rbench_p3g_vcone_views, rbench_p3g_vcone_res, false);
+    PFC_ASSERT(p3g_geo.mlets.size()<=rbench_max_clusters);
+    export_cfg_p3g p3g_cfg;
+    p3g_cfg.export_meshlet_bvols=true;
+    p3g_cfg.export_meshlet_vcones=true;
+    p3g_cfg.local_vbuf=false;
+    p3g_cfg.packed_vidx=false;
+    p3g_cfg.packed_tidx=false;
+    p3g_cfg.log_stats=false;
+    p3g_cfg.vbuf_align=4;
+    container_output_stream<array<uint8_t> > cout(scene_.p3g_data);
+    if(!export_p3g(cout, p3g_cfg, mgeo, p3g_geo))
+    {
+      errorf("> Error: P3G export of the rasterizer benchmark sphere failed\r\n");
+      return false;
+    }
+    if(!scene_.p3g.init(scene_.p3g_data.data(), scene_.p3g_data.size()))
+    {
+      errorf("> Error: Invalid P3G data for the rasterizer benchmark sphere\r\n");
+      return false;
+    }
+    return true;
+  }
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // rbench_shader
+  //==========================================================================
+  // Renders one layer of the scene with rotation, scale and offset in screen
+  // space at the layer depth. Layers are dispatched front-to-back, so Hi-Z
+  // culls clusters of the layers behind.
+  template<e_rasterizer_depth_format DepthFmt>
+  struct rbench_shader: rasterizer_shader_base
+  {
+    enum {depth_format=DepthFmt};
+    enum {cullmode=rtzr_cullmode_none};
+    typedef rbench_vout vout;
+    //------------------------------------------------------------------------
+
+    void set_layer(const rbench_scene &scene_, unsigned layer_idx_, unsigned num_layers_)
+    {
+      scene=&scene_;
+      float angle=0.05f+0.08f*layer_idx_;
+      cos_angle=1.35f*cos(angle);
+      sin_angle=1.35f*sin(angle);
+      offs=vec2f(0.015f*layer_idx_, -0.01f*layer_idx_);
+      z=0.1f+0.8f*float(layer_idx_)/num_layers_;
+      tint=vec3f(0.3f+0.7f*rbench_hash(layer_idx_*3+0), 0.3f+0.7f*rbench_hash(layer_idx_*3+1), 0.3f+0.7f*rbench_hash(layer_idx_*3+2));
+    }
+    //----
+
+    PFC_INLINE vec2f tform_xy(float x_, float y_) const
+    {
+      return vec2f(x_*cos_angle-y_*sin_angle+offs.x, x_*sin_angle+y_*cos_angle+offs.y);
+    }
+    //----
+
+    PFC_INLINE rasterizer_local_cluster_index_t init_shader() const
+    {
+      return (rasterizer_local_cluster_index_t)scene->clusters.size();
+    }
+    //----
+
+    void setup_cluster(rasterizer_tiling &tiling_, rasterizer_dispatch_index_t dispatch_idx_, rasterizer_local_cluster_index_t cluster_idx_) const
+    {
+      // bin the cluster with the screen bounds of the transformed patch corners
+      const rbench_cluster &c=scene->clusters[cluster_idx_];
+      vec2f p0=tform_xy(c.bmin.x, c.bmin.y), p1=tform_xy(c.bmax.x, c.bmin.y);
+      vec2f p2=tform_xy(c.bmin.x, c.bmax.y), p3=tform_xy(c.bmax.x, c.bmax.y);
+      float min_x=min(min(p0.x, p1.x), min(p2.x, p3.x)), max_x=max(max(p0.x, p1.x), max(p2.x, p3.x));
+      float min_y=min(min(p0.y, p1.y), min(p2.y, p3.y)), max_y=max(max(p0.y, p1.y), max(p2.y, p3.y));
+      tiling_.add_cluster(vec2f(0.5f+0.5f*min_x, 0.5f-0.5f*max_y), vec2f(0.5f+0.5f*max_x, 0.5f-0.5f*min_y), z, dispatch_idx_, cluster_idx_);
+    }
+    //----
+
+    PFC_INLINE const void *cluster(rasterizer_local_cluster_index_t cluster_idx_) const
+    {
+      return &scene->clusters[cluster_idx_];
+    }
+    //----
+
+    PFC_INLINE uint8_t num_cluster_vertices(const void*) const
+    {
+      return rbench_cluster_vtx;
+    }
+    //----
+
+    PFC_INLINE uint8_t num_cluster_triangles(const void*) const
+    {
+      return rbench_cluster_tris;
+    }
+    //----
+
+    void tform_cluster(vout *tform_cache_, const void *cluster_) const
+    {
+      const vec3f *vtx=scene->vertices.data()+((const rbench_cluster*)cluster_)->start_vtx;
+      for(unsigned i=0; i<rbench_cluster_vtx; ++i, ++vtx)
+      {
+        vout &vo=tform_cache_[i];
+        vec2f p=tform_xy(vtx->x, vtx->y);
+        vo.pos=vec4f(p.x, p.y, z+vtx->z, 1.0f);
+        vo.col=tint*(0.6f+20.0f*vtx->z);
+      }
+    }
+    //----
+
+    PFC_INLINE void setup_primitive(const vout *vtx_, const void*, uint8_t prim_idx_, uint8_t vidx_[3], vec4f vpos_[3]) const
+    {
+      const uint8_t *pidx=scene->tidx+prim_idx_*3;
+      vidx_[0]=pidx[0];
+      vidx_[1]=pidx[1];
+      vidx_[2]=pidx[2];
+      vpos_[0]=vtx_[vidx_[0]].pos;
+      vpos_[1]=vtx_[vidx_[1]].pos;
+      vpos_[2]=vtx_[vidx_[2]].pos;
+    }
+    //----
+
+    PFC_INLINE void shade_pixel(const rasterizer_render_target *rts_, const vout *vtx_, uint32_t offset_, uint8_t vidx_[3], const vec3f &bc_, uint16_t, uint16_t, uint16_t) const
+    {
+      vec3f col=vtx_[vidx_[0]].col*bc_.x+vtx_[vidx_[1]].col*bc_.y+vtx_[vidx_[2]].col*bc_.z;
+      uint32_t r=uint32_t(min(max(col.x, 0.0f), 1.0f)*255.0f);
+      uint32_t g=uint32_t(min(max(col.y, 0.0f), 1.0f)*255.0f);
+      uint32_t b=uint32_t(min(max(col.z, 0.0f), 1.0f)*255.0f);
+      ((uint32_t*)rts_[0].data)[offset_]=0xff000000|(b<<16)|(g<<8)|r;
+    }
+    //------------------------------------------------------------------------
+
+    const rbench_scene *scene;
+    float cos_angle, sin_angle;
+    vec2f offs;
+    float z;
+    vec3f tint;
+  };
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // rbench_p3g_shader
+  //==========================================================================
+  // Renders the P3G sphere through p3g_shader_base with meshlet culling and
+  // position-based vertex colors. The P3G vertex format is the vertex position.
+  struct rbench_p3g_vtx_decoder
+  {
+    enum {vtx_size=sizeof(vec3f)};
+    typedef rbench_vout vout;
+    //------------------------------------------------------------------------
+
+    PFC_INLINE void tform_vertex(vout &res_, const void *vtx_, const mat44f &o2p_) const
+    {
+      const vec3f &v=*(const vec3f*)vtx_;
+      vec4f p=vec4f(v.x, v.y, v.z, 1.0f)*o2p_;
+      float oow=1.0f/p.w;
+      res_.pos=vec4f(p.x*oow, p.y*oow, p.z*oow, oow);
+      res_.col=vec3f(0.5f+0.5f*v.x, 0.5f+0.5f*v.y, 0.5f+0.5f*v.z);
+    }
+  };
+  //----
+
+  template<e_rasterizer_depth_format DepthFmt>
+  struct rbench_p3g_shader: p3g_shader_base<rbench_p3g_vtx_decoder>
+  {
+    enum {depth_format=DepthFmt};
+    enum {cullmode=rtzr_cullmode_none};
+    //------------------------------------------------------------------------
+
+    void set_frame(const rbench_scene &scene_, unsigned frame_idx_)
+    {
+      // orbit the view around the sphere
+      set_segment(scene_.p3g, 0);
+      float angle=0.3f*frame_idx_;
+      vec3f view_dir=unit(vec3f(-sin(angle), -0.4f, -cos(angle)));
+      tform3f v2o;
+      zrot_u(v2o, -view_dir*3.0f, view_dir);
+      const float proj_y=1.0f/tan(0.5f*(mathf::pi/180.0f)*40.0f), proj_x=proj_y*float(rbench_height)/float(rbench_width);
+      const float near_z=0.5f, far_z=5.0f;
+      mat44f v2p;
+      v2p.x=vec4f(proj_x, 0.0f, 0.0f, 0.0f);
+      v2p.y=vec4f(0.0f, proj_y, 0.0f, 0.0f);
+      v2p.z=vec4f(0.0f, 0.0f, far_z/(far_z-near_z), 1.0f);
+      v2p.w=vec4f(0.0f, 0.0f, -near_z*far_z/(far_z-near_z), 0.0f);
+      set_transform(inv(v2o), v2p);
+    }
+    //----
+
+    PFC_INLINE void shade_pixel(const rasterizer_render_target *rts_, const vout *vtx_, uint32_t offset_, uint8_t vidx_[3], const vec3f &bc_, uint16_t, uint16_t, uint16_t) const
+    {
+      vec3f col=vtx_[vidx_[0]].col*bc_.x+vtx_[vidx_[1]].col*bc_.y+vtx_[vidx_[2]].col*bc_.z;
+      uint32_t r=uint32_t(min(max(col.x, 0.0f), 1.0f)*255.0f);
+      uint32_t g=uint32_t(min(max(col.y, 0.0f), 1.0f)*255.0f);
+      uint32_t b=uint32_t(min(max(col.z, 0.0f), 1.0f)*255.0f);
+      ((uint32_t*)rts_[0].data)[offset_]=0xff000000|(b<<16)|(g<<8)|r;
+    }
+  };
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // rbench_tile_callback
+  //==========================================================================
+  class rbench_tile_callback: public rasterizer_callback_base
+  {
+  public:
+    // construction
+    rbench_tile_callback(uint32_t *frame_, const uint32_t *tile_rt_, rasterizer_tile_size_t tile_width_, rasterizer_tile_size_t tile_height_)
+    {
+      m_frame=frame_;
+      m_tile_rt=tile_rt_;
+      m_tile_width=tile_width_;
+      m_tile_height=tile_height_;
+    }
+    //------------------------------------------------------------------------
+
+  private:
+    virtual void submit_tile(uint8_t tx_, uint8_t ty_, uint16_t, uint16_t, const vec2u16 &reg_min_, const vec2u16 &reg_end_)
+    {
+      copy_tile(m_tile_rt, tx_, ty_, reg_min_, reg_end_);
+    }
+    //----
+
+    virtual void submit_worker_tile(uint8_t, const rasterizer_render_target *rts_, const rasterizer_depth_target&, uint8_t tx_, uint8_t ty_, uint16_t, uint16_t, const vec2u16 &reg_min_, const vec2u16 &reg_end_)
+    {
+      // tiles don't overlap in the frame, so concurrent copies are safe
+      copy_tile((const uint32_t*)rts_[0].data, tx_, ty_, reg_min_, reg_end_);
+    }
+    //----
+
+    void copy_tile(const uint32_t *tile_rt_, uint8_t tx_, uint8_t ty_, const vec2u16 &reg_min_, const vec2u16 &reg_end_)
+    {
+      // copy the updated tile region to the frame
+      const uint32_t *src=tile_rt_+reg_min_.x+reg_min_.y*m_tile_width;
+      uint32_t *dst=m_frame+tx_*m_tile_width+reg_min_.x+(ty_*m_tile_height+reg_min_.y)*rbench_width;
+      usize_t row_size=(reg_end_.x-reg_min_.x)*sizeof(uint32_t);
+      for(uint16_t y=reg_min_.y; y<reg_end_.y; ++y, src+=m_tile_width, dst+=rbench_width)
+        mem_copy(dst, src, row_size);
+    }
+    //------------------------------------------------------------------------
+
+    uint32_t *m_frame;
+    const uint32_t *m_tile_rt;
+    rasterizer_tile_size_t m_tile_width, m_tile_height;
+  };
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // rbench_config
+  //==========================================================================
+  struct rbench_config
+  {
+    rasterizer_tile_size_t tile_size;
+    e_rasterizer_depth_format depth_format;
+    bool hiz;
+    usize_t vcache_size;
+    unsigned num_layers;
+    uint8_t num_workers;
+  };
+  //----
+
+  struct rbench_result
+  {
+    double time;
+    usize_t num_tile_clusters;
+    usize_t num_hiz_culled_tile_clusters;
+    uint64_t checksum;
+  };
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // render_rbench_frames
+  //==========================================================================
+  template<e_rasterizer_depth_format DepthFmt>
+  void render_rbench_frames(rasterizer &rtzr_, const rbench_scene &scene_, unsigned num_layers_, unsigned num_frames_)
+  {
+    for(unsigned frame_idx=0; frame_idx<num_frames_; ++frame_idx)
+    {
+      // render the P3G sphere if there are no layers
+      if(!num_layers_)
+      {
+        rbench_p3g_shader<DepthFmt> sh;
+        sh.set_frame(scene_, frame_idx);
+        rtzr_.dispatch_shader(sh);
+      }
+      for(unsigned layer_idx=0; layer_idx<num_layers_; ++layer_idx)
+      {
+        rbench_shader<DepthFmt> sh;
+        sh.set_layer(scene_, layer_idx, num_layers_);
+        rtzr_.dispatch_shader(sh);
+      }
+      rtzr_.commit();
+    }
+  }
+  //----
+
+  void render_rbench_frames(rasterizer &rtzr_, e_rasterizer_depth_format depth_fmt_, const rbench_scene &scene_, unsigned num_layers_, unsigned num_frames_)
+  {
+    switch(depth_fmt_)
+    {
+      case rtzr_depthfmt_uint8: render_rbench_frames<rtzr_depthfmt_uint8>(rtzr_, scene_, num_layers_, num_frames_); break;
+      case rtzr_depthfmt_uint16: render_rbench_frames<rtzr_depthfmt_uint16>(rtzr_, scene_, num_layers_, num_frames_); break;
+      case rtzr_depthfmt_float32: render_rbench_frames<rtzr_depthfmt_float32>(rtzr_, scene_, num_layers_, num_frames_); break;
+      default: PFC_ERROR("Unsupported depth format\r\n");
+    }
+  }
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // run_rbench_config
+  //==========================================================================
+  void run_rbench_config(rbench_result &res_, const rbench_config &cfg_, const rbench_scene &scene_, unsigned num_frames_)
+  {
+    // allocate tile, binning and vertex cache memory for the config
+    const rasterizer_tile_size_t tile_size=cfg_.tile_size;
+    const usize_t tile_px=usize_t(tile_size)*tile_size;
+    const usize_t depth_px_size=cfg_.depth_format==rtzr_depthfmt_float32?4:cfg_.depth_format==rtzr_depthfmt_uint16?2:1;
+    const usize_t num_tiles=usize_t((rbench_width+tile_size-1)/tile_size)*((rbench_height+tile_size-1)/tile_size);
+    array<usize_t> depth_tile((tile_px*depth_px_size+sizeof(usize_t)-1)/sizeof(usize_t));
+    array<uint16_t> hiz_tile(tile_px/(rasterizer_hiz_tile_size*rasterizer_hiz_tile_size));
+    array<uint32_t> rt_tile(tile_px);
+    array<uint32_t> frame(rbench_width*rbench_height, uint32_t(0));
+    array<rasterizer_dispatch> dispatches(rbench_max_dispatches);
+    array<usize_t> shader_store(rbench_shader_store_size/sizeof(usize_t));
+    array<rasterizer_tile> tiles(num_tiles);
+    array<uint16_t> tile_map(num_tiles);
+    array<rasterizer_cluster> clusters(rbench_max_clusters);
+    array<rasterizer_tile_cluster_strip> cstrips(rbench_max_cluster_strips);
+    array<usize_t> vcache((cfg_.vcache_size+sizeof(usize_t)-1)/sizeof(usize_t));
+    array<rasterizer_vertex_cache_offset_t> vcache_offs(cfg_.vcache_size?rbench_max_clusters:0);
+    array<usize_t> tmp_vout((rbench_cluster_vtx*sizeof(rbench_vout)+sizeof(usize_t)-1)/sizeof(usize_t));
+    rasterizer_render_target rts[]={{rt_tile.data(), sizeof(uint32_t)}};
+
+    // allocate worker tile buffers
+    const usize_t worker_depth_size=depth_tile.size(), worker_hiz_size=hiz_tile.size(), worker_vout_size=tmp_vout.size();
+    array<usize_t> worker_depth_tiles(worker_depth_size*cfg_.num_workers);
+    array<uint16_t> worker_hiz_tiles(worker_hiz_size*cfg_.num_workers);
+    array<uint32_t> worker_rt_tiles(tile_px*cfg_.num_workers);
+    array<usize_t> worker_tmp_vouts(worker_vout_size*cfg_.num_workers);
+    array<rasterizer_render_target> worker_rts(cfg_.num_workers);
+    array<rasterizer_worker> workers(cfg_.num_workers);
+    for(unsigned widx=0; widx<cfg_.num_workers; ++widx)
+    {
+      rasterizer_worker &w=workers[widx];
+      w.depth.data=worker_depth_tiles.data()+widx*worker_depth_size;
+      w.depth.hiz_data=cfg_.hiz?worker_hiz_tiles.data()+widx*worker_hiz_size:0;
+      w.depth.format=cfg_.depth_format;
+      worker_rts[widx].data=worker_rt_tiles.data()+widx*tile_px;
+      worker_rts[widx].px_size=sizeof(uint32_t);
+      w.rts=&worker_rts[widx];
+      w.tmp_cluster_vout=worker_tmp_vouts.data()+widx*worker_vout_size;
+      w.tmp_vout_size=worker_vout_size*sizeof(usize_t);
+    }
+
+    // setup rasterizer
+    rasterizer_cfg rcfg;
+    rcfg.set_dispatches(dispatches.data(), rbench_max_dispatches);
+    rcfg.set_shader_store(shader_store.data(), shader_store.size()*sizeof(usize_t));
+    rcfg.set_depth(depth_tile.data(), cfg_.hiz?hiz_tile.data():0, cfg_.depth_format);
+    rcfg.set_rts(rts, 1);
+    rcfg.set_workers(workers.data(), cfg_.num_workers);
+    rasterizer_tiling_cfg tcfg;
+    tcfg.set_render_target_size(rbench_width, rbench_height);
+    tcfg.set_tiles(tiles.data(), tile_map.data(), tile_size, tile_size);
+    tcfg.set_tile_order(tileorder_morton);
+    tcfg.set_clusters(clusters.data(), rbench_max_clusters);
+    tcfg.set_cluster_strips(cstrips.data(), rbench_max_cluster_strips);
+    rasterizer_vertex_cache_cfg vccfg;
+    vccfg.set_cache(cfg_.vcache_size?vcache.data():0, cfg_.vcache_size);
+    vccfg.set_cluster_vout(tmp_vout.data(), tmp_vout.size()*sizeof(usize_t));
+    vccfg.set_cache_clusters(cfg_.vcache_size?vcache_offs.data():0, cfg_.vcache_size?rbench_max_clusters:0);
+    rbench_tile_callback cb(frame.data(), rt_tile.data(), tile_size, tile_size);
+    rasterizer rtzr;
+    rtzr.init(rcfg, tcfg, vccfg);
+    rtzr.set_callback(&cb);
+
+    // render a warm-up frame and time the rest
+    render_rbench_frames(rtzr, cfg_.depth_format, scene_, cfg_.num_layers, 1);
+    rtzr.reset_stats();
+    std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+    render_rbench_frames(rtzr, cfg_.depth_format, scene_, cfg_.num_layers, num_frames_);
+    res_.time=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    rasterizer_stats stats=rtzr.stats();
+    res_.num_tile_clusters=stats.num_tile_clusters;
+    res_.num_hiz_culled_tile_clusters=stats.num_hiz_culled_tile_clusters;
+
+    // calculate FNV-1a checksum of the final frame
+    uint64_t checksum=0xcbf29ce484222325ull;
+    const uint8_t *p=(const uint8_t*)frame.data(), *p_end=p+frame.size()*sizeof(uint32_t);
+    do
+    {
+      checksum=(checksum^*p)*0x100000001b3ull;
+    } while(++p<p_end);
+    res_.checksum=checksum;
+  }
+  //--------------------------------------------------------------------------
+
+
+  //==========================================================================
+  // check_vcone_culling
+  //==========================================================================
+  unsigned check_vcone_culling()
+  {
+    // place the viewer just inside the edge of the region from where some
+    // point of a unit bounding sphere sees it within the visibility cone, which
+    // is at angle cone_angle+asin(1/dist) from the cone direction
+    static const float s_cone_angles[]={0.0f, 30.0f, 60.0f, 90.0f, 120.0f, 150.0f};
+    static const float s_view_dists[]={1.5f, 4.0f, 100.0f};
+    const vec3f vcone_dir(0.0f, 0.0f, 1.0f);
+    unsigned num_failures=0;
+    for(unsigned ca_idx=0; ca_idx<sizeof(s_cone_angles)/sizeof(*s_cone_angles); ++ca_idx)
+      for(unsigned vd_idx=0; vd_idx<sizeof(s_view_dists)/sizeof(*s_view_dists); ++vd_idx)
+      {
+        const float cone_angle=s_cone_angles[ca_idx]*(mathf::pi/180.0f), dist=s_view_dists[vd_idx];
+        const float view_angle=min(cone_angle+asin(1.0f/dist), mathf::pi)-0.001f;
+        const vec3f to_view(dist*sin(view_angle), 0.0f, dist*cos(view_angle));
+        if(is_vcone_culled(to_view, vcone_dir, cos(cone_angle), 1.0f))
+        {
+          errorf("> Error: Meshlet with %.0f degree visibility cone culled with the viewer at the cone edge at distance %.1f\r\n", s_cone_angles[ca_idx], dist);
+          ++num_failures;
+        }
+      }
+
+    // the viewer opposite of a narrow cone must be culled
+    if(!is_vcone_culled(vec3f(0.0f, 0.0f, -100.0f), vcone_dir, cos(30.0f*(mathf::pi/180.0f)), 1.0f))
+    {
+      errorf("> Error: Meshlet with 30 degree visibility cone not culled with the viewer behind the cone\r\n");
+      ++num_failures;
+    }
+    return num_failures;
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// run_rasterizer_bench
+//============================================================================
+bool pfc::run_rasterizer_bench(heap_str &report_, unsigned num_frames_)
+{
+  // check the meshlet visibility cone culling before the timed runs
+  PFC_ASSERT(num_frames_);
+  if(check_vcone_culling())
+    return false;
+
+  // setup the scene
+  const uint8_t max_workers=uint8_t(min<unsigned>(max<unsigned>(std::thread::hardware_concurrency(), 1)-1, 255));
+  rbench_scene scene;
+  generate_rbench_scene(scene);
+  if(!generate_rbench_p3g(scene))
+    return false;
+  usize_t line_start=report_.size();
+  report_.push_back_format("# meshlete_rasterizer_bench 2\r\n"
+                           "# settings: %ix%i, %i frames, %i clusters/layer, %i tris/cluster, %i p3g meshlets, %i p3g tris, stats=%i, mt=%i\r\n",
+                           rbench_width, rbench_height, num_frames_, rbench_grid_size*rbench_grid_size, rbench_cluster_tris, scene.p3g.num_meshlets(), scene.p3g_num_tris, PFC_BUILDOP_RASTERIZER_STATS, PFC_BUILDOP_RASTERIZER_MT);
+  report_.push_back_format("%-5s %-8s %4s %7s %9s %7s %10s %10s %10s %13s %13s %-16s %s\r\n",
+                           "#tile", "depth", "hiz", "vcache", "scene", "workers", "ms/frame", "mpix/s", "mtris/s", "tile_clusters", "hiz_culled", "checksum", "match");
+  logf("%s", report_.c_str()+line_start);
+
+  // run all config combinations. images must be bit-exact between configs
+  // with the same depth format and scene (overdraw layers or the P3G sphere)
+  unsigned num_mismatches=0;
+  for(unsigned dfmt_idx=0; dfmt_idx<sizeof(s_rbench_depth_formats)/sizeof(*s_rbench_depth_formats); ++dfmt_idx)
+    for(unsigned od_idx=0; od_idx<sizeof(s_rbench_overdraws)/sizeof(*s_rbench_overdraws); ++od_idx)
+    {
+      const e_rasterizer_depth_format depth_fmt=s_rbench_depth_formats[dfmt_idx];
+      const unsigned num_layers=s_rbench_overdraws[od_idx];
+      uint64_t ref_checksum=0;
+      bool has_ref=false;
+      for(unsigned ts_idx=0; ts_idx<sizeof(s_rbench_tile_sizes)/sizeof(*s_rbench_tile_sizes); ++ts_idx)
+        for(unsigned hiz=0; hiz<2; ++hiz)
+          for(unsigned vc_idx=0; vc_idx<sizeof(s_rbench_vcache_sizes)/sizeof(*s_rbench_vcache_sizes); ++vc_idx)
+            for(unsigned wm_idx=0; wm_idx<s_rbench_num_worker_modes; ++wm_idx)
+            {
+              // run the config and check the image against the first config of the group
+              const rasterizer_tile_size_t tile_size=s_rbench_tile_sizes[ts_idx];
+              const usize_t vcache_size=s_rbench_vcache_sizes[vc_idx];
+              rbench_config cfg={tile_size, depth_fmt, hiz!=0, vcache_size, num_layers, uint8_t(wm_idx?max_workers:0)};
+              rbench_result res;
+              run_rbench_config(res, cfg, scene, num_frames_);
+              if(!has_ref)
+              {
+                ref_checksum=res.checksum;
+                has_ref=true;
+              }
+              bool is_match=ref_checksum==res.checksum;
+              num_mismatches+=is_match?0:1;
+
+              // report results
+              double frame_tris=num_layers?double(scene.clusters.size())*rbench_cluster_tris*num_layers:double(scene.p3g_num_tris);
+              line_start=report_.size();
+              report_.push_back_format("%5i %-8s %4i %7zi %9s %7i %10.3f %10.1f %10.2f %13zi %13zi %08x%08x %s\r\n",
+                                       tile_size, s_rbench_depth_format_names[depth_fmt], hiz, vcache_size, s_rbench_scene_names[od_idx], cfg.num_workers,
+                                       res.time*1000.0/num_frames_, double(rbench_width*rbench_height)*num_frames_/res.time*1e-6, frame_tris*num_frames_/res.time*1e-6,
+                                       res.num_tile_clusters, res.num_hiz_culled_tile_clusters,
+                                       uint32_t(res.checksum>>32), uint32_t(res.checksum), is_match?"ok":"MISMATCH");
+              logf("%s", report_.c_str()+line_start);
+            }
+    }
+  if(num_mismatches)
+  {
+    errorf("> Error: %i rasterizer configs produced images differing from the reference config\r\n", num_mismatches);
+    return false;
+  }
+  return true;
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,27 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_RASTERIZER_BENCH_H
+#define PFC_MESHLETE_RASTERIZER_BENCH_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "sxp_src/core/str.h"
+namespace pfc
+{
+
+// new
+bool run_rasterizer_bench(heap_str &report_, unsigned num_frames_);
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
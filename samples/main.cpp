@@ -64,7 +64,11 @@ int main()
   export_cfg_p3g p3g_cfg;
   p3g_cfg.export_meshlet_bvols=true;  // export bounding volumes
   p3g_cfg.export_meshlet_vcones=true; // export visibility cones
+  p3g_cfg.local_vbuf=false; // index global vertex buffer with meshlet vertex indices
+  p3g_cfg.packed_vidx=false; // raw 16/32-bit meshlet vertex indices
+  p3g_cfg.packed_tidx=false; // raw 8-bit meshlet triangle indices
   p3g_cfg.vbuf_align=4; // align vertex buffer data to 4-byte boundary
+  p3g_cfg.log_stats=true; // log p3g data size stats
   export_p3g(s, p3g_cfg, geo, geo_result);
 
   return 0;
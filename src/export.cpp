@@ -7,12 +7,680 @@
 
 #include "export.h"
 #include "mlet_gen.h"
+#include "p3g_decode.h"
 #include "sxp_src/core/math/tform3.h"
 #include "sxp_src/core/streams.h"
+// build config
+#if defined(__x86_64__) || defined(_M_X64)
+#define PFC_BUILDOP_EXPORT_SIMD 1  // SSE2 index narrowing
+#else
+#define PFC_BUILDOP_EXPORT_SIMD 0
+#endif
+#if PFC_BUILDOP_EXPORT_SIMD==1
+#include <emmintrin.h>
+#endif
 using namespace pfc;
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  //==========================================================================
+  // pack_meshlet_vidx
+  //==========================================================================
+  bool pack_meshlet_vidx(array<uint32_t> &res_, const uint32_t *vidx_, uint32_t num_vtx_)
+  {
+    // find base index and bit width of the index deltas
+    uint32_t base=uint32_t(-1), max_vidx=0;
+    for(uint32_t i=0; i<num_vtx_; ++i)
+    {
+      base=min(base, vidx_[i]);
+      max_vidx=max(max_vidx, vidx_[i]);
+    }
+    if(!num_vtx_)
+      base=0;
+    unsigned width=0;
+    while(width<32 && (max_vidx-base)>>width)
+      ++width;
+    if(base>=(1<<27))
+    {
+      errorf("> Error: Packed meshlet vertex base index %i exceeds the 27-bit range\r\n", base);
+      return false;
+    }
+    if(width>31)
+    {
+      errorf("> Error: Packed meshlet vertex index delta width %i exceeds the 5-bit width field\r\n", width);
+      return false;
+    }
+
+    // write the stream header (27-bit base index and 5-bit width) and LSB-first bitpacked deltas
+    res_.push_back(base|(width<<27));
+    if(!width)
+      return true;
+    usize_t start=res_.size();
+    res_.insert_back((num_vtx_*width+31)/32, uint32_t(0));
+    uint32_t *words=res_.data()+start;
+    for(uint32_t i=0, bit_pos=0; i<num_vtx_; ++i, bit_pos+=width)
+    {
+      uint64_t bits=uint64_t(vidx_[i]-base)<<(bit_pos&31);
+      words[bit_pos>>5]|=uint32_t(bits);
+      if((bit_pos&31)+width>32)
+        words[(bit_pos>>5)+1]|=uint32_t(bits>>32);
+    }
+    return true;
+  }
+  //----
+
+  //==========================================================================
+  // pack_meshlet_tidx
+  //==========================================================================
+  void pack_meshlet_tidx(array<uint8_t> &res_, const uint8_t *tidx_, uint32_t num_idx_, uint32_t num_vtx_)
+  {
+    // write LSB-first bitpacked triangle indices with the minimal width for the meshlet vertex count
+    const unsigned width=p3g_packed_tidx_width(num_vtx_);
+    if(!width)
+      return;
+    usize_t start=res_.size();
+    res_.insert_back((num_idx_*width+7)/8, uint8_t(0));
+    uint8_t *bytes=res_.data()+start;
+    for(uint32_t i=0, bit_pos=0; i<num_idx_; ++i, bit_pos+=width)
+    {
+      uint32_t bits=uint32_t(tidx_[i])<<(bit_pos&7);
+      bytes[bit_pos>>3]|=uint8_t(bits);
+      if((bit_pos&7)+width>8)
+        bytes[(bit_pos>>3)+1]|=uint8_t(bits>>8);
+    }
+  }
+  //----
+
+  //==========================================================================
+  // narrow_vidx_u16
+  //==========================================================================
+  void narrow_vidx_u16(uint16_t *res_, const uint32_t *vidx_, usize_t num_vidx_)
+  {
+    usize_t i=0;
+#if PFC_BUILDOP_EXPORT_SIMD==1
+    // bias indices to the signed 16-bit range for the saturating pack and remove the bias
+    const __m128i bias32=_mm_set1_epi32(0x8000), bias16=_mm_set1_epi16(short(0x8000));
+    for(; i+8<=num_vidx_; i+=8)
+    {
+      __m128i v0=_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(vidx_+i)), bias32);
+      __m128i v1=_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(vidx_+i+4)), bias32);
+      _mm_storeu_si128((__m128i*)(res_+i), _mm_xor_si128(_mm_packs_epi32(v0, v1), bias16));
+    }
+#endif
+    for(; i<num_vidx_; ++i)
+      res_[i]=uint16_t(vidx_[i]);
+  }
+  //----
+
+  //==========================================================================
+  // staging_writer
+  //==========================================================================
+  // writes P3G data fields to a pre-sized staging buffer (little-endian host)
+  struct staging_writer
+  {
+    template<typename T> PFC_INLINE staging_writer &operator<<(T v_)
+    {
+      mem_copy(ptr, &v_, sizeof(v_));
+      ptr+=sizeof(v_);
+      return *this;
+    }
+    //----
+
+    PFC_INLINE void write_bytes(const void *data_, usize_t size_)
+    {
+      mem_copy(ptr, data_, size_);
+      ptr+=size_;
+    }
+    //------------------------------------------------------------------------
+
+    uint8_t *ptr;
+  };
+  //----
+
+  //==========================================================================
+  // chunked_text_writer
+  //==========================================================================
+  // formats text to a chunk buffer which is flushed to the output stream when
+  // full. Floats are written with fixed 6 fractional digits (trailing zeros
+  // trimmed), which is adequate for debug visualization.
+  class chunked_text_writer
+  {
+  public:
+    // construction
+    chunked_text_writer(bin_output_stream_base &fout_)
+      :m_fout(fout_)
+      ,m_size(0)
+    {
+      m_chunk.resize(chunk_size);
+    }
+    //----
+
+    ~chunked_text_writer()
+    {
+      flush();
+    }
+    //----
+
+    void flush()
+    {
+      m_fout.write_bytes(m_chunk.data(), m_size);
+      m_size=0;
+    }
+    //------------------------------------------------------------------------
+
+    // text output
+    chunked_text_writer &operator<<(const char *str_)
+    {
+      usize_t size=str_size(str_);
+      while(m_size+size>chunk_size)
+      {
+        usize_t num_chars=chunk_size-m_size;
+        mem_copy(m_chunk.data()+m_size, str_, num_chars);
+        m_size=chunk_size;
+        flush();
+        str_+=num_chars;
+        size-=num_chars;
+      }
+      mem_copy(m_chunk.data()+m_size, str_, size);
+      m_size+=size;
+      return *this;
+    }
+    //----
+
+    PFC_INLINE chunked_text_writer &operator<<(char c_)
+    {
+      *reserve(1)=c_;
+      ++m_size;
+      return *this;
+    }
+    //----
+
+    PFC_INLINE chunked_text_writer &operator<<(uint32_t v_)
+    {
+      return *this<<uint64_t(v_);
+    }
+    //----
+
+    chunked_text_writer &operator<<(uint64_t v_)
+    {
+      // write digits backwards to a temp buffer
+      char digits[20], *d=digits+20;
+      do
+      {
+        *--d=char('0'+v_%10);
+        v_/=10;
+      } while(v_);
+      usize_t num_digits=usize_t(digits+20-d);
+      mem_copy(reserve(num_digits), d, num_digits);
+      m_size+=num_digits;
+      return *this;
+    }
+    //----
+
+    chunked_text_writer &operator<<(float v_)
+    {
+      // use generic formatting for values out of the fixed-point range
+      double av=v_<0.0f?-double(v_):double(v_);
+      if(!(av<1.0e9))
+      {
+        stack_str32 s;
+        s.format("%g", v_);
+        return *this<<s.c_str();
+      }
+
+      // write sign, integer part and trimmed 6-digit fraction
+      uint64_t fixed=uint64_t(av*1.0e6+0.5);
+      if(v_<0.0f && fixed)
+        *this<<'-';
+      *this<<uint64_t(fixed/1000000);
+      uint32_t frac=uint32_t(fixed%1000000);
+      if(frac)
+      {
+        char *p=reserve(7);
+        *p++='.';
+        unsigned num_frac_digits=6;
+        while(!(frac%10))
+        {
+          frac/=10;
+          --num_frac_digits;
+        }
+        for(unsigned i=num_frac_digits; i--;)
+        {
+          p[i]=char('0'+frac%10);
+          frac/=10;
+        }
+        m_size+=1+num_frac_digits;
+      }
+      return *this;
+    }
+    //------------------------------------------------------------------------
+
+  private:
+    chunked_text_writer(const chunked_text_writer&); // not implemented
+    void operator=(const chunked_text_writer&); // not implemented
+    PFC_INLINE char *reserve(usize_t size_)
+    {
+      if(m_size+size_>chunk_size)
+        flush();
+      return m_chunk.data()+m_size;
+    }
+    //------------------------------------------------------------------------
+
+    enum {chunk_size=64*1024};
+    bin_output_stream_base &m_fout;
+    array<char> m_chunk;
+    usize_t m_size;
+  };
+  //----
+
+  //==========================================================================
+  // debug meshes
+  //==========================================================================
+  // unit sphere
+  enum {sphere_num_vtx=114, sphere_num_tris=224};
+  static const float s_sphere_vtx_pos[sphere_num_vtx*3]=
+  {
+    0.0f, 0.7071068f, 0.7071068f, 0.0f, 0.9238795f, 0.3826834f, 0.0f, 0.9238795f, -0.3826835f, 0.0f, 0.3826835f, -0.9238795f,
+    0.1464465f, 0.3535534f, 0.9238795f, 0.270598f, 0.6532815f, 0.7071068f, 0.3535534f, 0.8535534f, 0.3826834f, 0.3826834f, 0.9238795f, 0.0f,
+    0.3535534f, 0.8535534f, -0.3826835f, 0.270598f, 0.6532815f, -0.7071068f, 0.1464465f, 0.3535534f, -0.9238795f, 0.2705979f, 0.2705981f, 0.9238795f,
+    0.4999999f, 0.5f, 0.7071068f, 0.6532814f, 0.6532815f, 0.3826834f, 0.7071067f, 0.7071068f, 0.0f, 0.6532814f, 0.6532815f, -0.3826835f,
+    0.4999999f, 0.5f, -0.7071068f, 0.270598f, 0.2705981f, -0.9238795f, 0.3535532f, 0.1464467f, 0.9238795f, 0.6532813f, 0.2705981f, 0.7071068f,
+    0.8535532f, 0.3535534f, 0.3826834f, 0.9238794f, 0.3826834f, 0.0f, 0.8535532f, 0.3535534f, -0.3826835f, 0.6532813f, 0.2705981f, -0.7071068f,
+    0.3535533f, 0.1464466f, -0.9238795f, 0.3826833f, 1.30703e-7f, 0.9238795f, 0.7071065f, 0.0f, 0.7071068f, 0.9238793f, 0.0f, 0.3826834f,
+    0.9999998f, 0.0f, 0.0f, 0.9238793f, 0.0f, -0.3826835f, 0.7071065f, 0.0f, -0.7071068f, 0.3826833f, 0.0f, -0.9238795f,
+    0.3535532f, -0.1464464f, 0.9238795f, 0.6532812f, -0.2705979f, 0.7071068f, 0.8535531f, -0.3535533f, 0.3826834f, 0.9238792f, -0.3826833f, 0.0f,
+    0.8535531f, -0.3535533f, -0.3826835f, 0.6532812f, -0.2705979f, -0.7071068f, 0.3535532f, -0.1464465f, -0.9238795f, 0.2705979f, -0.2705978f, 0.9238795f,
+    0.4999997f, -0.4999998f, 0.7071068f, 0.6532812f, -0.6532813f, 0.3826834f, 0.7071064f, -0.7071066f, 0.0f, 0.6532812f, -0.6532813f, -0.3826835f,
+    0.4999997f, -0.4999998f, -0.7071068f, 0.2705978f, -0.2705979f, -0.9238795f, 0.1464465f, -0.3535531f, 0.9238795f, 0.2705977f, -0.6532812f, 0.7071068f,
+    0.3535531f, -0.8535531f, 0.3826834f, 0.382683f, -0.9238792f, 0.0f, 0.3535531f, -0.8535531f, -0.3826835f, 0.2705977f, -0.6532812f, -0.7071068f,
+    0.1464464f, -0.3535531f, -0.9238795f, 0.0f, -0.3826831f, 0.9238795f, -2.664e-7f, -0.7071064f, 0.7071068f, -2.96202e-7f, -0.9238792f, 0.3826834f,
+    -3.26005e-7f, -0.9999995f, 0.0f, -2.96202e-7f, -0.9238792f, -0.3826835f, -2.664e-7f, -0.7071064f, -0.7071068f, -1.62092e-7f, -0.3826831f, -0.9238795f,
+    -0.1464466f, -0.3535531f, 0.9238795f, -0.2705982f, -0.653281f, 0.7071068f, -0.3535536f, -0.8535529f, 0.3826834f, -0.3826836f, -0.923879f, 0.0f,
+    -0.3535536f, -0.8535529f, -0.3826835f, -0.2705982f, -0.653281f, -0.7071068f, -0.1464467f, -0.353553f, -0.9238795f, -0.270598f, -0.2705977f, 0.9238795f,
+    -0.5f, -0.4999994f, 0.7071068f, -0.6532815f, -0.6532809f, 0.3826834f, -0.7071068f, -0.7071061f, 0.0f, -0.6532815f, -0.6532809f, -0.3826835f,
+    -0.5f, -0.4999994f, -0.7071068f, -0.2705981f, -0.2705976f, -0.9238795f, -0.3535532f, -0.1464463f, 0.9238795f, -0.6532813f, -0.2705975f, 0.7071068f,
+    -0.8535532f, -0.3535528f, 0.3826834f, -0.9238794f, -0.3826828f, 0.0f, -0.8535532f, -0.3535528f, -0.3826835f, -0.6532813f, -0.2705975f, -0.7071068f,
+    -0.3535533f, -0.1464462f, -0.9238795f, -0.3826832f, 2.49912e-7f, 0.9238795f, -0.7071065f, 4.88331e-7f, 0.7071068f, -0.9238792f, 5.18133e-7f, 0.3826834f,
+    -0.9999997f, 6.0754e-7f, 0.0f, -0.9238792f, 5.18133e-7f, -0.3826835f, -0.7071065f, 4.88331e-7f, -0.7071068f, -0.3826832f, 3.39319e-7f, -0.9238795f,
+    -0.3535532f, 0.1464468f, 0.9238795f, -0.653281f, 0.2705984f, 0.7071068f, -0.8535529f, 0.3535538f, 0.3826834f, -0.923879f, 0.3826839f, 0.0f,
+    -0.8535529f, 0.3535538f, -0.3826835f, -0.653281f, 0.2705984f, -0.7071068f, -0.3535531f, 0.1464468f, -0.9238795f, -0.2705978f, 0.2705981f, 0.9238795f,
+    -0.4999995f, 0.5000001f, 0.7071068f, -0.6532809f, 0.6532817f, 0.3826834f, -0.7071061f, 0.707107f, 0.0f, -0.6532809f, 0.6532817f, -0.3826835f,
+    -0.4999995f, 0.5000001f, -0.7071068f, -0.2705978f, 0.2705982f, -0.9238795f, -0.1464464f, 0.3535534f, 0.9238795f, -0.2705975f, 0.6532814f, 0.7071068f,
+    -0.3535528f, 0.8535533f, 0.3826834f, -0.3826827f, 0.9238795f, 0.0f, -0.3535528f, 0.8535533f, -0.3826835f, -0.2705975f, 0.6532814f, -0.7071068f,
+    -0.1464463f, 0.3535534f, -0.9238795f, 0.0f, 0.0f, 1.0f, 0.0f, 0.3826833f, 0.9238795f, 6.57472e-7f, 0.9999997f, 0.0f,
+    4.33955e-7f, 0.7071065f, -0.7071068f, 0.0f, 1.50996e-7f, -1.0f
+  };
+  static const uint8_t s_sphere_tidx[sphere_num_tris*3]=
+  {
+    0, 6, 1, 110, 109, 4, 113, 3, 10, 112, 8, 9, 111, 6, 7, 110, 5, 0, 112, 10, 3, 111, 8, 2,
+    8, 16, 9, 6, 14, 7, 4, 12, 5, 10, 16, 17, 7, 15, 8, 5, 13, 6, 4, 109, 11, 113, 10, 17,
+    17, 23, 24, 14, 22, 15, 12, 20, 13, 11, 109, 18, 113, 17, 24, 15, 23, 16, 13, 21, 14, 11, 19, 12,
+    22, 28, 29, 20, 26, 27, 18, 109, 25, 113, 24, 31, 22, 30, 23, 20, 28, 21, 18, 26, 19, 24, 30, 31,
+    113, 31, 38, 29, 37, 30, 27, 35, 28, 25, 33, 26, 31, 37, 38, 29, 35, 36, 26, 34, 27, 25, 109, 32,
+    34, 42, 35, 33, 39, 40, 38, 44, 45, 35, 43, 36, 33, 41, 34, 32, 109, 39, 113, 38, 45, 36, 44, 37,
+    44, 52, 45, 42, 50, 43, 40, 48, 41, 39, 109, 46, 113, 45, 52, 44, 50, 51, 41, 49, 42, 40, 46, 47,
+    47, 55, 48, 46, 109, 53, 113, 52, 59, 51, 57, 58, 48, 56, 49, 47, 53, 54, 51, 59, 52, 49, 57, 50,
+    113, 59, 66, 58, 64, 65, 55, 63, 56, 54, 60, 61, 58, 66, 59, 56, 64, 57, 54, 62, 55, 53, 109, 60,
+    61, 67, 68, 66, 72, 73, 64, 70, 71, 61, 69, 62, 60, 109, 67, 113, 66, 73, 65, 71, 72, 62, 70, 63,
+    72, 80, 73, 70, 78, 71, 68, 76, 69, 67, 109, 74, 113, 73, 80, 72, 78, 79, 70, 76, 77, 68, 74, 75,
+    74, 109, 81, 113, 80, 87, 79, 85, 86, 77, 83, 84, 75, 81, 82, 79, 87, 80, 77, 85, 78, 75, 83, 76,
+    86, 92, 93, 84, 90, 91, 82, 88, 89, 87, 93, 94, 84, 92, 85, 82, 90, 83, 81, 109, 88, 113, 87, 94,
+    94, 100, 101, 91, 99, 92, 89, 97, 90, 88, 109, 95, 113, 94, 101, 93, 99, 100, 91, 97, 98, 89, 95, 96,
+    98, 106, 99, 96, 104, 97, 95, 109, 102, 113, 101, 108, 100, 106, 107, 98, 104, 105, 96, 102, 103, 101, 107, 108,
+    113, 108, 3, 107, 2, 112, 105, 1, 111, 103, 110, 0, 107, 3, 108, 105, 2, 106, 104, 0, 1, 102, 109, 110,
+    0, 5, 6, 112, 2, 8, 111, 1, 6, 110, 4, 5, 112, 9, 10, 111, 7, 8, 8, 15, 16, 6, 13, 14,
+    4, 11, 12, 10, 9, 16, 7, 14, 15, 5, 12, 13, 17, 16, 23, 14, 21, 22, 12, 19, 20, 15, 22, 23,
+    13, 20, 21, 11, 18, 19, 22, 21, 28, 20, 19, 26, 22, 29, 30, 20, 27, 28, 18, 25, 26, 24, 23, 30,
+    29, 36, 37, 27, 34, 35, 25, 32, 33, 31, 30, 37, 29, 28, 35, 26, 33, 34, 34, 41, 42, 33, 32, 39,
+    38, 37, 44, 35, 42, 43, 33, 40, 41, 36, 43, 44, 44, 51, 52, 42, 49, 50, 40, 47, 48, 44, 43, 50,
+    41, 48, 49, 40, 39, 46, 47, 54, 55, 51, 50, 57, 48, 55, 56, 47, 46, 53, 51, 58, 59, 49, 56, 57,
+    58, 57, 64, 55, 62, 63, 54, 53, 60, 58, 65, 66, 56, 63, 64, 54, 61, 62, 61, 60, 67, 66, 65, 72,
+    64, 63, 70, 61, 68, 69, 65, 64, 71, 62, 69, 70, 72, 79, 80, 70, 77, 78, 68, 75, 76, 72, 71, 78,
+    70, 69, 76, 68, 67, 74, 79, 78, 85, 77, 76, 83, 75, 74, 81, 79, 86, 87, 77, 84, 85, 75, 82, 83,
+    86, 85, 92, 84, 83, 90, 82, 81, 88, 87, 86, 93, 84, 91, 92, 82, 89, 90, 94, 93, 100, 91, 98, 99,
+    89, 96, 97, 93, 92, 99, 91, 90, 97, 89, 88, 95, 98, 105, 106, 96, 103, 104, 100, 99, 106, 98, 97, 104,
+    96, 95, 102, 101, 100, 107, 107, 106, 2, 105, 104, 1, 103, 102, 110, 107, 112, 3, 105, 111, 2, 104, 103, 0
+  };
+  //----
+
+  // cone with the apex at the origin and unit radius base at z=1
+  enum {cone_num_vtx=33, cone_num_tris=62};
+  static const float s_cone_vtx_pos[cone_num_vtx*3]=
+  {
+    0.0f, -0.9999994f, 1.0f, 0.1950903f, -0.9807847f, 1.0f, 0.3826835f, -0.9238789f, 1.0f, 0.5555703f, -0.831469f, 1.0f,
+    0.7071068f, -0.7071062f, 1.0f, 0.8314697f, -0.5555696f, 1.0f, 0.9238795f, -0.3826829f, 1.0f, 0.9807853f, -0.1950898f, 1.0f,
+    1.0f, 4.74551e-7f, 1.0f, 0.9807853f, 0.1950907f, 1.0f, 0.9238796f, 0.3826838f, 1.0f, 0.8314697f, 0.5555708f, 1.0f,
+    0.7071068f, 0.7071074f, 1.0f, 0.5555702f, 0.8314703f, 1.0f, 0.3826833f, 0.9238802f, 1.0f, 0.1950901f, 0.9807859f, 1.0f,
+    -3.25841e-7f, 1.0f, 1.0f, -0.1950907f, 0.9807858f, 1.0f, -0.3826839f, 0.9238799f, 1.0f, -0.5555707f, 0.8314699f, 1.0f,
+    -0.7071073f, 0.707107f, 1.0f, -0.83147f, 0.5555703f, 1.0f, -0.9238799f, 0.3826832f, 1.0f, 0.0f, 6.37471e-7f, 0.0f,
+    -0.9807854f, 0.19509f, 1.0f, -1.0f, -4.15551e-7f, 1.0f, -0.9807851f, -0.1950908f, 1.0f, -0.9238791f, -0.3826839f, 1.0f,
+    -0.8314689f, -0.5555707f, 1.0f, -0.7071059f, -0.7071071f, 1.0f, -0.5555691f, -0.8314698f, 1.0f, -0.3826821f, -0.9238795f, 1.0f,
+    -0.1950888f, -0.980785f, 1.0f
+  };
+  static const uint8_t s_cone_tidx[cone_num_tris*3]=
+  {
+    0, 23, 1, 1, 23, 2, 2, 23, 3, 3, 23, 4, 4, 23, 5, 5, 23, 6, 6, 23, 7, 7, 23, 8,
+    8, 23, 9, 9, 23, 10, 10, 23, 11, 11, 23, 12, 12, 23, 13, 13, 23, 14, 14, 23, 15, 15, 23, 16,
+    16, 23, 17, 17, 23, 18, 18, 23, 19, 19, 23, 20, 20, 23, 21, 21, 23, 22, 22, 23, 24, 24, 23, 25,
+    25, 23, 26, 26, 23, 27, 27, 23, 28, 28, 23, 29, 29, 23, 30, 30, 23, 31, 31, 23, 32, 32, 23, 0,
+    7, 15, 24, 32, 0, 1, 1, 2, 3, 3, 4, 7, 4, 5, 7, 5, 6, 7, 7, 8, 9, 9, 10, 7,
+    10, 11, 7, 11, 12, 15, 12, 13, 15, 13, 14, 15, 15, 16, 17, 17, 18, 19, 19, 20, 21, 21, 22, 24,
+    24, 25, 26, 26, 27, 28, 28, 29, 32, 29, 30, 32, 30, 31, 32, 32, 1, 3, 15, 17, 24, 17, 19, 24,
+    19, 21, 24, 24, 26, 32, 26, 28, 32, 32, 3, 7, 7, 11, 15, 32, 7, 24
+  };
+  //----
+
+  //==========================================================================
+  // for_each_meshlet_triangle
+  //==========================================================================
+  // calls func_(tidx0, tidx1, tidx2) with meshlet-local vertex indices of each
+  // non-degenerate meshlet triangle of a triangle list or strip (with
+  // alternating winding fixed and restarts skipped)
+  template<class Func>
+  void for_each_meshlet_triangle(const uint8_t *tidx_, uint32_t num_idx_, bool is_stripified_, Func func_)
+  {
+    const uint8_t *tidx=tidx_, *tidx_end=tidx_+num_idx_;
+    if(!is_stripified_)
+    {
+      for(; tidx<tidx_end; tidx+=3)
+        func_(tidx[0], tidx[1], tidx[2]);
+      return;
+    }
+    tidx_end-=2;
+    uint8_t parity=0;
+    while(tidx<tidx_end)
+    {
+      if(!p3g_meshlet_tristrip_restart || tidx[2]!=p3g_meshlet_tristrip_restart)
+      {
+        if(tidx[0]!=tidx[1] && tidx[0]!=tidx[2] && tidx[1]!=tidx[2])
+          func_(parity?tidx[0]:tidx[1], parity?tidx[1]:tidx[0], tidx[2]);
+        ++tidx;
+        parity^=1;
+      }
+      else
+      {
+        parity=0;
+        tidx+=3;
+      }
+    }
+  }
+  //----
+
+  //==========================================================================
+  // vcone_instance
+  //==========================================================================
+  // placement of the debug cone mesh (apex at the origin, base at z=1)
+  // visualizing a meshlet visibility cone (green=positive, red=negative space)
+  struct vcone_instance
+  {
+    vec3f pos;
+    vec3f dir;  // cone mesh +z direction
+    vec3f scale;
+    bool positive_space;
+  };
+  //----
+
+  void setup_vcone_instance(vcone_instance &res_, const p3g_meshlet &mlet_, const sphere3f &bvol_)
+  {
+    // scale the cone to the cone angle and place it next to the bounding sphere center
+    vec3f vcone_dir;
+    float vcone_dot;
+    dequantize_meshlet_vcone(vcone_dir, vcone_dot, mlet_.qvcone_dir, mlet_.qvcone_dot);
+    res_.positive_space=vcone_dot>=0.0f;
+    float cone_angle=acos(abs(vcone_dot));
+    float xyscale=1.0f, zscale=1.0f;
+    if(cone_angle<mathf::pi*0.25f)
+      xyscale=tan(cone_angle);
+    else
+      zscale=cot(cone_angle);
+    float scale=0.5f*bvol_.rad;
+    res_.pos=bvol_.pos+max(zscale, 0.25f)*bvol_.rad*vcone_dir;
+    res_.dir=res_.positive_space?vcone_dir:-vcone_dir;
+    res_.scale=vec3f(xyscale*scale, xyscale*scale, zscale*scale);
+  }
+  //----
+
+  //==========================================================================
+  // dae_instance
+  //==========================================================================
+  struct dae_instance
+  {
+    tform3f o2w;
+    uint32_t mlet_idx;
+  };
+  //----
+
+  //==========================================================================
+  // write_dae_geometry
+  //==========================================================================
+  // writes Collada geometry "<name_>-mesh" of the template mesh triangles
+  // repeated for num_insts_ instances of num_inst_vtx_ vertices in vtx_pos_,
+  // with optional constant RGBA color (e.g. "1 0 0 1")
+  void write_dae_geometry(chunked_text_writer &tw_, const char *name_, const float *vtx_pos_, uint32_t num_inst_vtx_, const uint8_t *tidx_, uint32_t num_inst_tris_, uint32_t num_insts_, const char *color_)
+  {
+    // write vertex positions
+    uint32_t num_vtx=num_inst_vtx_*num_insts_;
+    tw_<<R"(    <geometry id=")"<<name_<<R"(-mesh" name=")"<<name_<<R"(">)""\r\n"
+         R"(      <mesh>)""\r\n"
+         R"(        <source id=")"<<name_<<R"(-mesh-positions">)""\r\n"
+         R"(          <float_array id=")"<<name_<<R"(-mesh-positions-array" count=")"<<num_vtx*3<<"\">";
+    for(uint32_t i=0; i<num_vtx*3; ++i)
+      tw_<<vtx_pos_[i]<<' ';
+    tw_<<R"(</float_array>)""\r\n"
+         R"(          <technique_common>)""\r\n"
+         R"(            <accessor source="#)"<<name_<<R"(-mesh-positions-array" count=")"<<num_vtx<<R"(" stride="3">)""\r\n"
+         R"(              <param name="X" type="float"/><param name="Y" type="float"/><param name="Z" type="float"/>)""\r\n"
+         R"(            </accessor>)""\r\n"
+         R"(          </technique_common>)""\r\n"
+         R"(        </source>)""\r\n";
+
+    // write constant color
+    if(color_)
+      tw_<<R"(        <source id=")"<<name_<<R"(-mesh-colors-Col" name="Col">)""\r\n"
+           R"(          <float_array id=")"<<name_<<R"(-mesh-colors-Col-array" count="4">)"<<color_<<R"(</float_array>)""\r\n"
+           R"(          <technique_common>)""\r\n"
+           R"(            <accessor source="#)"<<name_<<R"(-mesh-colors-Col-array" count="1" stride="4">)""\r\n"
+           R"(              <param name="R" type="float"/><param name="G" type="float"/><param name="B" type="float"/><param name="A" type="float"/>)""\r\n"
+           R"(            </accessor>)""\r\n"
+           R"(          </technique_common>)""\r\n"
+           R"(        </source>)""\r\n";
+
+    // write triangles of all instances
+    tw_<<R"(        <vertices id=")"<<name_<<R"(-mesh-vertices">)""\r\n"
+         R"(          <input semantic="POSITION" source="#)"<<name_<<R"(-mesh-positions"/>)""\r\n"
+         R"(        </vertices>)""\r\n"
+         R"(        <triangles count=")"<<num_inst_tris_*num_insts_<<R"(">)""\r\n"
+         R"(          <input semantic="VERTEX" source="#)"<<name_<<R"(-mesh-vertices" offset="0"/>)""\r\n";
+    if(color_)
+      tw_<<R"(          <input semantic="COLOR" source="#)"<<name_<<R"(-mesh-colors-Col" offset="1" set="0"/>)""\r\n";
+    tw_<<R"(          <p>)";
+    for(uint32_t inst_idx=0; inst_idx<num_insts_; ++inst_idx)
+    {
+      uint32_t base_vidx=inst_idx*num_inst_vtx_;
+      for(uint32_t i=0; i<num_inst_tris_*3; ++i)
+      {
+        tw_<<base_vidx+tidx_[i]<<' ';
+        if(color_)
+          tw_<<"0 ";
+      }
+    }
+    tw_<<R"(</p>)""\r\n"
+         R"(        </triangles>)""\r\n"
+         R"(      </mesh>)""\r\n"
+         R"(    </geometry>)""\r\n";
+  }
+  //----
+
+  void write_dae_baked_geometry(chunked_text_writer &tw_, const char *name_, const float *vtx_pos_, uint32_t num_inst_vtx_, const uint8_t *tidx_, uint32_t num_inst_tris_, const array<dae_instance> &insts_, const char *color_)
+  {
+    // transform template mesh vertices to all instances and write as a single mesh
+    uint32_t num_insts=(uint32_t)insts_.size();
+    array<float> vtx_pos(usize_t(num_insts)*num_inst_vtx_*3);
+    float *pos=vtx_pos.data();
+    for(uint32_t inst_idx=0; inst_idx<num_insts; ++inst_idx)
+    {
+      const tform3f &o2w=insts_[inst_idx].o2w;
+      for(uint32_t i=0; i<num_inst_vtx_; ++i)
+      {
+        vec3f v=vec3f(vtx_pos_[i*3+0], vtx_pos_[i*3+1], vtx_pos_[i*3+2])*o2w;
+        *pos++=v.x;
+        *pos++=v.y;
+        *pos++=v.z;
+      }
+    }
+    write_dae_geometry(tw_, name_, vtx_pos.data(), num_inst_vtx_, tidx_, num_inst_tris_, num_insts, color_);
+  }
+  //----
+
+  void write_dae_instance_nodes(chunked_text_writer &tw_, const char *node_prefix_, const char *geo_name_, const array<dae_instance> &insts_)
+  {
+    // write scene node with the instance transform for each instance
+    for(const dae_instance &inst:insts_)
+    {
+      stack_str32 node_name;
+      node_name.format("%s-%i", node_prefix_, inst.mlet_idx);
+      tw_<<R"(      <node id=")"<<node_name.c_str()<<R"(" name=")"<<node_name.c_str()<<R"(" type="NODE"><matrix sid="transform">)";
+      mat44f o2w=inst.o2w.matrix44();
+      transpose(o2w);
+      for(unsigned m=0; m<4; ++m)
+        for(unsigned n=0; n<4; ++n)
+          tw_<<o2w[m][n]<<' ';
+      tw_<<R"(</matrix><instance_geometry url="#)"<<geo_name_<<R"(-mesh" name=")"<<node_name.c_str()<<R"("/></node>)""\r\n";
+    }
+  }
+  //----
+
+  void write_dae_node(chunked_text_writer &tw_, const char *name_)
+  {
+    tw_<<R"(      <node id=")"<<name_<<R"(" name=")"<<name_<<R"(" type="NODE">)""\r\n"
+         R"(        <matrix sid="transform">1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1</matrix>)""\r\n"
+         R"(        <instance_geometry url="#)"<<name_<<R"(-mesh" name=")"<<name_<<R"("/>)""\r\n"
+         R"(      </node>)""\r\n";
+  }
+  //----
+
+  //==========================================================================
+  // glb_builder
+  //==========================================================================
+  // collects the GLB binary buffer with the glTF buffer view and accessor JSON
+  enum e_gltf_type
+  {
+    gltftype_ubyte  = 5121,
+    gltftype_ushort = 5123,
+    gltftype_uint   = 5125,
+    gltftype_float  = 5126,
+  };
+  enum {gltf_target_vertices=34962, gltf_target_indices=34963};
+  //----
+
+  struct glb_builder
+  {
+    // construction
+    glb_builder()
+    {
+      num_views=0;
+      num_accessors=0;
+    }
+    //------------------------------------------------------------------------
+
+    unsigned add_view(const void *data_, usize_t size_, unsigned target_)
+    {
+      // append 4-byte aligned data to the binary buffer
+      usize_t offs=bin.size();
+      bin.insert_back((size_+3)&~usize_t(3), uint8_t(0));
+      mem_copy(bin.data()+offs, data_, size_);
+      views_json.push_back_format("%s{\"buffer\":0,\"byteOffset\":%zi,\"byteLength\":%zi", num_views?",":"", offs, size_);
+      if(target_)
+        views_json.push_back_format(",\"target\":%i", target_);
+      views_json+="}";
+      return num_views++;
+    }
+    //----
+
+    unsigned add_accessor(unsigned view_, e_gltf_type comp_type_, usize_t count_, const char *type_, bool normalized_=false, const vec3f *min_=0, const vec3f *max_=0)
+    {
+      accessors_json.push_back_format("%s{\"bufferView\":%i,\"componentType\":%i,\"count\":%zi,\"type\":\"%s\"", num_accessors?",":"", view_, comp_type_, count_, type_);
+      if(normalized_)
+        accessors_json+=",\"normalized\":true";
+      if(min_ && max_)
+        accessors_json.push_back_format(",\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]", min_->x, min_->y, min_->z, max_->x, max_->y, max_->z);
+      accessors_json+="}";
+      return num_accessors++;
+    }
+    //----
+
+    unsigned add_vec3_accessor(const vec3f *v_, usize_t count_, unsigned target_, bool bounds_)
+    {
+      // add float vec3 data with optional min/max bounds (required for positions)
+      unsigned view=add_view(v_, count_*sizeof(vec3f), target_);
+      if(!bounds_ || !count_)
+        return add_accessor(view, gltftype_float, count_, "VEC3");
+      vec3f vmin=v_[0], vmax=v_[0];
+      for(usize_t i=1; i<count_; ++i)
+      {
+        vmin.x=min(vmin.x, v_[i].x); vmin.y=min(vmin.y, v_[i].y); vmin.z=min(vmin.z, v_[i].z);
+        vmax.x=max(vmax.x, v_[i].x); vmax.y=max(vmax.y, v_[i].y); vmax.z=max(vmax.z, v_[i].z);
+      }
+      return add_accessor(view, gltftype_float, count_, "VEC3", false, &vmin, &vmax);
+    }
+    //------------------------------------------------------------------------
+
+    array<uint8_t> bin;
+    heap_str views_json;
+    heap_str accessors_json;
+    unsigned num_views;
+    unsigned num_accessors;
+  };
+  //----
+
+  //==========================================================================
+  // glb_instances
+  //==========================================================================
+  // TRS arrays of EXT_mesh_gpu_instancing instances
+  struct glb_instances
+  {
+    void add(const vec3f &pos_, const vec4f &rot_, const vec3f &scale_)
+    {
+      translations.push_back(pos_);
+      rotations.push_back(rot_);
+      scales.push_back(scale_);
+    }
+    //----
+
+    void write_node(heap_str &json_, glb_builder &glb_, const char *name_, unsigned mesh_idx_) const
+    {
+      // add instance attribute accessors and write the instanced mesh node
+      unsigned num_insts=(unsigned)translations.size();
+      unsigned tacc=glb_.add_vec3_accessor(translations.data(), num_insts, 0, false);
+      unsigned racc=glb_.add_accessor(glb_.add_view(rotations.data(), num_insts*sizeof(vec4f), 0), gltftype_float, num_insts, "VEC4");
+      unsigned sacc=glb_.add_vec3_accessor(scales.data(), num_insts, 0, false);
+      json_.push_back_format(",{\"name\":\"%s\",\"mesh\":%i,\"extensions\":{\"EXT_mesh_gpu_instancing\":{\"attributes\":{\"TRANSLATION\":%i,\"ROTATION\":%i,\"SCALE\":%i}}}}", name_, mesh_idx_, tacc, racc, sacc);
+    }
+    //------------------------------------------------------------------------
+
+    array<vec3f> translations;
+    array<vec4f> rotations;
+    array<vec3f> scales;
+  };
+  //----
+
+  vec4f zrot_quat(const vec3f &dir_)
+  {
+    // shortest-arc rotation quaternion (x, y, z, w) from +z to unit direction
+    if(dir_.z<-0.9999f)
+      return vec4f(1.0f, 0.0f, 0.0f, 0.0f);
+    float w=1.0f+dir_.z, rn=1.0f/sqrt(dir_.x*dir_.x+dir_.y*dir_.y+w*w);
+    return vec4f(-dir_.y*rn, dir_.x*rn, 0.0f, w*rn);
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // export_p3g
 //============================================================================
@@ -29,22 +697,73 @@ bool pfc::export_p3g(bin_output_stream_base &fout_, const export_cfg_p3g &cfg_,
   const usize_t num_mlets=mlets.size();
   const usize_t num_mlet_vidx=mlet_vidx.size();
   const usize_t num_mlet_tidx=mlet_tidx.size();
-  const usize_t vbuf_size=mgeo_.vbuf_size;
-  const bool use_32bit_vtx_ibuf=num_vtx>=65536;
+  const bool use_packed_vidx=cfg_.packed_vidx && !cfg_.local_vbuf;
+  if(cfg_.packed_vidx && cfg_.local_vbuf)
+    warnf("> Warning: Meshlet-local vertex blocks have no vertex indices, ignoring packed vertex indices\r\n");
+  array<uint32_t> packed_vidx, packed_vidx_sizes;
+  if(use_packed_vidx)
+  {
+    // bitpack vertex indices of each meshlet in the export order
+    for(usize_t mseg_idx=0; mseg_idx<num_segs; ++mseg_idx)
+    {
+      const p3g_mesh_segment &p3g_seg=p3g_geo_.segs[mseg_idx];
+      for(uint32_t mlet_idx=0; mlet_idx<p3g_seg.num_mlets; ++mlet_idx)
+      {
+        const p3g_meshlet &mlet=mlets[p3g_seg.start_mlet+mlet_idx];
+        usize_t start=packed_vidx.size();
+        if(!pack_meshlet_vidx(packed_vidx, mlet_vidx.data()+mlet.start_vidx, mlet.num_vtx))
+          return false;
+        packed_vidx_sizes.push_back(uint32_t((packed_vidx.size()-start)*4));
+      }
+    }
+  }
+  const bool use_packed_tidx=cfg_.packed_tidx;
+  array<uint8_t> packed_tidx;
+  if(use_packed_tidx)
+  {
+    // bitpack triangle indices of each meshlet in the export order
+    for(usize_t mseg_idx=0; mseg_idx<num_segs; ++mseg_idx)
+    {
+      const p3g_mesh_segment &p3g_seg=p3g_geo_.segs[mseg_idx];
+      for(uint32_t mlet_idx=0; mlet_idx<p3g_seg.num_mlets; ++mlet_idx)
+      {
+        const p3g_meshlet &mlet=mlets[p3g_seg.start_mlet+mlet_idx];
+        pack_meshlet_tidx(packed_tidx, mlet_tidx.data()+mlet.start_tidx, mlet.num_idx, mlet.num_vtx);
+      }
+    }
+  }
+  const usize_t tibuf_size=use_packed_tidx?packed_tidx.size()+p3g_packed_tidx_guard_size:num_mlet_tidx;
+  const usize_t vtx_size=num_vtx?mgeo_.vbuf_size/num_vtx:0;
+  const usize_t vbuf_size=cfg_.local_vbuf?num_mlet_vidx*vtx_size:mgeo_.vbuf_size;
+  const bool use_32bit_vtx_ibuf=!cfg_.local_vbuf && !use_packed_vidx && num_vtx>=65536;
   const uint32_t vidx_size=use_32bit_vtx_ibuf?4:2;
-  static const uint32_t s_header_size=40;
-  static const uint32_t s_segment_size=16;
-  static const uint32_t s_meshlet_size=8+(cfg_.export_meshlet_bvols?4:0)+(cfg_.export_meshlet_vcones?4:0);
-  const uint32_t offs_segs=s_header_size;
-  const usize_t offs_mlets=offs_segs+s_segment_size*num_segs;
-  const usize_t offs_vibuf=offs_mlets+s_meshlet_size*num_mlets;
-  const usize_t offs_tibuf=offs_vibuf+(use_32bit_vtx_ibuf?num_mlet_vidx*4:((num_mlet_vidx+1)&-2)*2);
-  usize_t offs_vbuf=offs_tibuf+((num_mlet_tidx+3)&-4);
+  const usize_t vibuf_size=cfg_.local_vbuf?0:use_packed_vidx?packed_vidx.size()*4:use_32bit_vtx_ibuf?num_mlet_vidx*4:((num_mlet_vidx+1)&-2)*2;
+  const uint32_t mlet_bounds_size=(cfg_.export_meshlet_bvols?4:0)+(cfg_.export_meshlet_vcones?4:0);
+
+  // use large layout if counts or 24-bit meshlet data offsets of the standard layout would overflow
+  const usize_t max_std_mlet_data_offs=40+16*num_segs+(8+mlet_bounds_size)*num_mlets+vibuf_size+((tibuf_size+3)&-4)+cfg_.vbuf_align+(cfg_.local_vbuf?vbuf_size:0);
+  const bool use_large_layout=num_mlets>0xffff || num_segs>0xff || max_std_mlet_data_offs>0x00ffffff;
+  const uint32_t header_size=use_large_layout?48:40;
+  const uint32_t segment_size=use_large_layout?20:16;
+  const uint32_t meshlet_size=(use_large_layout?12:8)+mlet_bounds_size;
+  const uint32_t offs_segs=header_size;
+  const usize_t offs_mlets=offs_segs+segment_size*num_segs;
+  const usize_t offs_vibuf=offs_mlets+meshlet_size*num_mlets;
+  const usize_t offs_tibuf=offs_vibuf+vibuf_size;
+  usize_t offs_vbuf=offs_tibuf+((tibuf_size+3)&-4);
   const uint32_t vbuf_align_dwords=cfg_.vbuf_align>4?(cfg_.vbuf_align-(offs_vbuf%cfg_.vbuf_align))/4:0;
   offs_vbuf+=vbuf_align_dwords*4;
   const usize_t total_fsize=offs_vbuf+vbuf_size;
+  if(uint64_t(total_fsize)>0xffffffff)
+  {
+    errorf("> Error: P3G file size (%zi bytes) exceeds the 32-bit offset range\r\n", total_fsize);
+    return false;
+  }
+  if(use_large_layout && cfg_.log_stats)
+    logf(">   Using large P3G layout (v1.1)\r\n");
 
   // log size stats
+  if(cfg_.log_stats)
   {
     // log index data size
     float idx_data_size=float(offs_vbuf-offs_vibuf);
@@ -79,86 +798,134 @@ bool pfc::export_p3g(bin_output_stream_base &fout_, const export_cfg_p3g &cfg_,
     logf(total_unit_frc?">   File size: %.1f%s\r\n":">   File size: %.0f%s\r\n", total_file_size, total_unit.c_str());
   }
 
-  // output file header
-  fout_.write_bytes("p3dg", 4); /*todo; support big-endian?*/
-  fout_<<uint16_t(p3g_file_version);
+  // build file header to the staging buffer of the header, segment, meshlet and index sections
+  array<uint8_t> staging;
+  staging.resize(offs_vbuf, uint8_t(0));
+  staging_writer sw={staging.data()};
+  sw.write_bytes("p3dg", 4); /*todo; support big-endian?*/
+  sw<<(use_large_layout?uint16_t(p3g_file_version_large):uint16_t(p3g_file_version));
   uint16_t flags= (use_32bit_vtx_ibuf?p3gflag_32bit_index:0)
                  |(p3g_geo_.is_stripified?p3gflag_tristrips:0)
                  |(cfg_.export_meshlet_bvols?p3gflag_bvols:0)
-                 |(cfg_.export_meshlet_vcones?p3gflag_vcones:0);
-  fout_<<uint16_t(flags);
-  fout_<<uint32_t(total_fsize);
-  fout_<<uint16_t(num_mlets);
-  fout_<<uint8_t(num_segs);
-  fout_<<uint8_t(mgeo_.vfmt_id);
-  fout_<<uint32_t(offs_vbuf);
-  fout_<<uint32_t(vbuf_size);
-  fout_<<mgeo_.bvol.pos<<mgeo_.bvol.rad;
-  PFC_ASSERT(fout_.pos()==s_header_size);
-
-  // write mesh segments
+                 |(cfg_.export_meshlet_vcones?p3gflag_vcones:0)
+                 |(cfg_.local_vbuf?p3gflag_local_vbuf:0)
+                 |(use_packed_vidx?p3gflag_packed_vidx:0)
+                 |(use_packed_tidx?p3gflag_packed_tidx:0)
+                 |(use_large_layout?p3gflag_large:0);
+  sw<<uint16_t(flags);
+  sw<<uint32_t(total_fsize);
+  if(use_large_layout)
+  {
+    sw<<uint32_t(num_mlets);
+    sw<<uint32_t(num_segs);
+    sw<<uint8_t(mgeo_.vfmt_id)<<uint8_t(0)<<uint16_t(0);
+  }
+  else
+  {
+    sw<<uint16_t(num_mlets);
+    sw<<uint8_t(num_segs);
+    sw<<uint8_t(mgeo_.vfmt_id);
+  }
+  sw<<uint32_t(offs_vbuf);
+  sw<<uint32_t(vbuf_size);
+  sw<<mgeo_.bvol.pos.x<<mgeo_.bvol.pos.y<<mgeo_.bvol.pos.z<<mgeo_.bvol.rad;
+  PFC_ASSERT(usize_t(sw.ptr-staging.data())==header_size);
+
+  // build mesh segments
   for(usize_t seg_idx=0; seg_idx<num_segs; ++seg_idx)
   {
-    usize_t start_pos=fout_.pos();
+    const uint8_t *start_ptr=sw.ptr;
     const p3g_mesh_segment &p3g_seg=p3g_geo_.segs[seg_idx];
-    fout_<<uint32_t(p3g_seg.material_id);
-    fout_<<uint16_t(p3g_seg.start_mlet);
-    fout_<<uint16_t(p3g_seg.num_mlets);
-    fout_<<p3g_seg.qbvol_pos[0]<<p3g_seg.qbvol_pos[1]<<p3g_seg.qbvol_pos[2]<<p3g_seg.qbvol_rad;
-    PFC_ASSERT(fout_.pos()-start_pos==s_segment_size);
+    sw<<uint32_t(p3g_seg.material_id);
+    if(use_large_layout)
+      sw<<uint32_t(p3g_seg.start_mlet)<<uint32_t(p3g_seg.num_mlets);
+    else
+      sw<<uint16_t(p3g_seg.start_mlet)<<uint16_t(p3g_seg.num_mlets);
+    sw<<p3g_seg.qbvol_pos[0]<<p3g_seg.qbvol_pos[1]<<p3g_seg.qbvol_pos[2]<<p3g_seg.qbvol_rad;
+    PFC_ASSERT(usize_t(sw.ptr-start_ptr)==segment_size);
   }
 
-  // write meshlets
+  // build meshlets
   usize_t offs_mlet_vibuf=offs_vibuf;
   usize_t offs_mlet_tibuf=offs_tibuf;
+  usize_t offs_mlet_vbuf=offs_vbuf;
+  usize_t export_mlet_idx=0;
   for(usize_t mseg_idx=0; mseg_idx<num_segs; ++mseg_idx)
   {
     const p3g_mesh_segment &p3g_seg=p3g_geo_.segs[mseg_idx];
     for(uint32_t mlet_idx=0; mlet_idx<p3g_seg.num_mlets; ++mlet_idx)
     {
-      usize_t start_pos=fout_.pos();
+      const uint8_t *start_ptr=sw.ptr;
       const p3g_meshlet &mlet=mlets[p3g_seg.start_mlet+mlet_idx];
-      fout_<<uint32_t((offs_mlet_vibuf&0x00ffffff)|(mlet.num_vtx<<24));
-      fout_<<uint32_t((offs_mlet_tibuf&0x00ffffff)|(mlet.num_tris<<24));
+      const usize_t offs_mlet_vtx=cfg_.local_vbuf?offs_mlet_vbuf:offs_mlet_vibuf;
+      if(use_large_layout)
+        sw<<uint32_t(offs_mlet_vtx)<<uint32_t(offs_mlet_tibuf)<<uint32_t(mlet.num_vtx|(mlet.num_tris<<8));
+      else
+      {
+        if(offs_mlet_vtx>0x00ffffff || offs_mlet_tibuf>0x00ffffff)
+        {
+          errorf("> Error: P3G meshlet data offset exceeds the 24-bit range of the standard layout\r\n");
+          return false;
+        }
+        sw<<uint32_t(offs_mlet_vtx|(mlet.num_vtx<<24));
+        sw<<uint32_t(offs_mlet_tibuf|(mlet.num_tris<<24));
+      }
       if(cfg_.export_meshlet_bvols)
-        fout_<<mlet.qbvol_pos[0]<<mlet.qbvol_pos[1]<<mlet.qbvol_pos[2]<<mlet.qbvol_rad;
+        sw<<mlet.qbvol_pos[0]<<mlet.qbvol_pos[1]<<mlet.qbvol_pos[2]<<mlet.qbvol_rad;
       if(cfg_.export_meshlet_vcones)
-        fout_<<mlet.qvcone_dir[0]<<mlet.qvcone_dir[1]<<mlet.qvcone_dir[2]<<mlet.qvcone_dot;
-      PFC_ASSERT(fout_.pos()-start_pos==s_meshlet_size);
-      offs_mlet_vibuf+=mlet.num_vtx*vidx_size;
-      offs_mlet_tibuf+=mlet.num_idx;
+        sw<<mlet.qvcone_dir[0]<<mlet.qvcone_dir[1]<<mlet.qvcone_dir[2]<<mlet.qvcone_dot;
+      PFC_ASSERT(usize_t(sw.ptr-start_ptr)==meshlet_size);
+      if(cfg_.local_vbuf)
+        offs_mlet_vbuf+=mlet.num_vtx*vtx_size;
+      else if(use_packed_vidx)
+        offs_mlet_vibuf+=packed_vidx_sizes[export_mlet_idx++];
+      else
+        offs_mlet_vibuf+=mlet.num_vtx*vidx_size;
+      offs_mlet_tibuf+=use_packed_tidx?(mlet.num_idx*p3g_packed_tidx_width(mlet.num_vtx)+7)/8:mlet.num_idx;
     }
   }
-  PFC_ASSERT(((offs_mlet_tibuf+3)&-4)==offs_vbuf);
+  PFC_ASSERT(offs_mlet_tibuf==offs_tibuf+(use_packed_tidx?packed_tidx.size():num_mlet_tidx));
   PFC_ASSERT(((offs_mlet_vibuf+3)&-4)==offs_tibuf);
 
-  // write vertex index buffer
-  PFC_ASSERT(fout_.pos()==offs_vibuf);
-  if(use_32bit_vtx_ibuf)
-    fout_.write_bytes(mlet_vidx.data(), mlet_vidx.size()*4);
+  // build vertex index buffer (none for meshlet-local vertex blocks, 16-bit buffer padded to 32-bit boundary)
+  PFC_ASSERT(usize_t(sw.ptr-staging.data())==offs_vibuf);
+  if(use_packed_vidx)
+    sw.write_bytes(packed_vidx.data(), packed_vidx.size()*4);
+  else if(use_32bit_vtx_ibuf)
+    sw.write_bytes(mlet_vidx.data(), num_mlet_vidx*4);
+  else if(!cfg_.local_vbuf)
+  {
+    narrow_vidx_u16((uint16_t*)sw.ptr, mlet_vidx.data(), num_mlet_vidx);
+    sw.ptr+=((num_mlet_vidx+1)&-2)*2;
+  }
+  PFC_ASSERT(usize_t(sw.ptr-staging.data())==offs_tibuf);
+
+  // build triangle index buffer (packed buffer followed by the decoder read guard bytes)
+  if(use_packed_tidx)
+    sw.write_bytes(packed_tidx.data(), packed_tidx.size());
   else
+    sw.write_bytes(mlet_tidx.data(), num_mlet_tidx);
+
+  // write the staged sections (zero padding up to the aligned vertex buffer) and the vertex buffer
+  PFC_ASSERT(usize_t(sw.ptr-staging.data())<=offs_vbuf);
+  PFC_ASSERT(!cfg_.vbuf_align || (offs_vbuf%cfg_.vbuf_align)==0);
+  fout_.write_bytes(staging.data(), offs_vbuf);
+  if(cfg_.local_vbuf)
   {
-    // write 16-bit vertex index buffer (align to 32-bit boundary)
+    // gather vertices of each meshlet to a contiguous block
+    array<uint8_t> local_vbuf;
+    local_vbuf.resize(vbuf_size);
+    const uint8_t *vbuf=(const uint8_t*)mgeo_.vbuf;
+    uint8_t *dst=local_vbuf.data();
     for(uint32_t vidx: mlet_vidx)
-      fout_<<uint16_t(vidx);
-    if(mlet_vidx.size()&1)
-      fout_<<uint16_t(0);
+    {
+      mem_copy(dst, vbuf+vidx*vtx_size, vtx_size);
+      dst+=vtx_size;
+    }
+    fout_.write_bytes(local_vbuf.data(), vbuf_size);
   }
-  PFC_ASSERT((fout_.pos()&3)==0);
-
-  // write triangle index buffer (align to 32-bit boundary)
-  PFC_ASSERT(fout_.pos()==offs_tibuf);
-  fout_.write_bytes(mlet_tidx.data(), num_mlet_tidx);
-  for(usize_t i=num_mlet_tidx; (i&3)!=0; ++i)
-    fout_<<uint8_t(0);
-  PFC_ASSERT((fout_.pos()&3)==0);
-
-  // align and write vertex buffer
-  for(usize_t i=0; i<vbuf_align_dwords; ++i)
-    fout_<<uint32_t(0);
-  PFC_ASSERT(!cfg_.vbuf_align || (fout_.pos()%cfg_.vbuf_align)==0);
-  PFC_ASSERT(fout_.pos()==offs_vbuf);
-  fout_.write_bytes(mgeo_.vbuf, vbuf_size);
+  else
+    fout_.write_bytes(mgeo_.vbuf, vbuf_size);
   return true;
 }
 //----------------------------------------------------------------------------
@@ -169,16 +936,15 @@ bool pfc::export_p3g(bin_output_stream_base &fout_, const export_cfg_p3g &cfg_,
 //============================================================================
 bool pfc::export_dae(bin_output_stream_base &fout_, const export_cfg_dae &cfg_, const mesh_geometry &mgeo_, const p3g_mesh_geometry &p3g_geo_)
 {
-  // setup output streams and access export geometry
-  text_output_stream tout(fout_);
-//  const mesh_vertex_buffer &vbuf=egeo_.vbuf;
+  // setup output writer and access export geometry
+  chunked_text_writer tw(fout_);
   const array<p3g_mesh_segment> &segs=p3g_geo_.segs;
   const array<p3g_meshlet> &mlets=p3g_geo_.mlets;
   const array<uint32_t> &mlet_vidx=p3g_geo_.mlet_vidx;
   const array<uint8_t> &mlet_tidx=p3g_geo_.mlet_tidx;
 
   // export Collada header
-  fout_<<
+  tw<<
   R"(<?xml version="1.0" encoding="utf-8"?>)""\r\n"
   R"(<COLLADA xmlns="http://www.collada.org/2005/11/COLLADASchema" version="1.4.1" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance">)""\r\n"
   R"(  <asset>)""\r\n"
@@ -189,22 +955,22 @@ bool pfc::export_dae(bin_output_stream_base &fout_, const export_cfg_dae &cfg_,
   R"(  <library_geometries>)""\r\n";
 
   // export mesh geometry (vertex positions, meshlet colors and triangles)
-  fout_<<
+  tw<<
   R"(    <geometry id="Mesh_001-mesh" name="Mesh.001">)""\r\n"
   R"(      <mesh>)""\r\n"
   R"(        <source id="Mesh_001-mesh-positions">)""\r\n"
   R"(          <float_array id="Mesh_001-mesh-positions-array" count=")";
   const vec3f *vtx_pos=mgeo_.vertices;
   uint32_t num_vtx=(uint32_t)mgeo_.num_vertices;
-  tout<<num_vtx*3<<"\">";
+  tw<<num_vtx*3<<"\">";
   for(usize_t i=0; i<num_vtx; ++i)
-    tout<<vtx_pos[i].x<<' '<<vtx_pos[i].y<<' '<<vtx_pos[i].z<<' ';
-  fout_<<
+    tw<<vtx_pos[i].x<<' '<<vtx_pos[i].y<<' '<<vtx_pos[i].z<<' ';
+  tw<<
   R"(</float_array>)""\r\n"
   R"(          <technique_common>)""\r\n"
   R"(            <accessor source="#Mesh_001-mesh-positions-array" count=")";
-  tout<<num_vtx;
-  fout_<<
+  tw<<num_vtx;
+  tw<<
   R"(" stride="3">)""\r\n"
   R"(              <param name="X" type="float"/><param name="Y" type="float"/><param name="Z" type="float"/>)""\r\n"
   R"(            </accessor>)""\r\n"
@@ -213,7 +979,7 @@ bool pfc::export_dae(bin_output_stream_base &fout_, const export_cfg_dae &cfg_,
   R"(        <source id="Mesh_001-mesh-colors-Col" name="Col">)""\r\n"
   R"(          <float_array id="Mesh_001-mesh-colors-Col-array" count=")";
   uint32_t num_mlets=(uint32_t)mlets.size();
-  tout<<num_mlets*4<<"\">";
+  tw<<num_mlets*4<<"\">";
   rng_simple rng(12345);
   for(usize_t i=0; i<mlets.size(); ++i)
   {
@@ -221,14 +987,14 @@ bool pfc::export_dae(bin_output_stream_base &fout_, const export_cfg_dae &cfg_,
     float g=rng.rand_ureal1();
     float b=rng.rand_ureal1();
     float s=1.0f/(r+g+b);
-    tout<<r*s<<' '<<g*s<<' '<<b*s<<" 1 ";
+    tw<<r*s<<' '<<g*s<<' '<<b*s<<" 1 ";
   }
-  fout_<<
+  tw<<
   R"(</float_array>)""\r\n"
   R"(          <technique_common>)""\r\n"
   R"(            <accessor source="#Mesh_001-mesh-colors-Col-array" count=")";
-  tout<<mlets.size();
-  fout_<<
+  tw<<num_mlets;
+  tw<<
   R"(" stride="4">)""\r\n"
   R"(              <param name="R" type="float"/><param name="G" type="float"/><param name="B" type="float"/><param name="A" type="float"/>)""\r\n"
   R"(            </accessor>)""\r\n"
@@ -238,8 +1004,8 @@ bool pfc::export_dae(bin_output_stream_base &fout_, const export_cfg_dae &cfg_,
   R"(          <input semantic="POSITION" source="#Mesh_001-mesh-positions"/>)""\r\n"
   R"(        </vertices>)""\r\n"
   R"(        <triangles count=")";
-  tout<<p3g_geo_.num_tris;
-  fout_<<
+  tw<<p3g_geo_.num_tris;
+  tw<<
   R"(">)""\r\n"
   R"(          <input semantic="VERTEX" source="#Mesh_001-mesh-vertices" offset="0"/>)""\r\n"
   R"(          <input semantic="COLOR" source="#Mesh_001-mesh-colors-Col" offset="1" set="0"/>)""\r\n"
@@ -254,141 +1020,85 @@ bool pfc::export_dae(bin_output_stream_base &fout_, const export_cfg_dae &cfg_,
     for(usize_t mlet_idx=0; mlet_idx<seg.num_mlets; ++mlet_idx)
     {
       const p3g_meshlet &mlet=mlets[seg.start_mlet+mlet_idx];
-      const uint8_t *tidx=mlet_tidx.data()+mlet_start_tidx, *tidx_end=tidx+mlet.num_idx;
-      if(p3g_geo_.is_stripified)
+      const uint32_t *vidx=mlet_vidx.data()+mlet_start_vidx;
+      for_each_meshlet_triangle(mlet_tidx.data()+mlet_start_tidx, mlet.num_idx, p3g_geo_.is_stripified, [&](uint8_t tidx0_, uint8_t tidx1_, uint8_t tidx2_)
       {
-        tidx_end-=2;
-        uint8_t parity=0;
-        while(tidx<tidx_end)
-        {
-          if(!p3g_meshlet_tristrip_restart || tidx[2]!=p3g_meshlet_tristrip_restart)
-          {
-            if(tidx[0]!=tidx[1] && tidx[0]!=tidx[2] && tidx[1]!=tidx[2])
-            {
-              uint8_t tidx0=parity?tidx[0]:tidx[1], tidx1=parity?tidx[1]:tidx[0], tidx2=tidx[2];
-              tout<<mlet_vidx[mlet_start_vidx+tidx0]<<' '<<num_total_mlets<<' ';
-              tout<<mlet_vidx[mlet_start_vidx+tidx1]<<' '<<num_total_mlets<<' ';
-              tout<<mlet_vidx[mlet_start_vidx+tidx2]<<' '<<num_total_mlets<<' ';
-            }
-            ++tidx;
-            parity^=1;
-          }
-          else
-          {
-            parity=0;
-            tidx+=3;
-          }
-        }
-      }
-      else
-        while(tidx<tidx_end)
-          tout<<mlet_vidx[mlet_start_vidx+*tidx++]<<' '<<num_total_mlets<<' ';
+        tw<<vidx[tidx0_]<<' '<<num_total_mlets<<' ';
+        tw<<vidx[tidx1_]<<' '<<num_total_mlets<<' ';
+        tw<<vidx[tidx2_]<<' '<<num_total_mlets<<' ';
+      });
       mlet_start_vidx+=mlet.num_vtx;
       mlet_start_tidx+=mlet.num_idx;
       ++num_total_mlets;
     }
   }
-  fout_<<
+  tw<<
   R"(</p>)""\r\n"
   R"(        </triangles>)""\r\n"
   R"(      </mesh>)""\r\n"
   R"(    </geometry>)""\r\n";
 
-  // export meshlet bounding sphere mesh geometry
-  if(cfg_.export_meshlet_bvols)
-    fout_<<
-    R"(    <geometry id="Sphere-mesh" name="Sphere">)""\r\n"
-    R"(      <mesh>)""\r\n"
-    R"(        <source id="Sphere-mesh-positions">)""\r\n"
-    R"(          <float_array id="Sphere-mesh-positions-array" count="342">0 0.7071068 0.7071068 0 0.9238795 0.3826834 0 0.9238795 -0.3826835 0 0.3826835 -0.9238795 0.1464465 0.3535534 0.9238795 0.270598 0.6532815 0.7071068 0.3535534 0.8535534 0.3826834 0.3826834 0.9238795 0 0.3535534 0.8535534 -0.3826835 0.270598 0.6532815 -0.7071068 0.1464465 0.3535534 -0.9238795 0.2705979 0.2705981 0.9238795 0.4999999 0.5 0.7071068 0.6532814 0.6532815 0.3826834 0.7071067 0.7071068 0 0.6532814 0.6532815 -0.3826835 0.4999999 0.5 -0.7071068 0.270598 0.2705981 -0.9238795 0.3535532 0.1464467 0.9238795 0.6532813 0.2705981 0.7071068 0.8535532 0.3535534 0.3826834 0.9238794 0.3826834 0 0.8535532 0.3535534 -0.3826835 0.6532813 0.2705981 -0.7071068 0.3535533 0.1464466 -0.9238795 0.3826833 1.30703e-7 0.9238795 0.7071065 0 0.7071068 0.9238793 0 0.3826834 0.9999998 0 0 0.9238793 0 -0.3826835 0.7071065 0 -0.7071068 0.3826833 0 -0.9238795 0.3535532 -0.1464464 0.9238795 0.6532812 -0.2705979 0.7071068 0.8535531 -0.3535533 0.3826834 0.9238792 -0.3826833 0 0.8535531 -0.3535533 -0.3826835 0.6532812 -0.2705979 -0.7071068 0.3535532 -0.1464465 -0.9238795 0.2705979 -0.2705978 0.9238795 0.4999997 -0.4999998 0.7071068 0.6532812 -0.6532813 0.3826834 0.7071064 -0.7071066 0 0.6532812 -0.6532813 -0.3826835 0.4999997 -0.4999998 -0.7071068 0.2705978 -0.2705979 -0.9238795 0.1464465 -0.3535531 0.9238795 0.2705977 -0.6532812 0.7071068 0.3535531 -0.8535531 0.3826834 0.382683 -0.9238792 0 0.3535531 -0.8535531 -0.3826835 0.2705977 -0.6532812 -0.7071068 0.1464464 -0.3535531 -0.9238795 0 -0.3826831 0.9238795 -2.664e-7 -0.7071064 0.7071068 -2.96202e-7 -0.9238792 0.3826834 -3.26005e-7 -0.9999995 0 -2.96202e-7 -0.9238792 -0.3826835 -2.664e-7 -0.7071064 -0.7071068 -1.62092e-7 -0.3826831 -0.9238795 -0.1464466 -0.3535531 0.9238795 -0.2705982 -0.653281 0.7071068 -0.3535536 -0.8535529 0.3826834 -0.3826836 -0.923879 0 -0.3535536 -0.8535529 -0.3826835 -0.2705982 -0.653281 -0.7071068 -0.1464467 -0.353553 -0.9238795 -0.270598 -0.2705977 0.9238795 -0.5 -0.4999994 0.7071068 -0.6532815 -0.6532809 0.3826834 -0.7071068 -0.7071061 0 -0.6532815 -0.6532809 -0.3826835 -0.5 -0.4999994 -0.7071068 -0.2705981 -0.2705976 -0.9238795 -0.3535532 -0.1464463 0.9238795 -0.6532813 -0.2705975 0.7071068 -0.8535532 -0.3535528 0.3826834 -0.9238794 -0.3826828 0 -0.8535532 -0.3535528 -0.3826835 -0.6532813 -0.2705975 -0.7071068 -0.3535533 -0.1464462 -0.9238795 -0.3826832 2.49912e-7 0.9238795 -0.7071065 4.88331e-7 0.7071068 -0.9238792 5.18133e-7 0.3826834 -0.9999997 6.0754e-7 0 -0.9238792 5.18133e-7 -0.3826835 -0.7071065 4.88331e-7 -0.7071068 -0.3826832 3.39319e-7 -0.9238795 -0.3535532 0.1464468 0.9238795 -0.653281 0.2705984 0.7071068 -0.8535529 0.3535538 0.3826834 -0.923879 0.3826839 0 -0.8535529 0.3535538 -0.3826835 -0.653281 0.2705984 -0.7071068 -0.3535531 0.1464468 -0.9238795 -0.2705978 0.2705981 0.9238795 -0.4999995 0.5000001 0.7071068 -0.6532809 0.6532817 0.3826834 -0.7071061 0.707107 0 -0.6532809 0.6532817 -0.3826835 -0.4999995 0.5000001 -0.7071068 -0.2705978 0.2705982 -0.9238795 -0.1464464 0.3535534 0.9238795 -0.2705975 0.6532814 0.7071068 -0.3535528 0.8535533 0.3826834 -0.3826827 0.9238795 0 -0.3535528 0.8535533 -0.3826835 -0.2705975 0.6532814 -0.7071068 -0.1464463 0.3535534 -0.9238795 0 0 1 0 0.3826833 0.9238795 6.57472e-7 0.9999997 0 4.33955e-7 0.7071065 -0.7071068 0 1.50996e-7 -1</float_array>)""\r\n"
-    R"(          <technique_common>)""\r\n"
-    R"(            <accessor source="#Sphere-mesh-positions-array" count="114" stride="3">)""\r\n"
-    R"(              <param name="X" type="float"/><param name="Y" type="float"/><param name="Z" type="float"/>)""\r\n"
-    R"(            </accessor>)""\r\n"
-    R"(          </technique_common>)""\r\n"
-    R"(        </source>)""\r\n"
-    R"(        <vertices id="Sphere-mesh-vertices">)""\r\n"
-    R"(          <input semantic="POSITION" source="#Sphere-mesh-positions"/>)""\r\n"
-    R"(        </vertices>)""\r\n"
-    R"(        <triangles count="224">)""\r\n"
-    R"(          <input semantic="VERTEX" source="#Sphere-mesh-vertices" offset="0"/>)""\r\n"
-    R"(          <p>0 6 1 110 109 4 113 3 10 112 8 9 111 6 7 110 5 0 112 10 3 111 8 2 8 16 9 6 14 7 4 12 5 10 16 17 7 15 8 5 13 6 4 109 11 113 10 17 17 23 24 14 22 15 12 20 13 11 109 18 113 17 24 15 23 16 13 21 14 11 19 12 22 28 29 20 26 27 18 109 25 113 24 31 22 30 23 20 28 21 18 26 19 24 30 31 113 31 38 29 37 30 27 35 28 25 33 26 31 37 38 29 35 36 26 34 27 25 109 32 34 42 35 33 39 40 38 44 45 35 43 36 33 41 34 32 109 39 113 38 45 36 44 37 44 52 45 42 50 43 40 48 41 39 109 46 113 45 52 44 50 51 41 49 42 40 46 47 47 55 48 46 109 53 113 52 59 51 57 58 48 56 49 47 53 54 51 59 52 49 57 50 113 59 66 58 64 65 55 63 56 54 60 61 58 66 59 56 64 57 54 62 55 53 109 60 61 67 68 66 72 73 64 70 71 61 69 62 60 109 67 113 66 73 65 71 72 62 70 63 72 80 73 70 78 71 68 76 69 67 109 74 113 73 80 72 78 79 70 76 77 68 74 75 74 109 81 113 80 87 79 85 86 77 83 84 75 81 82 79 87 80 77 85 78 75 83 76 86 92 93 84 90 91 82 88 89 87 93 94 84 92 85 82 90 83 81 109 88 113 87 94 94 100 101 91 99 92 89 97 90 88 109 95 113 94 101 93 99 100 91 97 98 89 95 96 98 106 99 96 104 97 95 109 102 113 101 108 100 106 107 98 104 105 96 102 103 101 107 108 113 108 3 107 2 112 105 1 111 103 110 0 107 3 108 105 2 106 104 0 1 102 109 110 0 5 6 112 2 8 111 1 6 110 4 5 112 9 10 111 7 8 8 15 16 6 13 14 4 11 12 10 9 16 7 14 15 5 12 13 17 16 23 14 21 22 12 19 20 15 22 23 13 20 21 11 18 19 22 21 28 20 19 26 22 29 30 20 27 28 18 25 26 24 23 30 29 36 37 27 34 35 25 32 33 31 30 37 29 28 35 26 33 34 34 41 42 33 32 39 38 37 44 35 42 43 33 40 41 36 43 44 44 51 52 42 49 50 40 47 48 44 43 50 41 48 49 40 39 46 47 54 55 51 50 57 48 55 56 47 46 53 51 58 59 49 56 57 58 57 64 55 62 63 54 53 60 58 65 66 56 63 64 54 61 62 61 60 67 66 65 72 64 63 70 61 68 69 65 64 71 62 69 70 72 79 80 70 77 78 68 75 76 72 71 78 70 69 76 68 67 74 79 78 85 77 76 83 75 74 81 79 86 87 77 84 85 75 82 83 86 85 92 84 83 90 82 81 88 87 86 93 84 91 92 82 89 90 94 93 100 91 98 99 89 96 97 93 92 99 91 90 97 89 88 95 98 105 106 96 103 104 100 99 106 98 97 104 96 95 102 101 100 107 107 106 2 105 104 1 103 102 110 107 112 3 105 111 2 104 103 0</p>)""\r\n"
-    R"(        </triangles>)""\r\n"
-    R"(      </mesh>)""\r\n"
-    R"(    </geometry>)""\r\n";
-
-  // export visibility cone mesh geometry
-  if(cfg_.export_meshlet_vcones)
-  {
-    // green cone geometry
-    fout_<<
-    R"(    <geometry id="GreenCone-mesh" name="GreenCone">)""\r\n"
-    R"(      <mesh>)""\r\n"
-    R"(        <source id="GreenCone-mesh-positions">)""\r\n"
-    R"(          <float_array id="GreenCone-mesh-positions-array" count="99">0 -0.9999994 1 0.1950903 -0.9807847 1 0.3826835 -0.9238789 1 0.5555703 -0.831469 1 0.7071068 -0.7071062 1 0.8314697 -0.5555696 1 0.9238795 -0.3826829 1 0.9807853 -0.1950898 1 1 4.74551e-7 1 0.9807853 0.1950907 1 0.9238796 0.3826838 1 0.8314697 0.5555708 1 0.7071068 0.7071074 1 0.5555702 0.8314703 1 0.3826833 0.9238802 1 0.1950901 0.9807859 1 -3.25841e-7 1 1 -0.1950907 0.9807858 1 -0.3826839 0.9238799 1 -0.5555707 0.8314699 1 -0.7071073 0.707107 1 -0.83147 0.5555703 1 -0.9238799 0.3826832 1 0 6.37471e-7 0 -0.9807854 0.19509 1 -1 -4.15551e-7 1 -0.9807851 -0.1950908 1 -0.9238791 -0.3826839 1 -0.8314689 -0.5555707 1 -0.7071059 -0.7071071 1 -0.5555691 -0.8314698 1 -0.3826821 -0.9238795 1 -0.1950888 -0.980785 1</float_array>)""\r\n"
-    R"(          <technique_common>)""\r\n"
-    R"(            <accessor source="#GreenCone-mesh-positions-array" count="33" stride="3">)""\r\n"
-    R"(              <param name="X" type="float"/><param name="Y" type="float"/><param name="Z" type="float"/>)""\r\n"
-    R"(            </accessor>)""\r\n"
-    R"(          </technique_common>)""\r\n"
-    R"(        </source>)""\r\n"
-    R"(        <source id="GreenCone-mesh-colors-Col" name="GreenCol">)""\r\n"
-    R"(          <float_array id="GreenCone-mesh-colors-GreenCol-array" count="4">0 1 0 1</float_array>)""\r\n"
-    R"(          <technique_common>)""\r\n"
-    R"(            <accessor source="#GreenCone-mesh-colors-Col-array" count="1" stride="4">)""\r\n"
-    R"(              <param name="R" type="float"/><param name="G" type="float"/><param name="B" type="float"/><param name="A" type="float"/>)""\r\n"
-    R"(            </accessor>)""\r\n"
-    R"(          </technique_common>)""\r\n"
-    R"(        </source>)""\r\n"
-    R"(        <vertices id="GreenCone-mesh-vertices">)""\r\n"
-    R"(          <input semantic="POSITION" source="#GreenCone-mesh-positions"/>)""\r\n"
-    R"(        </vertices>)""\r\n"
-    R"(        <triangles count="62">)""\r\n"
-    R"(          <input semantic="VERTEX" source="#GreenCone-mesh-vertices" offset="0"/>)""\r\n"
-    R"(          <input semantic="COLOR" source="#GreenCone-mesh-colors-Col" offset="1" set="0"/>)""\r\n"
-    R"(          <p>0 0 23 0 1 0 1 0 23 0 2 0 2 0 23 0 3 0 3 0 23 0 4 0 4 0 23 0 5 0 5 0 23 0 6 0 6 0 23 0 7 0 7 0 23 0 8 0 8 0 23 0 9 0 9 0 23 0 10 0 10 0 23 0 11 0 11 0 23 0 12 0 12 0 23 0 13 0 13 0 23 0 14 0 14 0 23 0 15 0 15 0 23 0 16 0 16 0 23 0 17 0 17 0 23 0 18 0 18 0 23 0 19 0 19 0 23 0 20 0 20 0 23 0 21 0 21 0 23 0 22 0 22 0 23 0 24 0 24 0 23 0 25 0 25 0 23 0 26 0 26 0 23 0 27 0 27 0 23 0 28 0 28 0 23 0 29 0 29 0 23 0 30 0 30 0 23 0 31 0 31 0 23 0 32 0 32 0 23 0 0 0 7 0 15 0 24 0 32 0 0 0 1 0 1 0 2 0 3 0 3 0 4 0 7 0 4 0 5 0 7 0 5 0 6 0 7 0 7 0 8 0 9 0 9 0 10 0 7 0 10 0 11 0 7 0 11 0 12 0 15 0 12 0 13 0 15 0 13 0 14 0 15 0 15 0 16 0 17 0 17 0 18 0 19 0 19 0 20 0 21 0 21 0 22 0 24 0 24 0 25 0 26 0 26 0 27 0 28 0 28 0 29 0 32 0 29 0 30 0 32 0 30 0 31 0 32 0 32 0 1 0 3 0 15 0 17 0 24 0 17 0 19 0 24 0 19 0 21 0 24 0 24 0 26 0 32 0 26 0 28 0 32 0 32 0 3 0 7 0 7 0 11 0 15 0 32 0 7 0 24 0</p>)""\r\n"
-    R"(        </triangles>)""\r\n"
-    R"(      </mesh>)""\r\n"
-    R"(    </geometry>)""\r\n";
-
-    // red cone geometry
-    fout_<<
-    R"(    <geometry id="RedCone-mesh" name="RedCone">)""\r\n"
-    R"(      <mesh>)""\r\n"
-    R"(        <source id="RedCone-mesh-positions">)""\r\n"
-    R"(          <float_array id="RedCone-mesh-positions-array" count="99">0 -0.9999994 1 0.1950903 -0.9807847 1 0.3826835 -0.9238789 1 0.5555703 -0.831469 1 0.7071068 -0.7071062 1 0.8314697 -0.5555696 1 0.9238795 -0.3826829 1 0.9807853 -0.1950898 1 1 4.74551e-7 1 0.9807853 0.1950907 1 0.9238796 0.3826838 1 0.8314697 0.5555708 1 0.7071068 0.7071074 1 0.5555702 0.8314703 1 0.3826833 0.9238802 1 0.1950901 0.9807859 1 -3.25841e-7 1 1 -0.1950907 0.9807858 1 -0.3826839 0.9238799 1 -0.5555707 0.8314699 1 -0.7071073 0.707107 1 -0.83147 0.5555703 1 -0.9238799 0.3826832 1 0 6.37471e-7 0 -0.9807854 0.19509 1 -1 -4.15551e-7 1 -0.9807851 -0.1950908 1 -0.9238791 -0.3826839 1 -0.8314689 -0.5555707 1 -0.7071059 -0.7071071 1 -0.5555691 -0.8314698 1 -0.3826821 -0.9238795 1 -0.1950888 -0.980785 1</float_array>)""\r\n"
-    R"(          <technique_common>)""\r\n"
-    R"(            <accessor source="#RedCone-mesh-positions-array" count="33" stride="3">)""\r\n"
-    R"(              <param name="X" type="float"/><param name="Y" type="float"/><param name="Z" type="float"/>)""\r\n"
-    R"(            </accessor>)""\r\n"
-    R"(          </technique_common>)""\r\n"
-    R"(        </source>)""\r\n"
-    R"(        <source id="RedCone-mesh-colors-Col" name="RedCol">)""\r\n"
-    R"(          <float_array id="RedCone-mesh-colors-RedCol-array" count="4">1 0 0 1</float_array>)""\r\n"
-    R"(          <technique_common>)""\r\n"
-    R"(            <accessor source="#RedCone-mesh-colors-Col-array" count="1" stride="4">)""\r\n"
-    R"(              <param name="R" type="float"/><param name="G" type="float"/><param name="B" type="float"/><param name="A" type="float"/>)""\r\n"
-    R"(            </accessor>)""\r\n"
-    R"(          </technique_common>)""\r\n"
-    R"(        </source>)""\r\n"
-    R"(        <vertices id="RedCone-mesh-vertices">)""\r\n"
-    R"(          <input semantic="POSITION" source="#RedCone-mesh-positions"/>)""\r\n"
-    R"(        </vertices>)""\r\n"
-    R"(        <triangles count="62">)""\r\n"
-    R"(          <input semantic="VERTEX" source="#RedCone-mesh-vertices" offset="0"/>)""\r\n"
-    R"(          <input semantic="COLOR" source="#RedCone-mesh-colors-Col" offset="1" set="0"/>)""\r\n"
-    R"(          <p>0 0 23 0 1 0 1 0 23 0 2 0 2 0 23 0 3 0 3 0 23 0 4 0 4 0 23 0 5 0 5 0 23 0 6 0 6 0 23 0 7 0 7 0 23 0 8 0 8 0 23 0 9 0 9 0 23 0 10 0 10 0 23 0 11 0 11 0 23 0 12 0 12 0 23 0 13 0 13 0 23 0 14 0 14 0 23 0 15 0 15 0 23 0 16 0 16 0 23 0 17 0 17 0 23 0 18 0 18 0 23 0 19 0 19 0 23 0 20 0 20 0 23 0 21 0 21 0 23 0 22 0 22 0 23 0 24 0 24 0 23 0 25 0 25 0 23 0 26 0 26 0 23 0 27 0 27 0 23 0 28 0 28 0 23 0 29 0 29 0 23 0 30 0 30 0 23 0 31 0 31 0 23 0 32 0 32 0 23 0 0 0 7 0 15 0 24 0 32 0 0 0 1 0 1 0 2 0 3 0 3 0 4 0 7 0 4 0 5 0 7 0 5 0 6 0 7 0 7 0 8 0 9 0 9 0 10 0 7 0 10 0 11 0 7 0 11 0 12 0 15 0 12 0 13 0 15 0 13 0 14 0 15 0 15 0 16 0 17 0 17 0 18 0 19 0 19 0 20 0 21 0 21 0 22 0 24 0 24 0 25 0 26 0 26 0 27 0 28 0 28 0 29 0 32 0 29 0 30 0 32 0 30 0 31 0 32 0 32 0 1 0 3 0 15 0 17 0 24 0 17 0 19 0 24 0 19 0 21 0 24 0 24 0 26 0 32 0 26 0 28 0 32 0 32 0 3 0 7 0 7 0 11 0 15 0 32 0 7 0 24 0</p>)""\r\n"
-    R"(        </triangles>)""\r\n"
-    R"(      </mesh>)""\r\n"
-    R"(    </geometry>)""\r\n";
+  // setup meshlet bounding sphere and visibility cone (green=positive, red=negative space) instances
+  array<dae_instance> sphere_insts, green_cone_insts, red_cone_insts;
+  if(cfg_.export_meshlet_bvols || cfg_.export_meshlet_vcones)
+  {
+    uint32_t mlet_idx=0;
+    for(const p3g_mesh_segment &seg:segs)
+    {
+      sphere3f seg_bvol=dequantize_segment_bvol(seg.qbvol_pos, seg.qbvol_rad, mgeo_.bvol);
+      for(uint32_t midx=0; midx<seg.num_mlets; ++midx, ++mlet_idx)
+      {
+        const p3g_meshlet &mlet=mlets[seg.start_mlet+midx];
+        const sphere3f bvol=dequantize_meshlet_bvol(mlet.qbvol_pos, mlet.qbvol_rad, seg_bvol);
+        if(cfg_.export_meshlet_bvols)
+        {
+          dae_instance &inst=sphere_insts.push_back();
+          inst.o2w=tform3f(bvol.rad, bvol.rad, bvol.rad);
+          inst.o2w.set_translation(bvol.pos);
+          inst.mlet_idx=mlet_idx;
+        }
+        if(cfg_.export_meshlet_vcones && mlet.qvcone_dot!=-127)
+        {
+          vcone_instance vci;
+          setup_vcone_instance(vci, mlet, bvol);
+          dae_instance &inst=(vci.positive_space?green_cone_insts:red_cone_insts).push_back();
+          inst.o2w=tform3f(vci.scale.x, vci.scale.y, vci.scale.z)*zrot_u(vci.dir);
+          inst.o2w.set_translation(vci.pos);
+          inst.mlet_idx=mlet_idx;
+        }
+      }
+    }
+  }
+
+  // export meshlet bounding sphere and visibility cone geometry
+  if(cfg_.merge_instances)
+  {
+    // bake instances to single meshes
+    if(sphere_insts.size())
+      write_dae_baked_geometry(tw, "Spheres", s_sphere_vtx_pos, sphere_num_vtx, s_sphere_tidx, sphere_num_tris, sphere_insts, 0);
+    if(green_cone_insts.size())
+      write_dae_baked_geometry(tw, "GreenCones", s_cone_vtx_pos, cone_num_vtx, s_cone_tidx, cone_num_tris, green_cone_insts, "0 1 0 1");
+    if(red_cone_insts.size())
+      write_dae_baked_geometry(tw, "RedCones", s_cone_vtx_pos, cone_num_vtx, s_cone_tidx, cone_num_tris, red_cone_insts, "1 0 0 1");
+  }
+  else
+  {
+    // template meshes for instance nodes
+    if(cfg_.export_meshlet_bvols)
+      write_dae_geometry(tw, "Sphere", s_sphere_vtx_pos, sphere_num_vtx, s_sphere_tidx, sphere_num_tris, 1, 0);
+    if(cfg_.export_meshlet_vcones)
+    {
+      write_dae_geometry(tw, "GreenCone", s_cone_vtx_pos, cone_num_vtx, s_cone_tidx, cone_num_tris, 1, "0 1 0 1");
+      write_dae_geometry(tw, "RedCone", s_cone_vtx_pos, cone_num_vtx, s_cone_tidx, cone_num_tris, 1, "1 0 0 1");
+    }
   }
 
   // end geometry definition
-  fout_<<
+  tw<<
   R"(  </library_geometries>)""\r\n";
 
   // export mesh instance
-  fout_<<
+  tw<<
   R"(  <library_visual_scenes>)""\r\n"
   R"(    <visual_scene id="Scene" name="Scene">)""\r\n"
   R"(      <node id="Mesh" name="Mesh" type="NODE">)""\r\n"
@@ -396,81 +1106,164 @@ bool pfc::export_dae(bin_output_stream_base &fout_, const export_cfg_dae &cfg_,
   R"(        <instance_geometry url="#Mesh_001-mesh" name="Mesh"/>)""\r\n"
   R"(      </node>)""\r\n";
 
-  // export meshlet bounding sphere and visibility cone instances
-  if(cfg_.export_meshlet_bvols || cfg_.export_meshlet_vcones)
+  // export meshlet bounding sphere and visibility cone nodes
+  if(cfg_.merge_instances)
+  {
+    if(sphere_insts.size())
+      write_dae_node(tw, "Spheres");
+    if(green_cone_insts.size())
+      write_dae_node(tw, "GreenCones");
+    if(red_cone_insts.size())
+      write_dae_node(tw, "RedCones");
+  }
+  else
+  {
+    write_dae_instance_nodes(tw, "Sphere", "Sphere", sphere_insts);
+    write_dae_instance_nodes(tw, "Cone", "GreenCone", green_cone_insts);
+    write_dae_instance_nodes(tw, "Cone", "RedCone", red_cone_insts);
+  }
+
+  // export Collada footer
+  tw<<
+  R"(    </visual_scene>)""\r\n"
+  R"(  </library_visual_scenes>)""\r\n"
+  R"(  <scene>)""\r\n"
+  R"(    <instance_visual_scene url="#Scene"/>)""\r\n"
+  R"(  </scene>)""\r\n"
+  R"(</COLLADA>)""\r\n";
+  return true;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// export_glb - binary glTF (glb) file export
+//============================================================================
+bool pfc::export_glb(bin_output_stream_base &fout_, const export_cfg_dae &cfg_, const mesh_geometry &mgeo_, const p3g_mesh_geometry &p3g_geo_)
+{
+  // setup meshlet-local vertices with per-meshlet colors and triangle list indices
+  const array<p3g_mesh_segment> &segs=p3g_geo_.segs;
+  const array<p3g_meshlet> &mlets=p3g_geo_.mlets;
+  const array<uint32_t> &mlet_vidx=p3g_geo_.mlet_vidx;
+  const array<uint8_t> &mlet_tidx=p3g_geo_.mlet_tidx;
+  array<vec3f> vtx_pos;
+  array<uint32_t> vtx_colors;
+  array<uint32_t> tri_vidx;
+  rng_simple rng(12345);
+  for(const p3g_mesh_segment &seg:segs)
   {
-    usize_t num_segs=segs.size();
-    usize_t num_total_mlets=0;
-    for(usize_t seg_idx=0; seg_idx<num_segs; ++seg_idx)
+    uint32_t mlet_start_vidx=seg.start_vidx;
+    uint32_t mlet_start_tidx=seg.start_tidx;
+    for(uint32_t midx=0; midx<seg.num_mlets; ++midx)
+    {
+      // add meshlet vertices with the meshlet color (same colors as in Collada export)
+      const p3g_meshlet &mlet=mlets[seg.start_mlet+midx];
+      float r=rng.rand_ureal1();
+      float g=rng.rand_ureal1();
+      float b=rng.rand_ureal1();
+      float s=255.0f/(r+g+b);
+      uint32_t color=uint32_t(r*s+0.5f)|(uint32_t(g*s+0.5f)<<8)|(uint32_t(b*s+0.5f)<<16)|0xff000000;
+      uint32_t base_vidx=(uint32_t)vtx_pos.size();
+      for(uint32_t i=0; i<mlet.num_vtx; ++i)
+        vtx_pos.push_back(mgeo_.vertices[mlet_vidx[mlet_start_vidx+i]]);
+      vtx_colors.insert_back(mlet.num_vtx, color);
+
+      // add meshlet triangles
+      for_each_meshlet_triangle(mlet_tidx.data()+mlet_start_tidx, mlet.num_idx, p3g_geo_.is_stripified, [&](uint8_t tidx0_, uint8_t tidx1_, uint8_t tidx2_)
+      {
+        uint32_t tri[3]={base_vidx+tidx0_, base_vidx+tidx1_, base_vidx+tidx2_};
+        tri_vidx.insert_back(3, tri);
+      });
+      mlet_start_vidx+=mlet.num_vtx;
+      mlet_start_tidx+=mlet.num_idx;
+    }
+  }
+
+  // setup meshlet bounding sphere and visibility cone (green=positive, red=negative space) instances
+  glb_instances sphere_insts, green_cone_insts, red_cone_insts;
+  if(cfg_.export_meshlet_bvols || cfg_.export_meshlet_vcones)
+    for(const p3g_mesh_segment &seg:segs)
     {
-      const p3g_mesh_segment &seg=segs[seg_idx];
       sphere3f seg_bvol=dequantize_segment_bvol(seg.qbvol_pos, seg.qbvol_rad, mgeo_.bvol);
-      usize_t num_mlets=seg.num_mlets;
-      for(usize_t mlet_idx=0; mlet_idx<num_mlets; ++mlet_idx)
+      for(uint32_t midx=0; midx<seg.num_mlets; ++midx)
       {
-        const p3g_meshlet &mlet=mlets[seg.start_mlet+mlet_idx];
+        const p3g_meshlet &mlet=mlets[seg.start_mlet+midx];
         const sphere3f bvol=dequantize_meshlet_bvol(mlet.qbvol_pos, mlet.qbvol_rad, seg_bvol);
         if(cfg_.export_meshlet_bvols)
+          sphere_insts.add(bvol.pos, vec4f(0.0f, 0.0f, 0.0f, 1.0f), vec3f(bvol.rad, bvol.rad, bvol.rad));
+        if(cfg_.export_meshlet_vcones && mlet.qvcone_dot!=-127)
         {
-          mat44f o2w(bvol.rad,     0.0f,     0.0f, bvol.pos.x,
-                        0.0f,  bvol.rad,     0.0f, bvol.pos.y,
-                        0.0f,      0.0f, bvol.rad, bvol.pos.z,
-                        0.0f,      0.0f,     0.0f,       1.0f);
-          stack_str16 mesh_name;
-          mesh_name.format("Sphere-%i", num_total_mlets);
-          fout_<<R"(      <node id=")"<<mesh_name.c_str()<<R"(" name=")"<<mesh_name.c_str()<<R"(" type="NODE"><matrix sid="transform">)";
-          for(unsigned m=0; m<4; ++m)
-            for(unsigned n=0; n<4; ++n)
-              tout<<o2w[m][n]<<' ';
-          fout_<<R"(</matrix><instance_geometry url="#Sphere-mesh" name=")"<<mesh_name.c_str()<<R"("/></node>)"<<"\r\n";
+          vcone_instance vci;
+          setup_vcone_instance(vci, mlet, bvol);
+          (vci.positive_space?green_cone_insts:red_cone_insts).add(vci.pos, zrot_quat(vci.dir), vci.scale);
         }
-        if(cfg_.export_meshlet_vcones)
-        {
-          // setup cone transform
-          if(mlet.qvcone_dot!=-127)
-          {
-            vec3f vcone_dir;
-            float vcone_dot;
-            dequantize_meshlet_vcone(vcone_dir, vcone_dot, mlet.qvcone_dir, mlet.qvcone_dot);
-            bool positive_space=vcone_dot>=0.0f;
-            vcone_dot=abs(vcone_dot);
-            float cone_angle=acos(vcone_dot);
-            float xyscale=1.0f, zscale=1.0f;
-            if(cone_angle<mathf::pi*0.25f)
-              xyscale=tan(cone_angle);
-            else
-              zscale=cot(cone_angle);
-            float scale=0.5f;
-            tform3f o2w=tform3f(xyscale*bvol.rad*scale, xyscale*bvol.rad*scale, zscale*bvol.rad*scale)*zrot_u(positive_space?vcone_dir:-vcone_dir);
-            o2w.set_translation(bvol.pos+max(zscale, 0.25f)*bvol.rad*vcone_dir);
-
-            stack_str16 mesh_name;
-            mesh_name.format("Cone-%i", num_total_mlets);
-            fout_<<R"(      <node id=")"<<mesh_name.c_str()<<R"(" name=")"<<mesh_name.c_str()<<R"(" type="NODE"><matrix sid="transform">)";
-            mat44f mo2w=o2w.matrix44();
-            transpose(mo2w);
-            for(unsigned m=0; m<4; ++m)
-              for(unsigned n=0; n<4; ++n)
-                tout<<mo2w[m][n]<<' ';
-            if(positive_space)
-              fout_<<R"(</matrix><instance_geometry url="#GreenCone-mesh" name=")"<<mesh_name.c_str()<<R"("/></node>)"<<"\r\n";
-            else
-              fout_<<R"(</matrix><instance_geometry url="#RedCone-mesh" name=")"<<mesh_name.c_str()<<R"("/></node>)"<<"\r\n";
-          }
-        }
-        ++num_total_mlets;
       }
     }
+
+  // add mesh data to the binary buffer
+  glb_builder glb;
+  heap_str meshes_json, nodes_json;
+  unsigned pos_acc=glb.add_vec3_accessor(vtx_pos.data(), vtx_pos.size(), gltf_target_vertices, true);
+  unsigned col_acc=glb.add_accessor(glb.add_view(vtx_colors.data(), vtx_colors.size()*4, gltf_target_vertices), gltftype_ubyte, vtx_colors.size(), "VEC4", true);
+  unsigned idx_acc=glb.add_accessor(glb.add_view(tri_vidx.data(), tri_vidx.size()*4, gltf_target_indices), gltftype_uint, tri_vidx.size(), "SCALAR");
+  meshes_json.push_back_format("{\"name\":\"Mesh\",\"primitives\":[{\"attributes\":{\"POSITION\":%i,\"COLOR_0\":%i},\"indices\":%i}]}", pos_acc, col_acc, idx_acc);
+  nodes_json="{\"name\":\"Mesh\",\"mesh\":0}";
+  unsigned num_meshes=1;
+
+  // add instanced sphere mesh
+  if(sphere_insts.translations.size())
+  {
+    unsigned spos_acc=glb.add_vec3_accessor((const vec3f*)s_sphere_vtx_pos, sphere_num_vtx, gltf_target_vertices, true);
+    unsigned sidx_acc=glb.add_accessor(glb.add_view(s_sphere_tidx, sizeof(s_sphere_tidx), gltf_target_indices), gltftype_ubyte, sphere_num_tris*3, "SCALAR");
+    meshes_json.push_back_format(",{\"name\":\"Sphere\",\"primitives\":[{\"attributes\":{\"POSITION\":%i},\"indices\":%i}]}", spos_acc, sidx_acc);
+    sphere_insts.write_node(nodes_json, glb, "Spheres", num_meshes++);
   }
 
-  // export Collada footer
-  fout_<<
-  R"(    </visual_scene>)""\r\n"
-  R"(  </library_visual_scenes>)""\r\n"
-  R"(  <scene>)""\r\n"
-  R"(    <instance_visual_scene url="#Scene"/>)""\r\n"
-  R"(  </scene>)""\r\n"
-  R"(</COLLADA>)""\r\n";
+  // add instanced green/red cone meshes sharing the cone geometry
+  if(green_cone_insts.translations.size() || red_cone_insts.translations.size())
+  {
+    unsigned cpos_acc=glb.add_vec3_accessor((const vec3f*)s_cone_vtx_pos, cone_num_vtx, gltf_target_vertices, true);
+    unsigned cidx_acc=glb.add_accessor(glb.add_view(s_cone_tidx, sizeof(s_cone_tidx), gltf_target_indices), gltftype_ubyte, cone_num_tris*3, "SCALAR");
+    meshes_json.push_back_format(",{\"name\":\"GreenCone\",\"primitives\":[{\"attributes\":{\"POSITION\":%i},\"indices\":%i,\"material\":0}]}", cpos_acc, cidx_acc);
+    meshes_json.push_back_format(",{\"name\":\"RedCone\",\"primitives\":[{\"attributes\":{\"POSITION\":%i},\"indices\":%i,\"material\":1}]}", cpos_acc, cidx_acc);
+    if(green_cone_insts.translations.size())
+      green_cone_insts.write_node(nodes_json, glb, "GreenCones", num_meshes);
+    if(red_cone_insts.translations.size())
+      red_cone_insts.write_node(nodes_json, glb, "RedCones", num_meshes+1);
+    num_meshes+=2;
+  }
+
+  // setup glTF JSON with a Z-up to Y-up root node
+  unsigned num_nodes=1+(sphere_insts.translations.size()?1:0)+(green_cone_insts.translations.size()?1:0)+(red_cone_insts.translations.size()?1:0);
+  heap_str json;
+  json="{\"asset\":{\"version\":\"2.0\",\"generator\":\"Meshlete\"},";
+  if(num_nodes>1)
+    json+="\"extensionsUsed\":[\"EXT_mesh_gpu_instancing\"],";
+  json+="\"scene\":0,\"scenes\":[{\"nodes\":[0]}],"
+       "\"nodes\":[{\"name\":\"Meshlets\",\"rotation\":[-0.70710678,0,0,0.70710678],\"children\":[";
+  for(unsigned i=0; i<num_nodes; ++i)
+    json.push_back_format("%s%i", i?",":"", i+1);
+  json+="]},";
+  json+=nodes_json.c_str();
+  json+="],\"meshes\":[";
+  json+=meshes_json.c_str();
+  json+="],\"materials\":[{\"name\":\"GreenCone\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[0,1,0,1]}},"
+                         "{\"name\":\"RedCone\",\"pbrMetallicRoughness\":{\"baseColorFactor\":[1,0,0,1]}}],"
+       "\"accessors\":[";
+  json+=glb.accessors_json.c_str();
+  json+="],\"bufferViews\":[";
+  json+=glb.views_json.c_str();
+  json.push_back_format("],\"buffers\":[{\"byteLength\":%zi}]}", glb.bin.size());
+  while(json.size()&3)
+    json+=" ";
+
+  // write GLB header and JSON & BIN chunks (little-endian host)
+  uint32_t header[5]={0x46546c67, 2, uint32_t(12+8+json.size()+8+glb.bin.size()), uint32_t(json.size()), 0x4e4f534a};
+  fout_.write_bytes(header, sizeof(header));
+  fout_.write_bytes(json.c_str(), json.size());
+  uint32_t bin_header[2]={uint32_t(glb.bin.size()), 0x004e4942};
+  fout_.write_bytes(bin_header, sizeof(bin_header));
+  fout_.write_bytes(glb.bin.data(), glb.bin.size());
   return true;
 }
 //----------------------------------------------------------------------------
@@ -23,11 +23,13 @@ struct p3g_meshlet;
 class bin_output_stream_base;
 
 // new
-enum {p3g_file_version=0x1000};  // v1.0
+enum {p3g_file_version=0x1000};        // v1.0
+enum {p3g_file_version_large=0x1100};  // v1.1 (p3gflag_large layout)
 struct export_cfg_p3g;
 struct export_cfg_dae;
 bool export_p3g(bin_output_stream_base&, const export_cfg_p3g&, const mesh_geometry&, const p3g_mesh_geometry&);
 bool export_dae(bin_output_stream_base&, const export_cfg_dae&, const mesh_geometry&, const p3g_mesh_geometry&);
+bool export_glb(bin_output_stream_base&, const export_cfg_dae&, const mesh_geometry&, const p3g_mesh_geometry&);
 //----------------------------------------------------------------------------
 
 
@@ -40,6 +42,10 @@ enum e_p3g_flags
   p3gflag_tristrips   = 0x0002,  // tri-strips meshlets (instead of tri-lists)
   p3gflag_bvols       = 0x0004,  // store meshlet bounding volumes
   p3gflag_vcones      = 0x0008,  // store meshlet visibility cones
+  p3gflag_local_vbuf  = 0x0010,  // meshlet-local vertex blocks in the vertex buffer (no vertex index buffer, meshlet vertex offset to the block)
+  p3gflag_packed_vidx = 0x0020,  // bitpacked meshlet vertex indices (see decode_p3g_packed_vidx())
+  p3gflag_packed_tidx = 0x0040,  // bitpacked meshlet triangle indices (see decode_p3g_packed_tri())
+  p3gflag_large       = 0x0080,  // large layout (v1.1) with 32-bit meshlet/segment counts and meshlet data offsets
 };
 //----------------------------------------------------------------------------
 
@@ -51,6 +57,7 @@ struct export_cfg_dae
 {
   bool export_meshlet_bvols;
   bool export_meshlet_vcones;
+  bool merge_instances;  // bake bounding sphere and visibility cone instances to single meshes (instead of per-meshlet nodes, ignored by export_glb())
 };
 //----------------------------------------------------------------------------
 
@@ -62,6 +69,10 @@ struct export_cfg_p3g
 {
   bool export_meshlet_bvols;
   bool export_meshlet_vcones;
+  bool local_vbuf;
+  bool packed_vidx;
+  bool packed_tidx;
+  bool log_stats;  // log layout and data size stats
   uint32_t vbuf_align;
 };
 //----------------------------------------------------------------------------
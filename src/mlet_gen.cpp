@@ -12,6 +12,7 @@
 #include "sxp_src/core/math/tform3.h"
 #include "sxp_src/core/sort.h"
 #include <algorithm>
+#include <chrono>
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -114,7 +115,7 @@ void pfc::dequantize_meshlet_vcone(vec3f &out_dir_, float &out_dot_, const int8_
 //============================================================================
 // generate_meshlets
 //============================================================================
-void pfc::generate_meshlets(const meshlet_gen_cfg &cfg_, const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo_)
+void pfc::generate_meshlets(const meshlet_gen_cfg &cfg_, const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo_, array<double> *seg_times_)
 {
   usize_t num_segs=mgeo_.num_segs;
   p3g_geo_.segs.resize(num_segs);
@@ -122,6 +123,7 @@ void pfc::generate_meshlets(const meshlet_gen_cfg &cfg_, const mesh_geometry &mg
   p3g_geo_.is_stripified=cfg_.mlet_stripify;
   for(usize_t seg_idx=0; seg_idx<num_segs; ++seg_idx)
   {
+    std::chrono::steady_clock::time_point seg_start=std::chrono::steady_clock::now();
     // access segment data
     const mesh_geometry_segment &mgseg=mgeo_.segs[seg_idx];
     p3g_mesh_segment &p3g_seg=p3g_geo_.segs[seg_idx];
@@ -359,6 +361,8 @@ void pfc::generate_meshlets(const meshlet_gen_cfg &cfg_, const mesh_geometry &mg
     p3g_seg.num_vidx=(uint32_t)p3g_geo_.mlet_vidx.size()-p3g_seg.start_vidx;
     p3g_seg.num_tidx=(uint32_t)p3g_geo_.mlet_tidx.size()-p3g_seg.start_tidx;
     p3g_seg.num_mlets=num_mlets;
+    if(seg_times_)
+      seg_times_->push_back(std::chrono::duration<double>(std::chrono::steady_clock::now()-seg_start).count());
   }
 }
 //----------------------------------------------------------------------------
@@ -367,10 +371,11 @@ void pfc::generate_meshlets(const meshlet_gen_cfg &cfg_, const mesh_geometry &mg
 //============================================================================
 // generate_bvols
 //============================================================================
-void pfc::generate_bvols(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo_)
+void pfc::generate_bvols(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo_, array<double> *seg_times_)
 {
   for(usize_t seg_idx=0; seg_idx<mgeo_.num_segs; ++seg_idx)
   {
+    std::chrono::steady_clock::time_point seg_start=std::chrono::steady_clock::now();
     // calculate segment bounding volume
     const mesh_geometry_segment &mgseg=mgeo_.segs[seg_idx];
     p3g_mesh_segment &p3g_seg=p3g_geo_.segs[seg_idx];
@@ -394,6 +399,8 @@ void pfc::generate_bvols(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo_
       quantize_meshlet_bvol(mlet.qbvol_pos, mlet.qbvol_rad, mlet_bvol, seg_bvol);
       vtx_idx+=mlet.num_vtx;
     }
+    if(seg_times_)
+      seg_times_->push_back(std::chrono::duration<double>(std::chrono::steady_clock::now()-seg_start).count());
   }
 }
 //----------------------------------------------------------------------------
@@ -527,7 +534,7 @@ private:
 //============================================================================
 // generate_vcones
 //============================================================================
-void pfc::generate_vcones(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo_, unsigned num_views_, uint16_t view_res_)
+void pfc::generate_vcones(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo_, unsigned num_views_, uint16_t view_res_, bool log_progress_)
 {
   // rasterizer config
   uint16_t view_width=view_res_, view_height=view_res_;
@@ -537,7 +544,8 @@ void pfc::generate_vcones(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo
   enum {max_cluster_strips=512};
   enum {shader_store_size=max_dispatches*128};
   enum {num_tiles=1};
-  logf("> Generating meshlet visibility cones (%i views, %ix%i)...\r\n", num_views_, view_width, view_height);
+  if(log_progress_)
+    logf("> Generating meshlet visibility cones (%i views, %ix%i)...\r\n", num_views_, view_width, view_height);
 
   // alloc rasterizer resources
   uint16_t tile_width=view_width, tile_height=view_height;
@@ -599,7 +607,8 @@ void pfc::generate_vcones(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo
   uint8_t *meshlet_visibility_data=(uint8_t*)meshlet_visibility.data;
   mem_zero(meshlet_visibility_data, num_views_*view_visibility_size);
   array<vec3f> view_dirs(num_views_);
-  logf("> --------------------------------------------------\r\n> ");
+  if(log_progress_)
+    logf("> --------------------------------------------------\r\n> ");
   unsigned old_pos=0;
   for(unsigned view_idx=0; view_idx<num_views_; ++view_idx)
   {
@@ -639,13 +648,14 @@ void pfc::generate_vcones(const mesh_geometry &mgeo_, p3g_mesh_geometry &p3g_geo
     } while(++midx_data<midx_data_end);
     meshlet_visibility_data+=view_visibility_size;
     unsigned new_pos=unsigned(50.0f*float(view_idx+1)/num_views_+0.5f);
-    while(old_pos<new_pos)
+    while(log_progress_ && old_pos<new_pos)
     {
       logf("#");
       ++old_pos;
     }
   }
-  logf("\r\n");
+  if(log_progress_)
+    logf("\r\n");
 
   // build visibility cones for meshlets
   owner_data visibility_points=PFC_MEM_ALLOC(num_views_*sizeof(vec3f));
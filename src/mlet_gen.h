@@ -29,9 +29,9 @@ struct p3g_mesh_geometry;
 sphere3f dequantize_segment_bvol(const int16_t *qbvol_pos_, uint16_t qbvol_rad_, const sphere3f &mesh_bvol_);
 sphere3f dequantize_meshlet_bvol(const int8_t *qbvol_pos_, uint8_t qbvol_rad_, const sphere3f &seg_bvol_);
 void dequantize_meshlet_vcone(vec3f &out_dir_, float &out_dot_, const int8_t *qvcone_dir_, int8_t qvcone_dot_);
-void generate_meshlets(const meshlet_gen_cfg&, const mesh_geometry&, p3g_mesh_geometry&);
-void generate_bvols(const mesh_geometry&, p3g_mesh_geometry&);
-void generate_vcones(const mesh_geometry&, p3g_mesh_geometry&, unsigned num_views_, uint16_t view_res_);
+void generate_meshlets(const meshlet_gen_cfg&, const mesh_geometry&, p3g_mesh_geometry&, array<double> *seg_times_=0);
+void generate_bvols(const mesh_geometry&, p3g_mesh_geometry&, array<double> *seg_times_=0);
+void generate_vcones(const mesh_geometry&, p3g_mesh_geometry&, unsigned num_views_, uint16_t view_res_, bool log_progress_=true);
 //----------------------------------------------------------------------------
 
 
@@ -0,0 +1,104 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_P3G_DECODE_H
+#define PFC_MESHLETE_P3G_DECODE_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "sxp_src/core/core.h"
+namespace pfc
+{
+
+// new
+enum {p3g_packed_tidx_guard_size=4};
+PFC_INLINE uint32_t p3g_packed_vidx_size(const uint32_t *stream_, unsigned num_vtx_);
+PFC_INLINE void decode_p3g_packed_vidx(uint32_t *res_, const uint32_t *stream_, unsigned num_vtx_);
+PFC_INLINE unsigned p3g_packed_tidx_width(unsigned num_vtx_);
+PFC_INLINE void decode_p3g_packed_tri(uint8_t vidx_[3], const uint8_t *tibuf_, unsigned width_, unsigned tri_idx_);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// packed meshlet vertex indices
+//============================================================================
+// With p3gflag_packed_vidx the meshlet vertex offset points to a 32-bit
+// aligned stream: header dword with the base vertex index in the low 27 bits
+// and the delta bit width in the high 5 bits, followed by num_vtx deltas from
+// the base index bitpacked LSB-first to dwords.
+PFC_INLINE uint32_t p3g_packed_vidx_size(const uint32_t *stream_, unsigned num_vtx_)
+{
+  // return stream size in bytes
+  return 4+((num_vtx_*(stream_[0]>>27)+31)/32)*4;
+}
+//----
+
+PFC_INLINE void decode_p3g_packed_vidx(uint32_t *res_, const uint32_t *stream_, unsigned num_vtx_)
+{
+  // unpack vertex index deltas and add the base index
+  const uint32_t base=stream_[0]&0x07ffffff;
+  const unsigned width=stream_[0]>>27;
+  const uint32_t mask=(uint32_t(1)<<width)-1;
+  if(!width)
+  {
+    // all vertex indices equal to the base index
+    for(unsigned i=0; i<num_vtx_; ++i)
+      res_[i]=base;
+    return;
+  }
+  const uint32_t *words=stream_+1;
+  for(unsigned i=0, bit_pos=0; i<num_vtx_; ++i, bit_pos+=width)
+  {
+    const uint32_t *w=words+(bit_pos>>5);
+    const unsigned shift=bit_pos&31;
+    uint64_t bits=w[0];
+    if(shift+width>32)
+      bits|=uint64_t(w[1])<<32;
+    res_[i]=base+(uint32_t(bits>>shift)&mask);
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// packed meshlet triangle indices
+//============================================================================
+// With p3gflag_packed_tidx the meshlet triangle offset points to the meshlet
+// local vertex indices bitpacked LSB-first to bytes with the minimal width
+// for the meshlet vertex count. The triangle index buffer is followed by
+// p3g_packed_tidx_guard_size bytes so that each triangle can be decoded with
+// a single 32-bit read (3*8 index bits + 7 bits of byte offset).
+PFC_INLINE unsigned p3g_packed_tidx_width(unsigned num_vtx_)
+{
+  // return number of bits needed for the meshlet local vertex indices
+  unsigned width=0;
+  while(num_vtx_>(1u<<width))
+    ++width;
+  return width;
+}
+//----
+
+PFC_INLINE void decode_p3g_packed_tri(uint8_t vidx_[3], const uint8_t *tibuf_, unsigned width_, unsigned tri_idx_)
+{
+  // read the triangle bits with byte loads (no unaligned access) and extract the indices
+  const unsigned bit_pos=tri_idx_*3*width_;
+  const uint8_t *p=tibuf_+(bit_pos>>3);
+  const uint32_t bits=(uint32_t(p[0])|(uint32_t(p[1])<<8)|(uint32_t(p[2])<<16)|(uint32_t(p[3])<<24))>>(bit_pos&7);
+  const uint32_t mask=(uint32_t(1)<<width_)-1;
+  vidx_[0]=uint8_t(bits&mask);
+  vidx_[1]=uint8_t((bits>>width_)&mask);
+  vidx_[2]=uint8_t((bits>>(2*width_))&mask);
+}
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
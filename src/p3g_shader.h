@@ -0,0 +1,244 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_P3G_SHADER_H
+#define PFC_MESHLETE_P3G_SHADER_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "p3g_view.h"
+#include "rasterizer/rasterizer.h"
+#include "sxp_src/core/math/tform3.h"
+namespace pfc
+{
+
+// new
+template<class VtxDecoder> struct p3g_shader_base;
+PFC_INLINE bool is_vcone_culled(const vec3f &to_view_, const vec3f &vcone_dir_, float vcone_dot_, float bvol_rad_);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// p3g_shader_base
+//============================================================================
+// Rasterizer shader base feeding meshlets of a P3G segment directly from
+// p3g_view. Meshlets are culled against the view with the meshlet bounding
+// spheres and visibility cones (when present in the data) and binned with
+// the bounding spheres, which also provides the min-z for Hi-Z culling.
+// VtxDecoder interprets the vertex format of the data:
+//
+//   struct vtx_decoder
+//   {
+//     enum {vtx_size=<vertex size in bytes>};
+//     struct vout {vec4f pos; ...};
+//     void tform_vertex(vout &res_, const void *vtx_, const mat44f &o2p_) const;
+//   };
+//
+// The derived shader provides shade_pixel() and the shader config. Object to
+// view transform must be rigid for the culling.
+template<class VtxDecoder>
+struct p3g_shader_base: rasterizer_shader_base
+{
+  typedef typename VtxDecoder::vout vout;
+  //--------------------------------------------------------------------------
+
+  // setup
+  void set_segment(const p3g_view&, unsigned seg_idx_);
+  void set_transform(const tform3f &o2v_, const mat44f &v2p_);
+  //--------------------------------------------------------------------------
+
+  // rasterizer shader interface
+  PFC_INLINE rasterizer_local_cluster_index_t init_shader() const;
+  void setup_cluster(rasterizer_tiling&, rasterizer_dispatch_index_t, rasterizer_local_cluster_index_t) const;
+  PFC_INLINE const void *cluster(rasterizer_local_cluster_index_t) const;
+  PFC_INLINE uint8_t num_cluster_vertices(const void *cluster_) const;
+  PFC_INLINE uint8_t num_cluster_triangles(const void *cluster_) const;
+  void tform_cluster(vout *tform_cache_, const void *cluster_) const;
+  PFC_INLINE void setup_primitive(const vout *vtx_, const void *cluster_, uint8_t prim_idx_, uint8_t vidx_[3], vec4f vpos_[3]) const;
+  //--------------------------------------------------------------------------
+
+  // data
+  VtxDecoder vdec;
+  const p3g_view *p3g;
+  unsigned start_mlet;
+  unsigned num_mlets;
+  sphere3f seg_bvol;
+  tform3f o2v;
+  mat44f v2p;
+  mat44f o2p;
+  vec3f view_pos;  // view position in object space
+};
+//----------------------------------------------------------------------------
+
+
+
+
+//============================================================================
+//============================================================================
+// inline & template implementations
+//============================================================================
+//============================================================================
+
+
+//============================================================================
+// is_vcone_culled
+//============================================================================
+PFC_INLINE bool is_vcone_culled(const vec3f &to_view_, const vec3f &vcone_dir_, float vcone_dot_, float bvol_rad_)
+{
+  // the view direction from any point of the bounding sphere deviates from
+  // to_view by up to bvol_rad/|to_view|, which affects both terms of the
+  // test, so scale the radius margin accordingly to keep the test conservative
+  return dot(to_view_, vcone_dir_)<vcone_dot_*norm(to_view_)-bvol_rad_*(1.0f+abs(vcone_dot_));
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// p3g_shader_base
+//============================================================================
+template<class VtxDecoder>
+void p3g_shader_base<VtxDecoder>::set_segment(const p3g_view &p3g_, unsigned seg_idx_)
+{
+  PFC_ASSERT(p3g_.is_valid());
+  p3g=&p3g_;
+  start_mlet=p3g_.segment_start_meshlet(seg_idx_);
+  num_mlets=p3g_.segment_num_meshlets(seg_idx_);
+  seg_bvol=p3g_.segment_bvol(seg_idx_);
+}
+//----
+
+template<class VtxDecoder>
+void p3g_shader_base<VtxDecoder>::set_transform(const tform3f &o2v_, const mat44f &v2p_)
+{
+  o2v=o2v_;
+  v2p=v2p_;
+  o2p=o2v_*v2p_;
+  view_pos=vec3f(0.0f, 0.0f, 0.0f)*inv(o2v_);
+}
+//----
+
+template<class VtxDecoder>
+rasterizer_local_cluster_index_t p3g_shader_base<VtxDecoder>::init_shader() const
+{
+  return (rasterizer_local_cluster_index_t)num_mlets;
+}
+//----
+
+template<class VtxDecoder>
+void p3g_shader_base<VtxDecoder>::setup_cluster(rasterizer_tiling &tiling_, rasterizer_dispatch_index_t dispatch_idx_, rasterizer_local_cluster_index_t cluster_idx_) const
+{
+  // bin the whole segment if there are no meshlet bounds
+  const unsigned mlet_idx=start_mlet+cluster_idx_;
+  const uint16_t flags=p3g->flags();
+  if(!(flags&p3gflag_bvols))
+  {
+    tiling_.add_cluster(dispatch_idx_, cluster_idx_);
+    return;
+  }
+
+  // cull meshlets behind the view
+  const sphere3f bvol=p3g->meshlet_bvol(mlet_idx, seg_bvol);
+  const vec3f vpos=bvol.pos*o2v;
+  if(vpos.z+bvol.rad<=0.0f)
+    return;
+
+  // cull meshlets with the view direction outside the visibility cone
+  if(flags&p3gflag_vcones)
+  {
+    vec3f vcone_dir;
+    float vcone_dot;
+    p3g->meshlet_vcone(vcone_dir, vcone_dot, mlet_idx);
+    if(is_vcone_culled(view_pos-bvol.pos, vcone_dir, vcone_dot, bvol.rad))
+      return;
+  }
+
+  // bin the meshlet with the view space bounding sphere
+  tiling_.add_cluster(v2p, vpos, bvol.rad, dispatch_idx_, cluster_idx_);
+}
+//----
+
+template<class VtxDecoder>
+const void *p3g_shader_base<VtxDecoder>::cluster(rasterizer_local_cluster_index_t cluster_idx_) const
+{
+  return &p3g->meshlet(start_mlet+cluster_idx_);
+}
+//----
+
+template<class VtxDecoder>
+uint8_t p3g_shader_base<VtxDecoder>::num_cluster_vertices(const void *cluster_) const
+{
+  return uint8_t(p3g->meshlet_num_vertices(*(const p3g_file_meshlet*)cluster_));
+}
+//----
+
+template<class VtxDecoder>
+uint8_t p3g_shader_base<VtxDecoder>::num_cluster_triangles(const void *cluster_) const
+{
+  return uint8_t(p3g->meshlet_num_triangles(*(const p3g_file_meshlet*)cluster_));
+}
+//----
+
+template<class VtxDecoder>
+void p3g_shader_base<VtxDecoder>::tform_cluster(vout *tform_cache_, const void *cluster_) const
+{
+  // transform meshlet vertices with the vertex index format specific loop
+  enum {vtx_size=VtxDecoder::vtx_size};
+  const p3g_file_meshlet &mlet=*(const p3g_file_meshlet*)cluster_;
+  const unsigned num_vtx=p3g->meshlet_num_vertices(mlet);
+  const uint16_t flags=p3g->flags();
+  const uint8_t *vbuf=(const uint8_t*)p3g->vbuf();
+  const void *vdata=p3g->meshlet_vertex_data(mlet);
+  if(flags&p3gflag_local_vbuf)
+  {
+    // meshlet-local vertex block
+    const uint8_t *vtx=(const uint8_t*)vdata;
+    for(unsigned i=0; i<num_vtx; ++i, vtx+=vtx_size)
+      vdec.tform_vertex(tform_cache_[i], vtx, o2p);
+  }
+  else if(flags&p3gflag_packed_vidx)
+  {
+    // bitpacked vertex indices
+    uint32_t vidx[255];
+    decode_p3g_packed_vidx(vidx, (const uint32_t*)vdata, num_vtx);
+    for(unsigned i=0; i<num_vtx; ++i)
+      vdec.tform_vertex(tform_cache_[i], vbuf+vidx[i]*vtx_size, o2p);
+  }
+  else if(flags&p3gflag_32bit_index)
+  {
+    // 32-bit vertex indices
+    const uint32_t *vidx=(const uint32_t*)vdata;
+    for(unsigned i=0; i<num_vtx; ++i)
+      vdec.tform_vertex(tform_cache_[i], vbuf+vidx[i]*vtx_size, o2p);
+  }
+  else
+  {
+    // 16-bit vertex indices
+    const uint16_t *vidx=(const uint16_t*)vdata;
+    for(unsigned i=0; i<num_vtx; ++i)
+      vdec.tform_vertex(tform_cache_[i], vbuf+vidx[i]*vtx_size, o2p);
+  }
+}
+//----
+
+template<class VtxDecoder>
+void p3g_shader_base<VtxDecoder>::setup_primitive(const vout *vtx_, const void *cluster_, uint8_t prim_idx_, uint8_t vidx_[3], vec4f vpos_[3]) const
+{
+  // decode triangle indices and fetch the transformed positions
+  p3g->meshlet_triangle(vidx_, *(const p3g_file_meshlet*)cluster_, prim_idx_);
+  vpos_[0]=vtx_[vidx_[0]].pos;
+  vpos_[1]=vtx_[vidx_[1]].pos;
+  vpos_[2]=vtx_[vidx_[2]].pos;
+}
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
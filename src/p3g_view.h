@@ -0,0 +1,565 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_P3G_VIEW_H
+#define PFC_MESHLETE_P3G_VIEW_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "export.h"
+#include "mlet_gen.h"
+#include "p3g_decode.h"
+namespace pfc
+{
+
+// new
+struct p3g_file_header;
+struct p3g_file_header_large;
+struct p3g_file_segment;
+struct p3g_file_segment_large;
+struct p3g_file_meshlet;
+class p3g_view;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// p3g_file_header
+//============================================================================
+// P3G data records as laid out by export_p3g() (little-endian)
+struct p3g_file_header
+{
+  char id[4];
+  uint16_t version;
+  uint16_t flags;
+  uint32_t size;
+  uint16_t num_mlets;
+  uint8_t num_segs;
+  uint8_t vfmt_id;
+  uint32_t offs_vbuf;
+  uint32_t vbuf_size;
+  float32_t bvol_pos[3];
+  float32_t bvol_rad;
+};
+//----
+
+struct p3g_file_header_large
+{
+  char id[4];
+  uint16_t version;
+  uint16_t flags;
+  uint32_t size;
+  uint32_t num_mlets;
+  uint32_t num_segs;
+  uint8_t vfmt_id;
+  uint8_t pad[3];
+  uint32_t offs_vbuf;
+  uint32_t vbuf_size;
+  float32_t bvol_pos[3];
+  float32_t bvol_rad;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// p3g_file_segment
+//============================================================================
+struct p3g_file_segment
+{
+  uint32_t material_id;
+  uint16_t start_mlet;
+  uint16_t num_mlets;
+  int16_t qbvol_pos[3];
+  uint16_t qbvol_rad;
+};
+//----
+
+struct p3g_file_segment_large
+{
+  uint32_t material_id;
+  uint32_t start_mlet;
+  uint32_t num_mlets;
+  int16_t qbvol_pos[3];
+  uint16_t qbvol_rad;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// p3g_file_meshlet
+//============================================================================
+// Meshlet record header. In the large layout (p3gflag_large) the fields are
+// 32-bit offsets followed by a counts dword (num vertices | num triangles<<8).
+// Quantized bounding sphere (p3gflag_bvols) and visibility cone
+// (p3gflag_vcones) follow the header when present.
+struct p3g_file_meshlet
+{
+  uint32_t vtx;  // vertex data offset (24 bits) | num vertices (8 bits)
+  uint32_t tri;  // triangle index data offset (24 bits) | num triangles (8 bits)
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// p3g_view
+//============================================================================
+// Read-only view of P3G data in memory (e.g. memory-mapped file or data in
+// ROM/flash). The view validates the data upon init() and provides typed
+// accessors directly to the data without allocating or copying it. Both the
+// standard (v1.0) and the large (v1.1) layouts are supported.
+class p3g_view
+{
+public:
+  // construction
+  PFC_INLINE p3g_view();
+  PFC_INLINE bool init(const void *data_, usize_t size_);
+  //--------------------------------------------------------------------------
+
+  // mesh accessors
+  PFC_INLINE bool is_valid() const;
+  PFC_INLINE uint16_t version() const;
+  PFC_INLINE uint16_t flags() const;
+  PFC_INLINE uint32_t size() const;
+  PFC_INLINE uint8_t vfmt_id() const;
+  PFC_INLINE sphere3f bvol() const;
+  PFC_INLINE const void *vbuf() const;
+  PFC_INLINE uint32_t vbuf_size() const;
+  //--------------------------------------------------------------------------
+
+  // segment accessors
+  PFC_INLINE unsigned num_segments() const;
+  PFC_INLINE uint32_t segment_material_id(unsigned seg_idx_) const;
+  PFC_INLINE unsigned segment_start_meshlet(unsigned seg_idx_) const;
+  PFC_INLINE unsigned segment_num_meshlets(unsigned seg_idx_) const;
+  PFC_INLINE sphere3f segment_bvol(unsigned seg_idx_) const;
+  //--------------------------------------------------------------------------
+
+  // meshlet accessors
+  PFC_INLINE unsigned num_meshlets() const;
+  PFC_INLINE const p3g_file_meshlet &meshlet(unsigned mlet_idx_) const;
+  PFC_INLINE unsigned meshlet_num_vertices(unsigned mlet_idx_) const;
+  PFC_INLINE unsigned meshlet_num_vertices(const p3g_file_meshlet&) const;
+  PFC_INLINE unsigned meshlet_num_triangles(unsigned mlet_idx_) const;
+  PFC_INLINE unsigned meshlet_num_triangles(const p3g_file_meshlet&) const;
+  PFC_INLINE sphere3f meshlet_bvol(unsigned mlet_idx_, const sphere3f &seg_bvol_) const;
+  PFC_INLINE void meshlet_vcone(vec3f &out_dir_, float &out_dot_, unsigned mlet_idx_) const;
+  PFC_INLINE const void *meshlet_vertex_data(unsigned mlet_idx_) const;
+  PFC_INLINE const void *meshlet_vertex_data(const p3g_file_meshlet&) const;
+  PFC_INLINE const uint8_t *meshlet_triangle_data(unsigned mlet_idx_) const;
+  PFC_INLINE const uint8_t *meshlet_triangle_data(const p3g_file_meshlet&) const;
+  PFC_INLINE void meshlet_vertex_indices(uint32_t *res_, unsigned mlet_idx_) const;
+  PFC_INLINE void meshlet_triangle(uint8_t vidx_[3], unsigned mlet_idx_, unsigned tri_idx_) const;
+  PFC_INLINE void meshlet_triangle(uint8_t vidx_[3], const p3g_file_meshlet&, unsigned tri_idx_) const;
+  //--------------------------------------------------------------------------
+
+private:
+  p3g_view(const p3g_view&); // not implemented
+  void operator=(const p3g_view&); // not implemented
+  PFC_INLINE static void get_meshlet(const p3g_file_meshlet&, bool is_large_, uint32_t &offs_vtx_, uint32_t &offs_tri_, unsigned &num_vtx_, unsigned &num_tris_);
+  PFC_INLINE const int16_t *segment_qbvol(unsigned seg_idx_) const;
+  //--------------------------------------------------------------------------
+
+  const uint8_t *m_data;
+  const float32_t *m_bvol;
+  const uint8_t *m_segs;
+  const uint8_t *m_mlets;
+  uint32_t m_size;
+  uint32_t m_num_segs;
+  uint32_t m_num_mlets;
+  uint32_t m_offs_vbuf;
+  uint32_t m_vbuf_size;
+  uint16_t m_version;
+  uint16_t m_flags;
+  uint8_t m_vfmt_id;
+  uint8_t m_seg_size;
+  uint8_t m_mlet_size;
+  bool m_is_large;
+};
+//----------------------------------------------------------------------------
+
+
+
+
+//============================================================================
+//============================================================================
+// inline & template implementations
+//============================================================================
+//============================================================================
+
+
+//============================================================================
+// p3g_view
+//============================================================================
+p3g_view::p3g_view()
+{
+  m_data=0;
+  m_bvol=0;
+  m_segs=0;
+  m_mlets=0;
+  m_size=0;
+  m_num_segs=0;
+  m_num_mlets=0;
+  m_offs_vbuf=0;
+  m_vbuf_size=0;
+  m_version=0;
+  m_flags=0;
+  m_vfmt_id=0;
+  m_seg_size=0;
+  m_mlet_size=0;
+  m_is_large=false;
+}
+//----
+
+bool p3g_view::init(const void *data_, usize_t size_)
+{
+  // validate header
+  m_data=0;
+  const uint8_t *data=(const uint8_t*)data_;
+  if(!data || (usize_t(data)&3) || size_<sizeof(p3g_file_header))
+    return false;
+  const p3g_file_header &hdr=*(const p3g_file_header*)data;
+  const uint16_t known_flags=p3gflag_32bit_index|p3gflag_tristrips|p3gflag_bvols|p3gflag_vcones|p3gflag_local_vbuf|p3gflag_packed_vidx|p3gflag_packed_tidx|p3gflag_large;
+  const bool is_large=(hdr.flags&p3gflag_large)!=0;
+  if(   hdr.id[0]!='p' || hdr.id[1]!='3' || hdr.id[2]!='d' || hdr.id[3]!='g'
+     || hdr.version!=(is_large?uint16_t(p3g_file_version_large):uint16_t(p3g_file_version))
+     || (hdr.flags&~known_flags)
+     || hdr.size>size_
+     || (is_large && size_<sizeof(p3g_file_header_large)))
+    return false;
+
+  // read layout specific header fields
+  uint32_t num_segs, num_mlets, offs_vbuf, vbuf_size;
+  uint8_t vfmt_id;
+  const float32_t *bvol;
+  if(is_large)
+  {
+    const p3g_file_header_large &lhdr=*(const p3g_file_header_large*)data;
+    num_segs=lhdr.num_segs;
+    num_mlets=lhdr.num_mlets;
+    offs_vbuf=lhdr.offs_vbuf;
+    vbuf_size=lhdr.vbuf_size;
+    vfmt_id=lhdr.vfmt_id;
+    bvol=lhdr.bvol_pos;
+  }
+  else
+  {
+    num_segs=hdr.num_segs;
+    num_mlets=hdr.num_mlets;
+    offs_vbuf=hdr.offs_vbuf;
+    vbuf_size=hdr.vbuf_size;
+    vfmt_id=hdr.vfmt_id;
+    bvol=hdr.bvol_pos;
+  }
+
+  // validate section ranges
+  const usize_t hdr_size=is_large?sizeof(p3g_file_header_large):sizeof(p3g_file_header);
+  const uint32_t seg_size=is_large?sizeof(p3g_file_segment_large):sizeof(p3g_file_segment);
+  const uint32_t mlet_size=(is_large?12:8)+(hdr.flags&p3gflag_bvols?4:0)+(hdr.flags&p3gflag_vcones?4:0);
+  const usize_t offs_mlets=hdr_size+usize_t(seg_size)*num_segs;
+  const usize_t offs_vibuf=offs_mlets+usize_t(mlet_size)*num_mlets;
+  if(offs_vibuf>offs_vbuf || usize_t(offs_vbuf)+vbuf_size!=hdr.size)
+    return false;
+  for(unsigned seg_idx=0; seg_idx<num_segs; ++seg_idx)
+  {
+    const uint8_t *seg=data+hdr_size+seg_size*seg_idx;
+    const uint32_t seg_end=is_large?((const p3g_file_segment_large*)seg)->start_mlet+((const p3g_file_segment_large*)seg)->num_mlets
+                                   :((const p3g_file_segment*)seg)->start_mlet+((const p3g_file_segment*)seg)->num_mlets;
+    if(seg_end>num_mlets)
+      return false;
+  }
+
+  // validate meshlet data ranges
+  const bool is_packed_vidx=(hdr.flags&p3gflag_packed_vidx)!=0;
+  const bool is_packed_tidx=(hdr.flags&p3gflag_packed_tidx)!=0;
+  const uint32_t vidx_size=hdr.flags&p3gflag_32bit_index?4:2;
+  for(unsigned mlet_idx=0; mlet_idx<num_mlets; ++mlet_idx)
+  {
+    uint32_t offs_vtx, offs_tri;
+    unsigned num_vtx, num_tris;
+    get_meshlet(*(const p3g_file_meshlet*)(data+offs_mlets+mlet_size*mlet_idx), is_large, offs_vtx, offs_tri, num_vtx, num_tris);
+    if(hdr.flags&p3gflag_local_vbuf)
+    {
+      if(offs_vtx<offs_vbuf || offs_vtx>hdr.size)
+        return false;
+    }
+    else if(   offs_vtx<offs_vibuf || (is_packed_vidx && ((offs_vtx&3) || usize_t(offs_vtx)+4>offs_vbuf))
+            || usize_t(offs_vtx)+(is_packed_vidx?p3g_packed_vidx_size((const uint32_t*)(data+offs_vtx), num_vtx):num_vtx*vidx_size)>offs_vbuf)
+      return false;
+    const usize_t tri_data_size=is_packed_tidx?(num_tris*3*p3g_packed_tidx_width(num_vtx)+7)/8+p3g_packed_tidx_guard_size:num_tris*3;
+    if(offs_tri<offs_vibuf || offs_tri+tri_data_size>offs_vbuf)
+      return false;
+  }
+
+  // setup the view
+  m_data=data;
+  m_bvol=bvol;
+  m_segs=data+hdr_size;
+  m_mlets=data+offs_mlets;
+  m_size=hdr.size;
+  m_num_segs=num_segs;
+  m_num_mlets=num_mlets;
+  m_offs_vbuf=offs_vbuf;
+  m_vbuf_size=vbuf_size;
+  m_version=hdr.version;
+  m_flags=hdr.flags;
+  m_vfmt_id=vfmt_id;
+  m_seg_size=uint8_t(seg_size);
+  m_mlet_size=uint8_t(mlet_size);
+  m_is_large=is_large;
+  return true;
+}
+//----
+
+bool p3g_view::is_valid() const
+{
+  return m_data!=0;
+}
+//----
+
+uint16_t p3g_view::version() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_version;
+}
+//----
+
+uint16_t p3g_view::flags() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_flags;
+}
+//----
+
+uint32_t p3g_view::size() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_size;
+}
+//----
+
+uint8_t p3g_view::vfmt_id() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_vfmt_id;
+}
+//----
+
+sphere3f p3g_view::bvol() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return sphere3f(vec3f(m_bvol[0], m_bvol[1], m_bvol[2]), m_bvol[3]);
+}
+//----
+
+const void *p3g_view::vbuf() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_data+m_offs_vbuf;
+}
+//----
+
+uint32_t p3g_view::vbuf_size() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_vbuf_size;
+}
+//----------------------------------------------------------------------------
+
+unsigned p3g_view::num_segments() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_num_segs;
+}
+//----
+
+uint32_t p3g_view::segment_material_id(unsigned seg_idx_) const
+{
+  PFC_ASSERT_PEDANTIC(m_data && seg_idx_<m_num_segs);
+  return *(const uint32_t*)(m_segs+m_seg_size*seg_idx_);
+}
+//----
+
+unsigned p3g_view::segment_start_meshlet(unsigned seg_idx_) const
+{
+  PFC_ASSERT_PEDANTIC(m_data && seg_idx_<m_num_segs);
+  const uint8_t *seg=m_segs+m_seg_size*seg_idx_;
+  return m_is_large?((const p3g_file_segment_large*)seg)->start_mlet:((const p3g_file_segment*)seg)->start_mlet;
+}
+//----
+
+unsigned p3g_view::segment_num_meshlets(unsigned seg_idx_) const
+{
+  PFC_ASSERT_PEDANTIC(m_data && seg_idx_<m_num_segs);
+  const uint8_t *seg=m_segs+m_seg_size*seg_idx_;
+  return m_is_large?((const p3g_file_segment_large*)seg)->num_mlets:((const p3g_file_segment*)seg)->num_mlets;
+}
+//----
+
+sphere3f p3g_view::segment_bvol(unsigned seg_idx_) const
+{
+  const int16_t *qbvol=segment_qbvol(seg_idx_);
+  return dequantize_segment_bvol(qbvol, uint16_t(qbvol[3]), bvol());
+}
+//----------------------------------------------------------------------------
+
+unsigned p3g_view::num_meshlets() const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_num_mlets;
+}
+//----
+
+const p3g_file_meshlet &p3g_view::meshlet(unsigned mlet_idx_) const
+{
+  PFC_ASSERT_PEDANTIC(m_data && mlet_idx_<m_num_mlets);
+  return *(const p3g_file_meshlet*)(m_mlets+m_mlet_size*mlet_idx_);
+}
+//----
+
+unsigned p3g_view::meshlet_num_vertices(unsigned mlet_idx_) const
+{
+  return meshlet_num_vertices(meshlet(mlet_idx_));
+}
+//----
+
+unsigned p3g_view::meshlet_num_vertices(const p3g_file_meshlet &mlet_) const
+{
+  return m_is_large?((const uint32_t*)&mlet_)[2]&0xff:mlet_.vtx>>24;
+}
+//----
+
+unsigned p3g_view::meshlet_num_triangles(unsigned mlet_idx_) const
+{
+  return meshlet_num_triangles(meshlet(mlet_idx_));
+}
+//----
+
+unsigned p3g_view::meshlet_num_triangles(const p3g_file_meshlet &mlet_) const
+{
+  return m_is_large?(((const uint32_t*)&mlet_)[2]>>8)&0xff:mlet_.tri>>24;
+}
+//----
+
+sphere3f p3g_view::meshlet_bvol(unsigned mlet_idx_, const sphere3f &seg_bvol_) const
+{
+  PFC_ASSERT_MSG(m_flags&p3gflag_bvols, ("P3G data doesn't have meshlet bounding spheres\r\n"));
+  const uint8_t *qbvol=(const uint8_t*)&meshlet(mlet_idx_)+(m_is_large?12:8);
+  return dequantize_meshlet_bvol((const int8_t*)qbvol, qbvol[3], seg_bvol_);
+}
+//----
+
+void p3g_view::meshlet_vcone(vec3f &out_dir_, float &out_dot_, unsigned mlet_idx_) const
+{
+  PFC_ASSERT_MSG(m_flags&p3gflag_vcones, ("P3G data doesn't have meshlet visibility cones\r\n"));
+  const int8_t *qvcone=(const int8_t*)&meshlet(mlet_idx_)+(m_is_large?12:8)+(m_flags&p3gflag_bvols?4:0);
+  dequantize_meshlet_vcone(out_dir_, out_dot_, qvcone, qvcone[3]);
+}
+//----
+
+const void *p3g_view::meshlet_vertex_data(unsigned mlet_idx_) const
+{
+  return meshlet_vertex_data(meshlet(mlet_idx_));
+}
+//----
+
+const void *p3g_view::meshlet_vertex_data(const p3g_file_meshlet &mlet_) const
+{
+  // return vertex index data (or the meshlet vertex block with p3gflag_local_vbuf)
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_data+(m_is_large?mlet_.vtx:mlet_.vtx&0x00ffffff);
+}
+//----
+
+const uint8_t *p3g_view::meshlet_triangle_data(unsigned mlet_idx_) const
+{
+  return meshlet_triangle_data(meshlet(mlet_idx_));
+}
+//----
+
+const uint8_t *p3g_view::meshlet_triangle_data(const p3g_file_meshlet &mlet_) const
+{
+  PFC_ASSERT_PEDANTIC(m_data);
+  return m_data+(m_is_large?mlet_.tri:mlet_.tri&0x00ffffff);
+}
+//----
+
+void p3g_view::meshlet_vertex_indices(uint32_t *res_, unsigned mlet_idx_) const
+{
+  // decode vertex indices of the meshlet to the result buffer
+  PFC_ASSERT_MSG(!(m_flags&p3gflag_local_vbuf), ("P3G data with meshlet-local vertex blocks doesn't have vertex indices\r\n"));
+  const p3g_file_meshlet &mlet=meshlet(mlet_idx_);
+  const unsigned num_vtx=meshlet_num_vertices(mlet);
+  const uint8_t *vidx=(const uint8_t*)meshlet_vertex_data(mlet);
+  if(m_flags&p3gflag_packed_vidx)
+    decode_p3g_packed_vidx(res_, (const uint32_t*)vidx, num_vtx);
+  else if(m_flags&p3gflag_32bit_index)
+    mem_copy(res_, vidx, num_vtx*4);
+  else
+    for(unsigned i=0; i<num_vtx; ++i)
+      res_[i]=((const uint16_t*)vidx)[i];
+}
+//----
+
+void p3g_view::meshlet_triangle(uint8_t vidx_[3], unsigned mlet_idx_, unsigned tri_idx_) const
+{
+  meshlet_triangle(vidx_, meshlet(mlet_idx_), tri_idx_);
+}
+//----
+
+void p3g_view::meshlet_triangle(uint8_t vidx_[3], const p3g_file_meshlet &mlet_, unsigned tri_idx_) const
+{
+  // get meshlet local vertex indices of the triangle
+  PFC_ASSERT_MSG(!(m_flags&p3gflag_tristrips), ("Triangle access to tri-strip meshlets isn't supported\r\n"));
+  PFC_ASSERT_PEDANTIC(tri_idx_<meshlet_num_triangles(mlet_));
+  const uint8_t *tidx=meshlet_triangle_data(mlet_);
+  if(m_flags&p3gflag_packed_tidx)
+    decode_p3g_packed_tri(vidx_, tidx, p3g_packed_tidx_width(meshlet_num_vertices(mlet_)), tri_idx_);
+  else
+  {
+    tidx+=tri_idx_*3;
+    vidx_[0]=tidx[0];
+    vidx_[1]=tidx[1];
+    vidx_[2]=tidx[2];
+  }
+}
+//----
+
+void p3g_view::get_meshlet(const p3g_file_meshlet &mlet_, bool is_large_, uint32_t &offs_vtx_, uint32_t &offs_tri_, unsigned &num_vtx_, unsigned &num_tris_)
+{
+  // decode meshlet record of the given layout
+  if(is_large_)
+  {
+    const uint32_t counts=((const uint32_t*)&mlet_)[2];
+    offs_vtx_=mlet_.vtx;
+    offs_tri_=mlet_.tri;
+    num_vtx_=counts&0xff;
+    num_tris_=(counts>>8)&0xff;
+  }
+  else
+  {
+    offs_vtx_=mlet_.vtx&0x00ffffff;
+    offs_tri_=mlet_.tri&0x00ffffff;
+    num_vtx_=mlet_.vtx>>24;
+    num_tris_=mlet_.tri>>24;
+  }
+}
+//----
+
+const int16_t *p3g_view::segment_qbvol(unsigned seg_idx_) const
+{
+  PFC_ASSERT_PEDANTIC(m_data && seg_idx_<m_num_segs);
+  const uint8_t *seg=m_segs+m_seg_size*seg_idx_;
+  return m_is_large?((const p3g_file_segment_large*)seg)->qbvol_pos:((const p3g_file_segment*)seg)->qbvol_pos;
+}
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
@@ -6,6 +6,13 @@
 //============================================================================
 
 #include "rasterizer.h"
+#if PFC_BUILDOP_RASTERIZER_MT==1
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#endif
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -24,6 +31,8 @@ rasterizer_cfg::rasterizer_cfg()
   depth.format=rtzr_depthfmt_none;
   rts=0;
   num_rts=0;
+  workers=0;
+  num_workers=0;
 }
 //----
 
@@ -54,6 +63,27 @@ void rasterizer_cfg::set_rts(rasterizer_render_target *rts_, uint8_t num_rts_)
   rts=rts_;
   num_rts=num_rts_;
 }
+//----
+
+void rasterizer_cfg::set_workers(const rasterizer_worker *workers_, uint8_t num_workers_)
+{
+  workers=workers_;
+  num_workers=num_workers_;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// rasterizer_callback_base
+//============================================================================
+void rasterizer_callback_base::submit_worker_tile(uint8_t worker_idx_, const rasterizer_render_target*, const rasterizer_depth_target&, uint8_t tx_, uint8_t ty_, uint16_t tile_width_, uint16_t tile_height_, const vec2u16 &reg_min_, const vec2u16 &reg_end_)
+{
+  // the main tile buffers are submitted through the single-threaded interface.
+  // worker tiles would be read from the wrong buffers, so fail also in release
+  if(worker_idx_)
+    PFC_ERROR("Rasterizer callback must implement submit_worker_tile() for worker tile buffers\r\n");
+  submit_tile(tx_, ty_, tile_width_, tile_height_, reg_min_, reg_end_);
+}
 //----------------------------------------------------------------------------
 
 
@@ -68,6 +98,8 @@ void rasterizer_stats::reset()
   num_cluster_strips=0;
   tmp_vout_size=0;
   num_clusters=0;
+  num_tile_clusters=0;
+  num_hiz_culled_tile_clusters=0;
 }
 //----
 
@@ -79,10 +111,32 @@ void rasterizer_stats::log() const
   PFC_LOGF("> Max cluster strips: %zi\r\n", num_cluster_strips);
   PFC_LOGF("> Max vout size: %zi\r\n", tmp_vout_size);
   PFC_LOGF("> Max clusters: %zi\r\n", num_clusters);
+  PFC_LOGF("> Tile clusters: %zi (hi-z culled: %zi)\r\n", num_tile_clusters, num_hiz_culled_tile_clusters);
 }
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// rasterizer::worker_pool
+//============================================================================
+#if PFC_BUILDOP_RASTERIZER_MT==1
+struct rasterizer::worker_pool
+{
+  std::vector<rasterizer_worker> workers;
+  std::vector<tile_context> worker_ctxs;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable start_cv, done_cv;
+  std::atomic<uint32_t> next_tile;  // 32-bit so that overshoot by the workers can't wrap around
+  tile_context commit_ctx;  // snapshot of the committing thread context at the commit start
+  uint32_t commit_idx;
+  unsigned num_active;
+  bool is_exiting;
+};
+#endif
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // rasterizer
 //============================================================================
@@ -91,12 +145,23 @@ rasterizer::rasterizer()
   m_callback=0;
   mem_zero(&m_cfg, sizeof(m_cfg));
   m_num_dispatches=0;
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  m_worker_pool=0;
+#endif
 #if PFC_BUILDOP_RASTERIZER_STATS==1
   m_stats.reset();
 #endif
 }
 //----
 
+rasterizer::~rasterizer()
+{
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  release_workers();
+#endif
+}
+//----
+
 void rasterizer::init(const rasterizer_cfg &cfg_, const rasterizer_tiling_cfg &tcfg_, const rasterizer_vertex_cache_cfg &vccfg_)
 {
   PFC_ASSERT(m_cfg.depth.format==rtzr_depthfmt_none || m_cfg.depth.data);
@@ -108,34 +173,133 @@ void rasterizer::init(const rasterizer_cfg &cfg_, const rasterizer_tiling_cfg &t
   m_shader_write_pos=0;
   PFC_ASSERT_MSG(((usize_t)cfg_.shader_store&(shader_mem_align-1))==0, ("Shader store not properly aligned\r\n"));
 
+  // clear main and worker tile buffers
+  if(cfg_.depth.format==rtzr_depthfmt_none)
+  {
+    m_cfg.depth.data=0;
+    m_cfg.depth.hiz_data=0;
+  }
+  clear_tile_buffers(m_cfg.depth, m_cfg.rts);
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  // copy the worker descriptors and start the worker threads, which wait for
+  // commits until the rasterizer is re-initialized or destroyed
+  release_workers();
+  m_cfg.workers=0;
+  if(cfg_.num_workers)
+  {
+    m_worker_pool=new worker_pool;
+    worker_pool &pool=*m_worker_pool;
+    pool.workers.assign(cfg_.workers, cfg_.workers+cfg_.num_workers);
+    pool.worker_ctxs.resize(cfg_.num_workers);
+    pool.next_tile=0;
+    pool.commit_idx=0;
+    pool.num_active=0;
+    pool.is_exiting=false;
+    m_cfg.workers=pool.workers.data();
+    for(uint8_t widx=0; widx<cfg_.num_workers; ++widx)
+    {
+      rasterizer_worker &worker=pool.workers[widx];
+      PFC_ASSERT(worker.depth.format==cfg_.depth.format);
+      PFC_ASSERT(cfg_.depth.format==rtzr_depthfmt_none || worker.depth.data);
+      PFC_ASSERT(!cfg_.depth.hiz_data==!worker.depth.hiz_data);
+      if(cfg_.depth.format==rtzr_depthfmt_none)
+      {
+        worker.depth.data=0;
+        worker.depth.hiz_data=0;
+      }
+      clear_tile_buffers(worker.depth, worker.rts);
+    }
+    pool.threads.reserve(cfg_.num_workers);
+    for(uint8_t widx=0; widx<cfg_.num_workers; ++widx)
+      pool.threads.emplace_back([this, widx]() {run_worker(widx);});
+  }
+#else
+  PFC_ASSERT_MSG(!cfg_.num_workers, ("Rasterizer workers require PFC_BUILDOP_RASTERIZER_MT\r\n"));
+#endif
+}
+//----------------------------------------------------------------------------
+
+void rasterizer::commit()
+{
+  // setup render target config
+  PFC_ASSERT(m_callback);
+  render_target_cfg rt_cfg;
+  rt_cfg.rt_width=m_tiling.rt_width();
+  rt_cfg.rt_height=m_tiling.rt_height();
+  rt_cfg.rt_coord_scale.set(float((m_tiling.rt_width()/2)<<rasterizer_subpixel_bits), float((m_tiling.rt_height()/2)<<rasterizer_subpixel_bits));
+  rt_cfg.depth=m_cfg.depth;
+  rt_cfg.rts=m_cfg.rts;
+  rt_cfg.tile_pitch=m_tiling.tile_width();
+
+#if PFC_BUILDOP_RASTERIZER_STATS==1
+  // update stats
+  m_stats.num_dispatches=max<usize_t>(m_num_dispatches, m_stats.num_dispatches);
+  m_stats.shader_store_size=max(m_shader_write_pos, m_stats.shader_store_size);
+  m_stats.num_cluster_strips=max<usize_t>(m_tiling.num_cluster_strips(), m_stats.num_cluster_strips);
+  m_stats.num_clusters=max<usize_t>(m_num_clusters, m_stats.num_clusters);
+#endif
+
+  // rasterize cluster triangles in all tiles
+  tile_context ctx;
+  ctx.rt_cfg=rt_cfg;
+  ctx.vcache=&m_vertex_cache;
+  ctx.worker_idx=0;
+  ctx.max_vout=0;
+  ctx.num_tile_clusters=0;
+  ctx.num_hiz_culled_tile_clusters=0;
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  if(m_cfg.num_workers)
+    commit_tiles_parallel(ctx);
+  else
+#endif
+  {
+    rasterizer_tile *tile=m_tiling.tiles(), *tile_end=tile+m_tiling.num_tiles();
+    do
+    {
+      commit_tile(*tile, ctx);
+    } while(++tile<tile_end);
+  }
+#if PFC_BUILDOP_RASTERIZER_STATS==1
+  m_stats.tmp_vout_size=max(ctx.max_vout, m_stats.tmp_vout_size);
+  m_stats.num_tile_clusters+=ctx.num_tile_clusters;
+  m_stats.num_hiz_culled_tile_clusters+=ctx.num_hiz_culled_tile_clusters;
+#endif
+
+  // clear rasterizer state
+  m_tiling.clear();
+  m_vertex_cache.release();
+  m_num_dispatches=0;
+  m_num_clusters=0;
+  m_shader_write_pos=0;
+}
+//----------------------------------------------------------------------------
+
+void rasterizer::clear_tile_buffers(const rasterizer_depth_target &depth_, rasterizer_render_target *rts_)
+{
   // clear depth
-  switch(cfg_.depth.format)
+  switch(depth_.format)
   {
     // no depth
-    case rtzr_depthfmt_none:
-    {
-      m_cfg.depth.data=0;
-      m_cfg.depth.hiz_data=0;
-    } break;
+    case rtzr_depthfmt_none: break;
 
     // 8bpp unorm depth buffer
     case rtzr_depthfmt_uint8:
     {
       usize_t depth_tile_size=sizeof(uint8_t)*m_tiling.tile_width()*m_tiling.tile_height();
-      mem_set(m_cfg.depth.data, 0xff, depth_tile_size);
+      mem_set(depth_.data, 0xff, depth_tile_size);
     } break;
 
     // 16bpp unorm depth buffer
     case rtzr_depthfmt_uint16:
     {
       usize_t depth_tile_size=sizeof(uint16_t)*m_tiling.tile_width()*m_tiling.tile_height();
-      mem_set(m_cfg.depth.data, 0xff, depth_tile_size);
+      mem_set(depth_.data, 0xff, depth_tile_size);
     } break;
 
     // float32 depth buffer
     case rtzr_depthfmt_float32:
     {
-      float *p=(float*)m_cfg.depth.data, *p_end=p+m_tiling.tile_width()*m_tiling.tile_height();
+      float *p=(float*)depth_.data, *p_end=p+m_tiling.tile_width()*m_tiling.tile_height();
       do
       {
         *p=1.0f;
@@ -147,284 +311,353 @@ void rasterizer::init(const rasterizer_cfg &cfg_, const rasterizer_tiling_cfg &t
   }
 
   // clear hi-z
-  if(m_cfg.depth.hiz_data)
-    mem_set(m_cfg.depth.hiz_data, 0xff, m_tiling.tile_width()*m_tiling.tile_height()/(rasterizer_hiz_tile_size*rasterizer_hiz_tile_size));
+  if(depth_.hiz_data)
+    mem_set(depth_.hiz_data, 0xff, sizeof(uint16_t)*m_tiling.tile_width()*m_tiling.tile_height()/(rasterizer_hiz_tile_size*rasterizer_hiz_tile_size));
 
   // clear render targets
   for(uint8_t rt_idx=0; rt_idx<m_cfg.num_rts; ++rt_idx)
   {
-    usize_t rt_tile_size=m_cfg.rts[rt_idx].px_size*m_tiling.tile_width()*m_tiling.tile_height();
-    mem_zero(m_cfg.rts[rt_idx].data, rt_tile_size);
+    usize_t rt_tile_size=rts_[rt_idx].px_size*m_tiling.tile_width()*m_tiling.tile_height();
+    mem_zero(rts_[rt_idx].data, rt_tile_size);
   }
 }
 //----------------------------------------------------------------------------
 
-void rasterizer::commit()
+void rasterizer::commit_tile(rasterizer_tile &tile_, tile_context &ctx_)
 {
-  // setup render target config
-  PFC_ASSERT(m_callback);
-  render_target_cfg rt_cfg;
-  rt_cfg.rt_width=m_tiling.rt_width();
-  rt_cfg.rt_height=m_tiling.rt_height();
-  rt_cfg.rt_coord_scale.set(float((m_tiling.rt_width()/2)<<rasterizer_subpixel_bits), float((m_tiling.rt_height()/2)<<rasterizer_subpixel_bits));
-  rt_cfg.depth=m_cfg.depth;
-  rt_cfg.rts=m_cfg.rts;
-  rt_cfg.tile_pitch=m_tiling.tile_width();
-
-#if PFC_BUILDOP_RASTERIZER_STATS==1
-  // update
-  m_stats.num_dispatches=max<usize_t>(m_num_dispatches, m_stats.num_dispatches);
-  m_stats.shader_store_size=max(m_shader_write_pos, m_stats.shader_store_size);
-  m_stats.num_cluster_strips=max<usize_t>(m_tiling.num_cluster_strips(), m_stats.num_cluster_strips);
-  m_stats.num_clusters=max<usize_t>(m_num_clusters, m_stats.num_clusters);
-#endif
-
-  // rasterize cluster triangles in all tiles
-  rasterizer_tile *tile=m_tiling.tiles(), *tile_end=tile+m_tiling.num_tiles();
-  do
+  // setup tile coords and size
+  uint8_t tx=tile_.x, ty=tile_.y;
+  uint16_t tile_x=tx<<m_tiling.tile_width_shift();
+  uint16_t tile_y=ty<<m_tiling.tile_height_shift();
+  uint16_t tile_hiz_x=tile_x/rasterizer_hiz_tile_size;
+  uint16_t tile_hiz_y=tile_y/rasterizer_hiz_tile_size;
+  render_target_cfg &rt_cfg=ctx_.rt_cfg;
+  rt_cfg.tile_width=min<uint16_t>(m_tiling.rt_width()-tile_x, m_tiling.tile_width());
+  rt_cfg.tile_height=min<uint16_t>(m_tiling.rt_height()-tile_y, m_tiling.tile_height());
+
+  // rasterize tile clusters
+  rasterizer_global_cluster_index_t num_tile_clusters=tile_.num_clusters;
+  rasterizer_cluster_strip_index_t cstrip_idx=tile_.cluster_strip_first;
+  rasterizer_dispatch_index_t cur_dispatch_idx=rasterizer_dispatch_index_t(-1);
+  result res={{rt_cfg.tile_width, rt_cfg.tile_height}, {0, 0}, rtzr_depthfmt_none, 0};
+  vec2u16 tile_bounds_min={rt_cfg.tile_width, rt_cfg.tile_height};
+  vec2u16 tile_bounds_end={0, 0};
+  bool hiz_test=false;
+  while(num_tile_clusters)
   {
-    // setup tile coords and size
-    uint8_t tx=tile->x, ty=tile->y;
-    uint16_t tile_x=tx<<m_tiling.tile_width_shift();
-    uint16_t tile_y=ty<<m_tiling.tile_height_shift();
-    uint16_t tile_hiz_x=tile_x/rasterizer_hiz_tile_size;
-    uint16_t tile_hiz_y=tile_y/rasterizer_hiz_tile_size;
-    rt_cfg.tile_width=min<uint16_t>(m_tiling.rt_width()-tile_x, m_tiling.tile_width());
-    rt_cfg.tile_height=min<uint16_t>(m_tiling.rt_height()-tile_y, m_tiling.tile_height());
-
-    // rasterize tile clusters
-    rasterizer_global_cluster_index_t num_tile_clusters=tile->num_clusters;
-    rasterizer_cluster_strip_index_t cstrip_idx=tile->cluster_strip_first;
-    rasterizer_dispatch_index_t cur_dispatch_idx=rasterizer_dispatch_index_t(-1);
-    result res={{rt_cfg.tile_width, rt_cfg.tile_height}, {0, 0}, rtzr_depthfmt_none, 0};
-    vec2u16 tile_bounds_min={rt_cfg.tile_width, rt_cfg.tile_height};
-    vec2u16 tile_bounds_end={0, 0};
-    bool hiz_test=false;
-    while(num_tile_clusters)
+    // rasterize cluster strip
+    const rasterizer_tile_cluster_strip &cstrip=m_tiling.cluster_strip(cstrip_idx);
+    uint8_t num_strip_clusters=(uint8_t)min<rasterizer_global_cluster_index_t>(num_tile_clusters, rasterizer_max_strip_clusters);
+    num_tile_clusters-=num_strip_clusters;
+    const rasterizer_global_cluster_index_t *global_cluster_idx=cstrip.global_cluster_idx, *global_cluster_idx_end=global_cluster_idx+num_strip_clusters;
+    do
     {
-      // rasterize cluster strip
-      const rasterizer_tile_cluster_strip &cstrip=m_tiling.cluster_strip(cstrip_idx);
-      uint8_t num_strip_clusters=(uint8_t)min<rasterizer_global_cluster_index_t>(num_tile_clusters, rasterizer_max_strip_clusters);
-      num_tile_clusters-=num_strip_clusters;
-      const rasterizer_global_cluster_index_t *global_cluster_idx=cstrip.global_cluster_idx, *global_cluster_idx_end=global_cluster_idx+num_strip_clusters;
-      do
+      // check dispatch change
+      rasterizer_cluster &cluster=m_tiling.cluster(*global_cluster_idx);
+      if(cur_dispatch_idx!=cluster.dispatch_idx)
       {
-        // check dispatch change
-        rasterizer_cluster &cluster=m_tiling.cluster(*global_cluster_idx);
-        if(cur_dispatch_idx!=cluster.dispatch_idx)
-        {
-          // update dispatch state
-          hiz_test=cur_dispatch_idx!=rasterizer_dispatch_index_t(-1);
-          cur_dispatch_idx=cluster.dispatch_idx;
+        // update dispatch state
+        hiz_test=cur_dispatch_idx!=rasterizer_dispatch_index_t(-1);
+        cur_dispatch_idx=cluster.dispatch_idx;
 
 #if PFC_BUILDOP_RASTERIZER_HIZ==1
-          // check for hi-z update
-          if(m_cfg.depth.hiz_data && res.hiz_depth_format!=rtzr_depthfmt_none && res.tile_end.x && res.tile_end.y)
+        // check for hi-z update
+        if(rt_cfg.depth.hiz_data && res.hiz_depth_format!=rtzr_depthfmt_none && res.tile_end.x && res.tile_end.y)
+        {
+          // update hi-z for the changed tile region
+          switch(res.hiz_depth_format)
           {
-            // update hi-z for the changed tile region
-            switch(res.hiz_depth_format)
-            {
-              // 8bpp unorm depth buffer
-              case rtzr_depthfmt_uint8: update_hiz<uint8_t>(res); break;
-              // 16bpp unorm depth buffer
-              case rtzr_depthfmt_uint16: update_hiz<uint16_t>(res); break;
-              // float32 depth buffer
-              case rtzr_depthfmt_float32: update_hiz<float32_t>(res); break;
-              // unsupported format
-              default: PFC_ERROR("Unsupported depth format\r\n");
-            }
+            // 8bpp unorm depth buffer
+            case rtzr_depthfmt_uint8: update_hiz<uint8_t>(rt_cfg.depth, res); break;
+            // 16bpp unorm depth buffer
+            case rtzr_depthfmt_uint16: update_hiz<uint16_t>(rt_cfg.depth, res); break;
+            // float32 depth buffer
+            case rtzr_depthfmt_float32: update_hiz<float32_t>(rt_cfg.depth, res); break;
+            // unsupported format
+            default: PFC_ERROR("Unsupported depth format\r\n");
           }
-          tile_bounds_min=min(tile_bounds_min, res.tile_min);
-          tile_bounds_end=max(tile_bounds_end, res.tile_end);
-          res.tile_min.set(rt_cfg.tile_width, rt_cfg.tile_height);
-          res.tile_end.set(0, 0);
-#endif
         }
+        tile_bounds_min=min(tile_bounds_min, res.tile_min);
+        tile_bounds_end=max(tile_bounds_end, res.tile_end);
+        res.tile_min.set(rt_cfg.tile_width, rt_cfg.tile_height);
+        res.tile_end.set(0, 0);
+#endif
+      }
 
 #if PFC_BUILDOP_RASTERIZER_HIZ==1
-        // check cluster occlusion against hi-z
-        const uint16_t *hiz_data=m_cfg.depth.hiz_data;
-        if(hiz_test && hiz_data)
+      // check cluster occlusion against hi-z
+      const uint16_t *hiz_data=rt_cfg.depth.hiz_data;
+      if(hiz_test && hiz_data)
+      {
+        // get max hi-z value within cluster bounds of the tile
+        const uint16_t hiz_test_x=(uint16_t)max<int16_t>(0, cluster.hiz_x-tile_hiz_x);
+        const uint16_t hiz_test_y=(uint16_t)max<int16_t>(0, cluster.hiz_y-tile_hiz_y);
+        const uint16_t hiz_test_width=min<int16_t>(m_tiling.tile_width()/rasterizer_hiz_tile_size-hiz_test_x, cluster.hiz_x+cluster.hiz_width-tile_hiz_x-hiz_test_x);
+        const uint16_t hiz_test_height=min<int16_t>(m_tiling.tile_height()/rasterizer_hiz_tile_size-hiz_test_y, cluster.hiz_y+cluster.hiz_height-tile_hiz_y-hiz_test_y);
+        const uint16_t hiz_pitch=m_tiling.tile_width()/rasterizer_hiz_tile_size;
+        const uint16_t hiz_scan_pitch=hiz_pitch-hiz_test_width;
+        const uint16_t *hiz_buf=hiz_data+hiz_test_x+hiz_test_y*hiz_pitch;
+        const uint16_t *hiz_buf_end=hiz_buf+hiz_test_height*hiz_pitch;
+        if(!hiz_test_width || !hiz_test_height)
+          continue;
+        uint16_t max_hiz=0;
+        do
         {
-          // get max hi-z value within cluster bounds of the tile
-          const uint16_t hiz_test_x=(uint16_t)max<int16_t>(0, cluster.hiz_x-tile_hiz_x);
-          const uint16_t hiz_test_y=(uint16_t)max<int16_t>(0, cluster.hiz_y-tile_hiz_y);
-          const uint16_t hiz_test_width=min<int16_t>(m_tiling.tile_width()/rasterizer_hiz_tile_size-hiz_test_x, cluster.hiz_x+cluster.hiz_width-tile_hiz_x-hiz_test_x);
-          const uint16_t hiz_test_height=min<int16_t>(m_tiling.tile_height()/rasterizer_hiz_tile_size-hiz_test_y, cluster.hiz_y+cluster.hiz_height-tile_hiz_y-hiz_test_y);
-          const uint16_t hiz_pitch=m_tiling.tile_width()/rasterizer_hiz_tile_size;
-          const uint16_t hiz_scan_pitch=hiz_pitch-hiz_test_width;
-          const uint16_t *hiz_buf=hiz_data+hiz_test_x+hiz_test_y*hiz_pitch;
-          const uint16_t *hiz_buf_end=hiz_buf+hiz_test_height*hiz_pitch;
-          if(!hiz_test_width || !hiz_test_height)
-            continue;
-          uint16_t max_hiz=0;
+          const uint16_t *hiz_scan_end=hiz_buf+hiz_test_width;
           do
           {
-            const uint16_t *hiz_scan_end=hiz_buf+hiz_test_width;
-            do
-            {
-              max_hiz=max(max_hiz, *hiz_buf);
-            } while(++hiz_buf<hiz_scan_end);
-            hiz_buf+=hiz_scan_pitch;
-          } while(hiz_buf<hiz_buf_end);
-
-          // skip cluster if max hi-z value is less than cluster min-z
-          if(max_hiz<cluster.min_z)
-            continue;
-        }
-#endif
+            max_hiz=max(max_hiz, *hiz_buf);
+          } while(++hiz_buf<hiz_scan_end);
+          hiz_buf+=hiz_scan_pitch;
+        } while(hiz_buf<hiz_buf_end);
 
-        // rasterize the cluster for the tile
-        const void *wrapper=m_cfg.dispatches[cur_dispatch_idx].shader_wrapper;
-        ((const shader_wrapper_base*)wrapper)->rasterize_cluster(res, rt_cfg, tile_x, tile_y, m_vertex_cache, cluster.local_cluster_idx, *global_cluster_idx);
-      } while(++global_cluster_idx<global_cluster_idx_end);
-      cstrip_idx=cstrip.next;
-    }
-    res.tile_min=min(res.tile_min, tile_bounds_min);
-    res.tile_end=max(res.tile_end, tile_bounds_end);
-#if PFC_BUILDOP_RASTERIZER_STATS==1
-    m_stats.tmp_vout_size=max(res.max_vout, m_stats.tmp_vout_size);
+        // skip cluster if max hi-z value is less than cluster min-z
+        if(max_hiz<cluster.min_z)
+        {
+          ++ctx_.num_hiz_culled_tile_clusters;
+          continue;
+        }
+      }
 #endif
+      ++ctx_.num_tile_clusters;
 
-    // calculate tile update region and submit tile
-    vec2u16 update_region_min=min(res.tile_min, vec2u16(tile->tile_min.x, tile->tile_min.y));
-    vec2u16 update_region_end=max(res.tile_end, vec2u16(tile->tile_end.x, tile->tile_end.y));
-    tile->tile_min.x=rasterizer_tile_size_t(res.tile_min.x);
-    tile->tile_min.y=rasterizer_tile_size_t(res.tile_min.y);
-    tile->tile_end.x=rasterizer_tile_size_t(res.tile_end.x);
-    tile->tile_end.y=rasterizer_tile_size_t(res.tile_end.y);
-    if(update_region_end.x && update_region_end.y)
+      // rasterize the cluster for the tile
+      const void *wrapper=m_cfg.dispatches[cur_dispatch_idx].shader_wrapper;
+      ((const shader_wrapper_base*)wrapper)->rasterize_cluster(res, rt_cfg, tile_x, tile_y, *ctx_.vcache, cluster.local_cluster_idx, *global_cluster_idx);
+    } while(++global_cluster_idx<global_cluster_idx_end);
+    cstrip_idx=cstrip.next;
+  }
+  res.tile_min=min(res.tile_min, tile_bounds_min);
+  res.tile_end=max(res.tile_end, tile_bounds_end);
+  ctx_.max_vout=max(res.max_vout, ctx_.max_vout);
+
+  // calculate tile update region and submit tile
+  vec2u16 update_region_min=min(res.tile_min, vec2u16(tile_.tile_min.x, tile_.tile_min.y));
+  vec2u16 update_region_end=max(res.tile_end, vec2u16(tile_.tile_end.x, tile_.tile_end.y));
+  tile_.tile_min.x=rasterizer_tile_size_t(res.tile_min.x);
+  tile_.tile_min.y=rasterizer_tile_size_t(res.tile_min.y);
+  tile_.tile_end.x=rasterizer_tile_size_t(res.tile_end.x);
+  tile_.tile_end.y=rasterizer_tile_size_t(res.tile_end.y);
+  if(update_region_end.x && update_region_end.y)
+  {
+    // submit tile
+    m_callback->submit_worker_tile(ctx_.worker_idx, rt_cfg.rts, rt_cfg.depth, tx, ty, rt_cfg.tile_width, rt_cfg.tile_height, update_region_min, update_region_end);
+    bool clear_subtile=   res.tile_min.x || res.tile_end.x<m_tiling.tile_width()
+                       || res.tile_min.y || res.tile_end.y<m_tiling.tile_height();
+    if(!res.tile_end.x || !res.tile_end.y)
+      return;
+
+    // clear depth
+    switch(m_cfg.depth.format)
     {
-      // submit tile
-      m_callback->submit_tile(tx, ty, rt_cfg.tile_width, rt_cfg.tile_height, update_region_min, update_region_end);
-      bool clear_subtile=   res.tile_min.x || res.tile_end.x<m_tiling.tile_width()
-                         || res.tile_min.y || res.tile_end.y<m_tiling.tile_height();
-      if(!res.tile_end.x || !res.tile_end.y)
-        continue;
-
-      // clear depth
-      switch(m_cfg.depth.format)
-      {
-        // no depth
-        case rtzr_depthfmt_none: break;
+      // no depth
+      case rtzr_depthfmt_none: break;
 
-        // 8bpp unorm depth buffer
-        case rtzr_depthfmt_uint8:
+      // 8bpp unorm depth buffer
+      case rtzr_depthfmt_uint8:
+      {
+        if(clear_subtile)
         {
-          if(clear_subtile)
-          {
-            usize_t depth_subtile_sline_size=sizeof(uint8_t)*(res.tile_end.x-res.tile_min.x);
-            usize_t depth_tile_width=m_tiling.tile_width();
-            uint8_t *p=(uint8_t*)m_cfg.depth.data+res.tile_min.x+res.tile_min.y*m_tiling.tile_width();
-            uint8_t *p_end=p+depth_tile_width*(res.tile_end.y-res.tile_min.y);
-            do
-            {
-              mem_set(p, 0xff, depth_subtile_sline_size);
-              p+=depth_tile_width;
-            } while(p<p_end);
-          }
-          else
+          usize_t depth_subtile_sline_size=sizeof(uint8_t)*(res.tile_end.x-res.tile_min.x);
+          usize_t depth_tile_width=m_tiling.tile_width();
+          uint8_t *p=(uint8_t*)rt_cfg.depth.data+res.tile_min.x+res.tile_min.y*m_tiling.tile_width();
+          uint8_t *p_end=p+depth_tile_width*(res.tile_end.y-res.tile_min.y);
+          do
           {
-            usize_t depth_tile_size=sizeof(uint8_t)*m_tiling.tile_width()*m_tiling.tile_height();
-            mem_set(m_cfg.depth.data, 0xff, depth_tile_size);
-          }
-        } break;
-
-        // 16bpp unorm depth buffer
-        case rtzr_depthfmt_uint16:
+            mem_set(p, 0xff, depth_subtile_sline_size);
+            p+=depth_tile_width;
+          } while(p<p_end);
+        }
+        else
         {
-          if(clear_subtile)
-          {
-            usize_t depth_subtile_sline_size=sizeof(uint16_t)*(res.tile_end.x-res.tile_min.x);
-            usize_t depth_tile_width=m_tiling.tile_width();
-            uint16_t *p=(uint16_t*)m_cfg.depth.data+res.tile_min.x+res.tile_min.y*m_tiling.tile_width();
-            uint16_t *p_end=p+depth_tile_width*(res.tile_end.y-res.tile_min.y);
-            do
-            {
-              mem_set(p, 0xff, depth_subtile_sline_size);
-              p+=depth_tile_width;
-            } while(p<p_end);
-          }
-          else
-          {
-            usize_t depth_tile_size=sizeof(uint16_t)*m_tiling.tile_width()*m_tiling.tile_height();
-            mem_set(m_cfg.depth.data, 0xff, depth_tile_size);
-          }
-        } break;
+          usize_t depth_tile_size=sizeof(uint8_t)*m_tiling.tile_width()*m_tiling.tile_height();
+          mem_set(rt_cfg.depth.data, 0xff, depth_tile_size);
+        }
+      } break;
 
-        // 32bpp float depth buffer
-        case rtzr_depthfmt_float32:
+      // 16bpp unorm depth buffer
+      case rtzr_depthfmt_uint16:
+      {
+        if(clear_subtile)
         {
-          if(clear_subtile)
-          {
-            usize_t subtile_width=res.tile_end.x-res.tile_min.x;
-            usize_t depth_tile_pitch_delta=m_tiling.tile_width()-subtile_width;
-            float32_t *p=(float32_t*)m_cfg.depth.data+res.tile_min.x+res.tile_min.y*m_tiling.tile_width();
-            float32_t *p_tile_end=p+m_tiling.tile_width()*(res.tile_end.y-res.tile_min.y);
-            do
-            {
-              float32_t *scan_p_end=p+subtile_width;
-              do
-              {
-                *p=1.0f;
-              } while(++p<scan_p_end);
-              p+=depth_tile_pitch_delta;
-            } while(p<p_tile_end);
-          }
-          else
+          usize_t depth_subtile_sline_size=sizeof(uint16_t)*(res.tile_end.x-res.tile_min.x);
+          usize_t depth_tile_width=m_tiling.tile_width();
+          uint16_t *p=(uint16_t*)rt_cfg.depth.data+res.tile_min.x+res.tile_min.y*m_tiling.tile_width();
+          uint16_t *p_end=p+depth_tile_width*(res.tile_end.y-res.tile_min.y);
+          do
           {
-            float32_t *p=(float32_t*)m_cfg.depth.data, *p_end=p+m_tiling.tile_width()*m_tiling.tile_height();
-            do
-            {
-              *p=1.0f;
-            } while(++p<p_end);
-          }
-        } break;
-
-        // unsupported format
-        default: PFC_ERROR("Unsupported depth format\r\n");
-      }
-
-      // clear hi-z
-      if(m_cfg.depth.hiz_data)
-        mem_set(m_cfg.depth.hiz_data, 0xff, sizeof(uint16_t)*m_tiling.tile_width()*m_tiling.tile_height()/(rasterizer_hiz_tile_size*rasterizer_hiz_tile_size));
+            mem_set(p, 0xff, depth_subtile_sline_size);
+            p+=depth_tile_width;
+          } while(p<p_end);
+        }
+        else
+        {
+          usize_t depth_tile_size=sizeof(uint16_t)*m_tiling.tile_width()*m_tiling.tile_height();
+          mem_set(rt_cfg.depth.data, 0xff, depth_tile_size);
+        }
+      } break;
 
-      // clear render targets
-      for(uint8_t rt_idx=0; rt_idx<m_cfg.num_rts; ++rt_idx)
+      // 32bpp float depth buffer
+      case rtzr_depthfmt_float32:
       {
-        uint16_t px_size=m_cfg.rts[rt_idx].px_size;
-        usize_t rt_tile_pitch=px_size*m_tiling.tile_width();
         if(clear_subtile)
         {
-          usize_t rt_subtile_sline_size=px_size*(res.tile_end.x-res.tile_min.x);
-          uint8_t *p=(uint8_t*)m_cfg.rts[rt_idx].data+px_size*(res.tile_min.x+res.tile_min.y*m_tiling.tile_width());
-          uint8_t *p_end=p+rt_tile_pitch*(res.tile_end.y-res.tile_min.y);
+          usize_t subtile_width=res.tile_end.x-res.tile_min.x;
+          usize_t depth_tile_pitch_delta=m_tiling.tile_width()-subtile_width;
+          float32_t *p=(float32_t*)rt_cfg.depth.data+res.tile_min.x+res.tile_min.y*m_tiling.tile_width();
+          float32_t *p_tile_end=p+m_tiling.tile_width()*(res.tile_end.y-res.tile_min.y);
           do
           {
-            mem_zero(p, rt_subtile_sline_size);
-            p+=rt_tile_pitch;
-          } while(p<p_end);
+            float32_t *scan_p_end=p+subtile_width;
+            do
+            {
+              *p=1.0f;
+            } while(++p<scan_p_end);
+            p+=depth_tile_pitch_delta;
+          } while(p<p_tile_end);
         }
         else
         {
-          usize_t rt_tile_size=rt_tile_pitch*m_tiling.tile_height();
-          mem_zero(m_cfg.rts[rt_idx].data, rt_tile_size);
+          float32_t *p=(float32_t*)rt_cfg.depth.data, *p_end=p+m_tiling.tile_width()*m_tiling.tile_height();
+          do
+          {
+            *p=1.0f;
+          } while(++p<p_end);
         }
+      } break;
+
+      // unsupported format
+      default: PFC_ERROR("Unsupported depth format\r\n");
+    }
+
+    // clear hi-z
+    if(rt_cfg.depth.hiz_data)
+      mem_set(rt_cfg.depth.hiz_data, 0xff, sizeof(uint16_t)*m_tiling.tile_width()*m_tiling.tile_height()/(rasterizer_hiz_tile_size*rasterizer_hiz_tile_size));
+
+    // clear render targets
+    for(uint8_t rt_idx=0; rt_idx<m_cfg.num_rts; ++rt_idx)
+    {
+      uint16_t px_size=rt_cfg.rts[rt_idx].px_size;
+      usize_t rt_tile_pitch=px_size*m_tiling.tile_width();
+      if(clear_subtile)
+      {
+        usize_t rt_subtile_sline_size=px_size*(res.tile_end.x-res.tile_min.x);
+        uint8_t *p=(uint8_t*)rt_cfg.rts[rt_idx].data+px_size*(res.tile_min.x+res.tile_min.y*m_tiling.tile_width());
+        uint8_t *p_end=p+rt_tile_pitch*(res.tile_end.y-res.tile_min.y);
+        do
+        {
+          mem_zero(p, rt_subtile_sline_size);
+          p+=rt_tile_pitch;
+        } while(p<p_end);
+      }
+      else
+      {
+        usize_t rt_tile_size=rt_tile_pitch*m_tiling.tile_height();
+        mem_zero(rt_cfg.rts[rt_idx].data, rt_tile_size);
       }
     }
-  } while(++tile<tile_end);
+  }
+}
+//----------------------------------------------------------------------------
 
-  // clear rasterizer state
-  m_tiling.clear();
-  m_vertex_cache.release();
-  m_num_dispatches=0;
-  m_num_clusters=0;
-  m_shader_write_pos=0;
+#if PFC_BUILDOP_RASTERIZER_MT==1
+void rasterizer::release_workers()
+{
+  // stop and join the worker threads
+  if(!m_worker_pool)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(m_worker_pool->mutex);
+    m_worker_pool->is_exiting=true;
+  }
+  m_worker_pool->start_cv.notify_all();
+  for(std::thread &t:m_worker_pool->threads)
+    t.join();
+  delete m_worker_pool;
+  m_worker_pool=0;
+}
+//----
+
+void rasterizer::run_worker(uint8_t worker_idx_)
+{
+  worker_pool &pool=*m_worker_pool;
+  const rasterizer_worker &w=pool.workers[worker_idx_];
+  uint32_t commit_idx=0;
+  while(true)
+  {
+    // wait for the next commit
+    {
+      std::unique_lock<std::mutex> lock(pool.mutex);
+      pool.start_cv.wait(lock, [&]() {return pool.is_exiting || pool.commit_idx!=commit_idx;});
+      if(pool.is_exiting)
+        return;
+      commit_idx=pool.commit_idx;
+    }
+
+    // setup worker tile buffers and rasterize tiles
+    rasterizer_vertex_cache vcache;
+    vcache.init_concurrent_view(m_vertex_cache, w.tmp_cluster_vout, w.tmp_vout_size);
+    tile_context &wctx=pool.worker_ctxs[worker_idx_];
+    wctx=pool.commit_ctx;
+    wctx.rt_cfg.depth=w.depth;
+    wctx.rt_cfg.rts=w.rts;
+    wctx.vcache=&vcache;
+    wctx.worker_idx=uint8_t(worker_idx_+1);
+    rasterizer_tile *tiles=m_tiling.tiles();
+    const uint32_t num_tiles=m_tiling.num_tiles();
+    uint32_t tile_idx;
+    while((tile_idx=pool.next_tile.fetch_add(1, std::memory_order_relaxed))<num_tiles)
+      commit_tile(tiles[tile_idx], wctx);
+
+    // signal the committing thread when all workers are done
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    if(!--pool.num_active)
+      pool.done_cv.notify_one();
+  }
+}
+//----
+
+void rasterizer::commit_tiles_parallel(tile_context &ctx_)
+{
+  // pull tiles in the tile render order from a shared counter with the calling
+  // thread taking part as worker #0 with the main tile buffers. the vertex
+  // cache is shared by all workers in concurrent mode
+  PFC_ASSERT(m_worker_pool);
+  worker_pool &pool=*m_worker_pool;
+  const uint8_t num_workers=m_cfg.num_workers;
+  m_vertex_cache.begin_concurrent();
+  rasterizer_tile *tiles=m_tiling.tiles();
+  const uint32_t num_tiles=m_tiling.num_tiles();
+  pool.next_tile=0;
+  {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.commit_ctx=ctx_;
+    pool.num_active=num_workers;
+    ++pool.commit_idx;
+  }
+  pool.start_cv.notify_all();
+  uint32_t tile_idx;
+  while((tile_idx=pool.next_tile.fetch_add(1, std::memory_order_relaxed))<num_tiles)
+    commit_tile(tiles[tile_idx], ctx_);
+  {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.done_cv.wait(lock, [&]() {return !pool.num_active;});
+  }
+
+  // merge worker results
+  for(uint8_t widx=0; widx<num_workers; ++widx)
+  {
+    const tile_context &wctx=pool.worker_ctxs[widx];
+    ctx_.max_vout=max(ctx_.max_vout, wctx.max_vout);
+    ctx_.num_tile_clusters+=wctx.num_tile_clusters;
+    ctx_.num_hiz_culled_tile_clusters+=wctx.num_hiz_culled_tile_clusters;
+  }
 }
 //----------------------------------------------------------------------------
+#endif
 
 template<typename T>
-void rasterizer::update_hiz(const rasterizer::result &res_)
+void rasterizer::update_hiz(const rasterizer_depth_target &depth_, const rasterizer::result &res_)
 {
   // prepare hi-z update
   vec2i32 hiz_tile_min={res_.tile_min.x/rasterizer_hiz_tile_size, res_.tile_min.y/rasterizer_hiz_tile_size};
@@ -435,7 +668,7 @@ void rasterizer::update_hiz(const rasterizer::result &res_)
   uint16_t zbuf_tile_scan_pitch=m_tiling.tile_width()-hiz_update_width*rasterizer_hiz_tile_size;
 
   // iterate over all hi-z tiles
-  uint16_t *hiz_buf=m_cfg.depth.hiz_data+hiz_tile_min.x+hiz_tile_min.y*hiz_tile_pitch;
+  uint16_t *hiz_buf=depth_.hiz_data+hiz_tile_min.x+hiz_tile_min.y*hiz_tile_pitch;
   uint16_t *hiz_buf_end=hiz_buf+hiz_update_height*hiz_tile_pitch;
   uint16_t hiz_y=uint16_t(hiz_tile_min.y*rasterizer_hiz_tile_size);
   do
@@ -445,7 +678,7 @@ void rasterizer::update_hiz(const rasterizer::result &res_)
     do
     {
       // update hi-z tile
-      const T *zbuf=(T*)m_cfg.depth.data+hiz_x+hiz_y*m_tiling.tile_width();
+      const T *zbuf=(T*)depth_.data+hiz_x+hiz_y*m_tiling.tile_width();
       const T *zbuf_end=zbuf+m_tiling.tile_width()*rasterizer_hiz_tile_size;
       T tile_maxz=0;
       do
@@ -27,6 +27,7 @@ typedef vec2<int32_t> vec2i32;
 typedef vec3<int32_t> vec3i32;
 struct rasterizer_depth_target;
 struct rasterizer_render_target;
+struct rasterizer_worker;
 struct rasterizer_dispatch;
 struct rasterizer_stats;
 struct rasterizer_cfg;
@@ -64,6 +65,25 @@ struct rasterizer_render_target
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// rasterizer_worker
+//============================================================================
+// Tile buffers of an additional commit() worker thread. The buffers must
+// match the depth format, tile size and render target pixel sizes of the
+// rasterizer config. rasterizer::init() copies the descriptors and starts the
+// worker threads, which are reused by all commits. With workers, tiles are
+// rendered concurrently so shader cluster and pixel functions must not modify
+// shared state.
+struct rasterizer_worker
+{
+  rasterizer_depth_target depth;
+  rasterizer_render_target *rts;
+  void *tmp_cluster_vout;
+  usize_t tmp_vout_size;
+};
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // rasterizer_dispatch
 //============================================================================
@@ -179,6 +199,9 @@ struct rasterizer_stats
   usize_t num_cluster_strips;
   usize_t tmp_vout_size;
   usize_t num_clusters;
+  // totals since reset
+  usize_t num_tile_clusters;             // rasterized cluster-tile pairs
+  usize_t num_hiz_culled_tile_clusters;  // cluster-tile pairs culled by hi-z
 };
 //----------------------------------------------------------------------------
 
@@ -194,6 +217,7 @@ struct rasterizer_cfg
   void set_shader_store(void *shader_store_, usize_t shader_store_size_);
   void set_depth(void *depth_buffer_, uint16_t *hiz_buffer_, e_rasterizer_depth_format);
   void set_rts(rasterizer_render_target *rts_, uint8_t num_rts_);
+  void set_workers(const rasterizer_worker*, uint8_t num_workers_);
   //--------------------------------------------------------------------------
 
   rasterizer_dispatch *dispatches;
@@ -203,6 +227,8 @@ struct rasterizer_cfg
   rasterizer_depth_target depth;
   rasterizer_render_target *rts;
   uint8_t num_rts;
+  const rasterizer_worker *workers;
+  uint8_t num_workers;
 };
 //----------------------------------------------------------------------------
 
@@ -215,6 +241,10 @@ class rasterizer_callback_base
 public:
   // callback interface
   virtual void submit_tile(uint8_t tx_, uint8_t ty_, uint16_t tile_width_, uint16_t tile_height_, const vec2u16 &reg_min_, const vec2u16 &reg_end_)=0;
+  // called for tiles rendered to worker buffers (worker_idx_>0 is rasterizer_cfg::workers[worker_idx_-1]).
+  // with workers this is called concurrently from all worker threads for different tiles.
+  // the default forwards worker #0 tiles to submit_tile() and errors on other workers
+  virtual void submit_worker_tile(uint8_t worker_idx_, const rasterizer_render_target *rts_, const rasterizer_depth_target &depth_, uint8_t tx_, uint8_t ty_, uint16_t tile_width_, uint16_t tile_height_, const vec2u16 &reg_min_, const vec2u16 &reg_end_);
   //--------------------------------------------------------------------------
 
 protected:
@@ -280,6 +310,7 @@ class rasterizer
 public:
   // construction
   rasterizer();
+  ~rasterizer();
   void init(const rasterizer_cfg&, const rasterizer_tiling_cfg&, const rasterizer_vertex_cache_cfg&);
   PFC_INLINE void set_callback(rasterizer_callback_base*);
   //--------------------------------------------------------------------------
@@ -303,9 +334,18 @@ public:
   
 private:
   struct result;
+  struct tile_context;
   rasterizer(const rasterizer&); // not implemented
   void operator=(const rasterizer&); // not implemented
-  template<typename> void update_hiz(const result&);
+  void clear_tile_buffers(const rasterizer_depth_target&, rasterizer_render_target *rts_);
+  void commit_tile(rasterizer_tile&, tile_context&);
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  struct worker_pool;
+  void release_workers();
+  void run_worker(uint8_t worker_idx_);
+  void commit_tiles_parallel(tile_context&);
+#endif
+  template<typename> void update_hiz(const rasterizer_depth_target&, const result&);
   static PFC_INLINE int32_t cross2d(const vec2i32& a_, const vec2i32& b_, const vec2i32& c_)  {return (b_.x-a_.x)*(c_.y-a_.y)-(b_.y-a_.y)*(c_.x-a_.x);}
   template<int> static PFC_INLINE float read_depth(const void *dbuf_, uint32_t offs_);
   template<int> static PFC_INLINE void write_depth(const void *dbuf_, uint32_t offs_, float z_);
@@ -338,6 +378,20 @@ private:
   };
   //--------------------------------------------------------------------------
 
+  //==========================================================================
+  // tile_context
+  //==========================================================================
+  struct tile_context
+  {
+    render_target_cfg rt_cfg;
+    rasterizer_vertex_cache *vcache;
+    uint8_t worker_idx;
+    usize_t max_vout;
+    usize_t num_tile_clusters;
+    usize_t num_hiz_culled_tile_clusters;
+  };
+  //--------------------------------------------------------------------------
+
   //==========================================================================
   // shader_wrapper_base
   //==========================================================================
@@ -367,6 +421,9 @@ private:
   rasterizer_dispatch_index_t m_num_dispatches;
   rasterizer_global_cluster_index_t m_num_clusters;
   usize_t m_shader_write_pos;
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  worker_pool *m_worker_pool;  // worker threads and copies of the worker descriptors (null without workers)
+#endif
   // stats
 #if PFC_BUILDOP_RASTERIZER_STATS==1
   rasterizer_stats m_stats;
@@ -507,8 +564,24 @@ void rasterizer::shader_wrapper<Shader>::rasterize_cluster(result &res_, const r
   }
   else
   {
-    // allocate vout from cache if the result is not in the cache yet
     cluster=sh.cluster(cluster_idx_);
+#if PFC_BUILDOP_RASTERIZER_MT==1
+    if(vcache_.is_concurrent())
+    {
+      // transform the cluster once per frame to the cache shared by tile workers
+      usize_t vout_size=sh.num_cluster_vertices(cluster)*sizeof(vout_t);
+      bool is_owner;
+      vout=(vout_t*)vcache_.acquire_concurrent_cluster_cache(global_cluster_idx_, vout_size, is_owner);
+      if(!is_owner)
+        goto vout_found_in_cache;
+      res_.max_vout=max(res_.max_vout, vout_size);
+      sh.tform_cluster(vout, cluster);
+      vcache_.publish_concurrent_cluster_cache(global_cluster_idx_, vout);
+      goto vout_found_in_cache;
+    }
+#endif
+
+    // allocate vout from cache if the result is not in the cache yet
     vout=(vout_t*)vcache_.cluster_cache(global_cluster_idx_);
     if(vout)
       goto vout_found_in_cache;
@@ -6,10 +6,38 @@
 //============================================================================
 
 #include "rasterizer_cache.h"
+#if PFC_BUILDOP_RASTERIZER_MT==1
+#include <thread>
+#endif
 using namespace pfc;
 //----------------------------------------------------------------------------
 
 
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  // concurrent mode cluster states (other values are ready cluster block offsets)
+  enum {vcache_cluster_unstarted=rasterizer_vertex_cache_offset_t(-1)};
+  enum {vcache_cluster_in_progress=rasterizer_vertex_cache_offset_t(-2)};
+  enum {vcache_cluster_uncached=rasterizer_vertex_cache_offset_t(-3)};
+  typedef std::atomic<rasterizer_vertex_cache_offset_t> atomic_vcache_offset_t;
+  // the cluster offset array is accessed in place as atomics, so they must
+  // match the plain offsets in layout and never fall back to a lock
+  PFC_CTC_ASSERT_MSG(sizeof(atomic_vcache_offset_t)==sizeof(rasterizer_vertex_cache_offset_t), atomic_vertex_cache_offset_size_mismatch);
+  PFC_CTC_ASSERT_MSG(alignof(atomic_vcache_offset_t)==alignof(rasterizer_vertex_cache_offset_t), atomic_vertex_cache_offset_alignment_mismatch);
+#if __cplusplus>=201703L || (defined(_MSVC_LANG) && _MSVC_LANG>=201703L)
+  PFC_CTC_ASSERT_MSG(atomic_vcache_offset_t::is_always_lock_free, atomic_vertex_cache_offset_not_lock_free);
+#else
+  PFC_CTC_ASSERT_MSG(ATOMIC_SHORT_LOCK_FREE==2, atomic_vertex_cache_offset_not_lock_free);
+#endif
+#endif
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // rasterizer_vertex_cache_cfg
 //============================================================================
@@ -40,6 +68,7 @@ void rasterizer_vertex_cache_cfg::set_cluster_vout(void *vout_, usize_t vout_siz
 
 void rasterizer_vertex_cache_cfg::set_cache_clusters(rasterizer_vertex_cache_offset_t *vcache_offs_, usize_t max_clusters_)
 {
+  PFC_ASSERT_MSG(((usize_t)vcache_offs_&(alignof(rasterizer_vertex_cache_offset_t)-1))==0, ("Cluster vertex cache offsets not properly aligned\r\n"));
   cluster_vcache_offs=vcache_offs_;
   max_clusters=max_clusters_;
 }
@@ -53,6 +82,10 @@ rasterizer_vertex_cache::rasterizer_vertex_cache()
 {
   mem_zero(&m_cfg, sizeof(m_cfg));
   m_cache_alloc_pos=0;
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  m_concurrent_alloc_pos=0;
+  m_concurrent_alloc_pos_store=0;
+#endif
 }
 //----
 
@@ -68,6 +101,9 @@ void rasterizer_vertex_cache::init(const rasterizer_vertex_cache_cfg &cfg_)
 
 void rasterizer_vertex_cache::release()
 {
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  m_concurrent_alloc_pos=0;
+#endif
   if(!m_cfg.cache)
     return;
   m_cache_alloc_pos=0;
@@ -120,3 +156,77 @@ void *rasterizer_vertex_cache::alloc_cluster_cache(rasterizer_global_cluster_ind
   return (uint8_t*)alloc_bh+rasterizer_tform_cache_block_size;
 }
 //----------------------------------------------------------------------------
+
+#if PFC_BUILDOP_RASTERIZER_MT==1
+void rasterizer_vertex_cache::begin_concurrent()
+{
+  // switch to concurrent mode for the frame. all clusters are unstarted
+  // after release(), so the cache is just bump allocated from the beginning
+  if(!m_cfg.cache)
+    return;
+  m_concurrent_alloc_pos_store.store(0, std::memory_order_relaxed);
+  m_concurrent_alloc_pos=&m_concurrent_alloc_pos_store;
+}
+//----
+
+void rasterizer_vertex_cache::init_concurrent_view(rasterizer_vertex_cache &cache_, void *tmp_vout_, usize_t tmp_vout_size_)
+{
+  // share the cache and cluster states of the given cache with own temporal vout
+  m_cfg=cache_.m_cfg;
+  m_cfg.tmp_cluster_vout=tmp_vout_;
+  m_cfg.tmp_vout_size=tmp_vout_size_;
+  m_cache_alloc_pos=0;
+  m_concurrent_alloc_pos=cache_.m_concurrent_alloc_pos;
+}
+//----------------------------------------------------------------------------
+
+void *rasterizer_vertex_cache::acquire_concurrent_cluster_cache(rasterizer_global_cluster_index_t cluster_idx_, usize_t num_bytes_, bool &is_owner_)
+{
+  // use temporal vout for clusters without cache state
+  PFC_ASSERT_PEDANTIC(m_concurrent_alloc_pos);
+  PFC_ASSERT_MSG(num_bytes_<=m_cfg.tmp_vout_size, ("Temporal vertex output buffer is too small (%zi bytes) for the cluster vertex output (%zi bytes)\r\n", m_cfg.tmp_vout_size, num_bytes_));
+  is_owner_=true;
+  if(cluster_idx_>=m_cfg.max_clusters)
+    return m_cfg.tmp_cluster_vout;
+
+  // try to claim unstarted cluster for transform
+  atomic_vcache_offset_t &state=((atomic_vcache_offset_t*)m_cfg.cluster_vcache_offs)[cluster_idx_];
+  rasterizer_vertex_cache_offset_t offs=state.load(std::memory_order_acquire);
+  if(offs==vcache_cluster_unstarted && state.compare_exchange_strong(offs, rasterizer_vertex_cache_offset_t(vcache_cluster_in_progress), std::memory_order_acquire))
+  {
+    // bump allocate cache for the cluster or fall back to temporal vout if the cache is full
+    usize_t num_items=(num_bytes_+rasterizer_tform_cache_block_size-1)/rasterizer_tform_cache_block_size;
+    usize_t max_items=min<usize_t>(m_cfg.cache_size/rasterizer_tform_cache_block_size, vcache_cluster_uncached);
+    usize_t alloc_pos=m_concurrent_alloc_pos->fetch_add(num_items, std::memory_order_relaxed);
+    if(alloc_pos+num_items>max_items)
+    {
+      state.store(rasterizer_vertex_cache_offset_t(vcache_cluster_uncached), std::memory_order_relaxed);
+      return m_cfg.tmp_cluster_vout;
+    }
+    return (uint8_t*)m_cfg.cache+alloc_pos*rasterizer_tform_cache_block_size;
+  }
+
+  // wait for the transform by another worker
+  while(offs==vcache_cluster_in_progress)
+  {
+    std::this_thread::yield();
+    offs=state.load(std::memory_order_acquire);
+  }
+  if(offs==vcache_cluster_uncached)
+    return m_cfg.tmp_cluster_vout;
+  is_owner_=false;
+  return (uint8_t*)m_cfg.cache+offs*rasterizer_tform_cache_block_size;
+}
+//----
+
+void rasterizer_vertex_cache::publish_concurrent_cluster_cache(rasterizer_global_cluster_index_t cluster_idx_, const void *vout_)
+{
+  // mark cluster transform ready for other workers
+  if(vout_==m_cfg.tmp_cluster_vout)
+    return;
+  atomic_vcache_offset_t &state=((atomic_vcache_offset_t*)m_cfg.cluster_vcache_offs)[cluster_idx_];
+  usize_t offs=((const uint8_t*)vout_-(const uint8_t*)m_cfg.cache)/rasterizer_tform_cache_block_size;
+  state.store(rasterizer_vertex_cache_offset_t(offs), std::memory_order_release);
+}
+#endif
+//----------------------------------------------------------------------------
@@ -15,6 +15,9 @@
 //============================================================================
 // external
 #include "rasterizer_config.h"
+#if PFC_BUILDOP_RASTERIZER_MT==1
+#include <atomic>
+#endif
 namespace pfc
 {
 
@@ -49,6 +52,12 @@ struct rasterizer_vertex_cache_cfg
 //============================================================================
 // rasterizer_vertex_cache
 //============================================================================
+// Single-threaded ring cache of transformed cluster vertices, which evicts
+// the oldest clusters for new allocations. For parallel tile rendering the
+// cache switches to concurrent mode until release(), where clusters are
+// bump allocated and transformed exactly once by the first worker hitting
+// them. Clusters not fitting the cache in concurrent mode are transformed
+// to the worker temporal vout for each tile.
 class rasterizer_vertex_cache
 {
 public:
@@ -56,6 +65,10 @@ public:
   rasterizer_vertex_cache();
   void init(const rasterizer_vertex_cache_cfg&);
   void release();
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  void begin_concurrent();
+  void init_concurrent_view(rasterizer_vertex_cache&, void *tmp_vout_, usize_t tmp_vout_size_);
+#endif
   //--------------------------------------------------------------------------
 
   // accessors
@@ -67,6 +80,11 @@ public:
 
   // allocation
   void *alloc_cluster_cache(rasterizer_global_cluster_index_t, usize_t num_bytes_);
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  PFC_INLINE bool is_concurrent() const;
+  void *acquire_concurrent_cluster_cache(rasterizer_global_cluster_index_t, usize_t num_bytes_, bool &is_owner_);
+  void publish_concurrent_cluster_cache(rasterizer_global_cluster_index_t, const void *vout_);
+#endif
   //--------------------------------------------------------------------------
 
 private:
@@ -88,6 +106,10 @@ private:
 
   rasterizer_vertex_cache_cfg m_cfg;
   usize_t m_cache_alloc_pos;
+#if PFC_BUILDOP_RASTERIZER_MT==1
+  std::atomic<usize_t> *m_concurrent_alloc_pos;  // shared bump allocation position (null in single-threaded mode)
+  std::atomic<usize_t> m_concurrent_alloc_pos_store;
+#endif
 };
 //----------------------------------------------------------------------------
 
@@ -130,6 +152,14 @@ void *rasterizer_vertex_cache::tmp_cluster_vout() const
 {
   return m_cfg.tmp_cluster_vout;
 }
+//----
+
+#if PFC_BUILDOP_RASTERIZER_MT==1
+bool rasterizer_vertex_cache::is_concurrent() const
+{
+  return m_concurrent_alloc_pos!=0;
+}
+#endif
 //----------------------------------------------------------------------------
 
 //============================================================================
@@ -20,6 +20,11 @@ namespace pfc
 
 // new
 #define PFC_BUILDOP_RASTERIZER_HIZ 1
+#if defined(_WIN32) || defined(__linux__) || defined(__APPLE__)
+#define PFC_BUILDOP_RASTERIZER_MT 1  // parallel tile rendering in commit() with std::thread workers
+#else
+#define PFC_BUILDOP_RASTERIZER_MT 0
+#endif
 typedef uint16_t rasterizer_vertex_cache_offset_t;
 typedef uint16_t rasterizer_local_cluster_index_t;   // clusters for single shader dispatch
 typedef uint16_t rasterizer_global_cluster_index_t;  // clusters for all shader dispatches in a frame
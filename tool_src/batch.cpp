@@ -0,0 +1,300 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#if defined(PFC_PLATFORM_WIN32) || defined(PFC_PLATFORM_WIN64)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include "batch.h"
+#include "sxp_src/core/fsys/fsys.h"
+#include <algorithm>
+#include <cstring>
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  //==========================================================================
+  // path helpers
+  //==========================================================================
+  usize_t path_dir_size(const char *path_)
+  {
+    // return size of the directory part of the path including the trailing separator
+    usize_t size=0;
+    for(usize_t i=0; path_[i]; ++i)
+      if(path_[i]=='/' || path_[i]=='\\')
+        size=i+1;
+    return size;
+  }
+  //----
+
+  bool has_wildcards(const char *str_)
+  {
+    for(; *str_; ++str_)
+      if(*str_=='*' || *str_=='?')
+        return true;
+    return false;
+  }
+  //----
+
+  bool wildcard_match(const char *str_, const char *pattern_)
+  {
+    // match string against a pattern with '*' and '?' wildcards (greedy with single backtrack point)
+    const char *star_pattern=0, *star_str=0;
+    while(*str_)
+    {
+      if(*pattern_=='*')
+      {
+        star_pattern=++pattern_;
+        star_str=str_;
+      }
+#if defined(PFC_PLATFORM_WIN32) || defined(PFC_PLATFORM_WIN64)
+      else if(*pattern_=='?' || to_lower(*pattern_)==to_lower(*str_))
+#else
+      else if(*pattern_=='?' || *pattern_==*str_)
+#endif
+      {
+        ++pattern_;
+        ++str_;
+      }
+      else if(star_pattern)
+      {
+        pattern_=star_pattern;
+        str_=++star_str;
+      }
+      else
+        return false;
+    }
+    while(*pattern_=='*')
+      ++pattern_;
+    return !*pattern_;
+  }
+  //----
+
+  void make_output_filename(heap_str &res_, const char *input_file_, const char *output_dir_, const char *output_ext_)
+  {
+    // replace the input file extension with the output extension and place the file to the output directory
+    const char *filename=input_file_+path_dir_size(input_file_);
+    if(output_dir_ && *output_dir_)
+    {
+      res_=output_dir_;
+      char last_char=res_.c_str()[res_.size()-1];
+      if(last_char!='/' && last_char!='\\')
+        res_+="/";
+    }
+    else
+    {
+      res_=input_file_;
+      res_.resize(filename-input_file_);
+    }
+    usize_t stem_size=str_size(filename);
+    for(usize_t i=0; filename[i]; ++i)
+      if(filename[i]=='.')
+        stem_size=i;
+    usize_t base_size=res_.size();
+    res_+=filename;
+    res_.resize(base_size+stem_size);
+    res_+=output_ext_;
+  }
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // list_directory_files
+  //==========================================================================
+  bool list_directory_files(array<heap_str> &files_, const char *dir_, const char *pattern_)
+  {
+#if defined(PFC_PLATFORM_WIN32) || defined(PFC_PLATFORM_WIN64)
+    heap_str search_path=*dir_?dir_:"./";
+    search_path+="*";
+    WIN32_FIND_DATAA find_data;
+    HANDLE hfind=FindFirstFileA(search_path.c_str(), &find_data);
+    if(hfind==INVALID_HANDLE_VALUE)
+      return false;
+    do
+    {
+      if(!(find_data.dwFileAttributes&FILE_ATTRIBUTE_DIRECTORY) && wildcard_match(find_data.cFileName, pattern_))
+      {
+        heap_str &file=files_.push_back();
+        file=dir_;
+        file+=find_data.cFileName;
+      }
+    } while(FindNextFileA(hfind, &find_data));
+    FindClose(hfind);
+#else
+    DIR *dir=opendir(*dir_?dir_:".");
+    if(!dir)
+      return false;
+    while(const dirent *entry=readdir(dir))
+    {
+      if(!wildcard_match(entry->d_name, pattern_))
+        continue;
+      heap_str file=dir_;
+      file+=entry->d_name;
+      struct stat file_stat;
+      if(stat(file.c_str(), &file_stat)==0 && S_ISREG(file_stat.st_mode))
+        files_.push_back(file);
+    }
+    closedir(dir);
+#endif
+    return true;
+  }
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // parse_manifest_token
+  //==========================================================================
+  const char *parse_manifest_token(heap_str &res_, const char *str_, const char *str_end_)
+  {
+    // skip white spaces and read a (optionally quoted) token
+    while(str_<str_end_ && (*str_==' ' || *str_=='\t'))
+      ++str_;
+    const char *token_start=str_;
+    if(str_<str_end_ && *str_=='\"')
+    {
+      token_start=++str_;
+      while(str_<str_end_ && *str_!='\"')
+        ++str_;
+    }
+    else
+      while(str_<str_end_ && *str_!=' ' && *str_!='\t')
+        ++str_;
+    res_=token_start;
+    res_.resize(str_-token_start);
+    return str_<str_end_?str_+1:str_;
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// collect_batch_jobs
+//============================================================================
+bool pfc::collect_batch_jobs(array<batch_job> &jobs_, const char *batch_src_, const char *output_dir_, const char *output_ext_)
+{
+  if(has_wildcards(batch_src_))
+  {
+    // collect files matching the glob pattern
+    usize_t dir_size=path_dir_size(batch_src_);
+    heap_str dir=batch_src_;
+    dir.resize(dir_size);
+    if(has_wildcards(dir.c_str()))
+    {
+      errorf("> Error: Wildcards are supported only in the file name of the batch pattern \"%s\"\r\n", batch_src_);
+      return false;
+    }
+    array<heap_str> files;
+    if(!list_directory_files(files, dir.c_str(), batch_src_+dir_size))
+    {
+      errorf("> Error: Unable to list directory of the batch pattern \"%s\"\r\n", batch_src_);
+      return false;
+    }
+    std::sort(files.data(), files.data()+files.size(), [](const heap_str &f0_, const heap_str &f1_) {return std::strcmp(f0_.c_str(), f1_.c_str())<0;});
+
+    // setup jobs for the files
+    for(const heap_str &file:files)
+    {
+      batch_job &job=jobs_.push_back();
+      job.input_file=file;
+      make_output_filename(job.output_file, file.c_str(), output_dir_, output_ext_);
+    }
+  }
+  else
+  {
+    // read the manifest file
+    owner_ptr<bin_input_stream_base> fin=afs_open_read(batch_src_);
+    if(!fin.data)
+    {
+      errorf("> Error: Unable to read batch manifest file \"%s\"\r\n", batch_src_);
+      return false;
+    }
+    array<char> manifest;
+    char buf[4096];
+    while(usize_t num_bytes=fin->read_bytes(buf, sizeof(buf), false))
+      manifest.insert_back(num_bytes, buf);
+    manifest.push_back(0);
+
+    // parse "<input> [<output>]" lines, ignoring empty lines and #-comments
+    const char *str=manifest.data(), *str_end=str+manifest.size()-1;
+    while(str<str_end)
+    {
+      const char *line_end=str;
+      while(line_end<str_end && *line_end!='\n' && *line_end!='\r')
+        ++line_end;
+      heap_str input_file, output_file;
+      const char *s=parse_manifest_token(input_file, str, line_end);
+      parse_manifest_token(output_file, s, line_end);
+      if(input_file.size() && input_file.c_str()[0]!='#')
+      {
+        batch_job &job=jobs_.push_back();
+        job.input_file=input_file;
+        if(output_file.size())
+          job.output_file=output_file;
+        else
+          make_output_filename(job.output_file, input_file.c_str(), output_dir_, output_ext_);
+      }
+      str=line_end+1;
+    }
+  }
+
+  if(!jobs_.size())
+  {
+    errorf("> Error: No input files found for batch \"%s\"\r\n", batch_src_);
+    return false;
+  }
+  return true;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// log_batch_summary
+//============================================================================
+void pfc::log_batch_summary(const array<batch_job> &jobs_, double wall_time_)
+{
+  // collect timings
+  usize_t num_jobs=jobs_.size(), num_failed=0;
+  double total_time=0.0;
+  const batch_job *slowest_job=0;
+  for(const batch_job &job:jobs_)
+  {
+    total_time+=job.time;
+    if(!slowest_job || job.time>slowest_job->time)
+      slowest_job=&job;
+    if(!job.success)
+      ++num_failed;
+  }
+
+  // log failed files and the summary
+  logf("> --------------------------------------------------\r\n");
+  if(num_failed)
+  {
+    errorf("> %zi of %zi %s failed:\r\n", num_failed, num_jobs, num_jobs==1?"file":"files");
+    for(const batch_job &job:jobs_)
+      if(!job.success)
+        errorf(">   %s\r\n", job.input_file.c_str());
+  }
+  logf("> Batch: %zi %s converted, %zi failed\r\n", num_jobs-num_failed, num_jobs-num_failed==1?"file":"files", num_failed);
+  logf(">   Wall time: %.2fs, total conversion time: %.2fs (avg. %.2fs/file)\r\n", wall_time_, total_time, num_jobs?total_time/num_jobs:0.0);
+  if(slowest_job)
+  {
+    const char *slowest_file=slowest_job->input_file.c_str();
+    logf(">   Slowest: \"%s\" (%.2fs)\r\n", slowest_file+path_dir_size(slowest_file), slowest_job->time);
+  }
+}
+//----------------------------------------------------------------------------
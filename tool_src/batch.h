@@ -0,0 +1,50 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_BATCH_H
+#define PFC_MESHLETE_BATCH_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "sxp_src/core/containers.h"
+#include "sxp_src/core/str.h"
+namespace pfc
+{
+
+// new
+struct batch_job;
+bool collect_batch_jobs(array<batch_job>&, const char *batch_src_, const char *output_dir_, const char *output_ext_);
+void log_batch_summary(const array<batch_job>&, double wall_time_);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// batch_job
+//============================================================================
+struct batch_job
+{
+  batch_job()
+  {
+    success=false;
+    time=0.0;
+  }
+  //----
+
+  heap_str input_file;
+  heap_str output_file;
+  bool success;
+  double time;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
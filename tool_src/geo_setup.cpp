@@ -6,7 +6,8 @@
 //============================================================================
 
 #include "geo_setup.h"
-#include "vbuf_expr.h"
+#include "vbuf_kernel.h"
+#include "parallel.h"
 #include "sxp_src/core/math/geo3.h"
 #include "sxp_src/core/fsys/fsys.h"
 using namespace pfc;
@@ -19,15 +20,62 @@ using namespace pfc;
 namespace
 {
   //==========================================================================
-  // init_vbuf_expression_parser
+  // collect_vbuf_expression_streams
   //==========================================================================
-  void init_vbuf_expression_parser(vbuf_expression_parser_t &parser_, const sphere3f &mesh_bvol_, const mesh_vertex_buffer &vbuf_)
+  void add_vbuf_expression_stream(array<vbuf_expression_stream> &streams_, const char *name_, const void *data_, uint32_t num_vals_, uint8_t num_elems_, bool is_int_=false)
   {
-    // setup functions and globals
-    typedef vbuf_expression_parser_t::var_t var_t;
-    init_vbuf_expression_parser_funcs(parser_);
-    parser_.set_var("mesh_bvol_pos", var_t(&mesh_bvol_.pos, 1));
-    parser_.set_var("mesh_bvol_rad", var_t(&mesh_bvol_.rad, 1));
+    vbuf_expression_stream &s=streams_.push_back();
+    s.name=name_;
+    s.data=data_;
+    s.num_vals=num_vals_;
+    s.num_elems=num_elems_;
+    s.is_int=is_int_;
+  }
+  //----
+
+  PFC_INLINE bool is_identifier_char(char c_, bool is_first_)
+  {
+    return (c_>='a' && c_<='z') || (c_>='A' && c_<='Z') || c_=='_' || (!is_first_ && c_>='0' && c_<='9');
+  }
+  //----
+
+  bool is_vtx_format_var_referenced(const vtx_format &vfmt_, const char *var_name_)
+  {
+    // check if any element expression of the format references the variable identifier
+    usize_t name_len=str_size(var_name_);
+    for(const vtx_element &elem_: vfmt_.elements)
+    {
+      const char *expr=elem_.expr.c_str();
+      while(*expr)
+      {
+        // skip to the next identifier (numbers as a whole, e.g. exponents in "1e5")
+        if(!is_identifier_char(*expr, true))
+        {
+          bool is_number=*expr>='0' && *expr<='9';
+          ++expr;
+          while(is_number && is_identifier_char(*expr, false))
+            ++expr;
+          continue;
+        }
+        const char *ident=expr;
+        while(is_identifier_char(*expr, false))
+          ++expr;
+        if(usize_t(expr-ident)==name_len && mem_eq(ident, var_name_, name_len))
+          return true;
+      }
+    }
+    return false;
+  }
+  //----
+
+  enum {no_stream=0xffffffff};
+  //----
+
+  void collect_vbuf_expression_streams(array<vbuf_expression_stream> &streams_, unsigned &qframe_sidx_, unsigned &tbn32_sidx_, const vtx_format &vfmt_, const sphere3f &mesh_bvol_, const mesh_vertex_buffer &vbuf_)
+  {
+    // setup globals
+    add_vbuf_expression_stream(streams_, "mesh_bvol_pos", &mesh_bvol_.pos, 1, 3);
+    add_vbuf_expression_stream(streams_, "mesh_bvol_rad", &mesh_bvol_.rad, 1, 1);
 
     // access vertex data streams
     uint32_t num_vtx=(uint32_t)vbuf_.num_vertices();
@@ -42,28 +90,52 @@ namespace
     for(unsigned ci=0; ci<4; ++ci)
       color_data[ci]=(const vec4f*)vbuf_.vertex_channel(vtxchannel_color, ci);
 
-    // setup vertex data variables
-    parser_.set_var("pos", pos_data?var_t(pos_data, num_vtx):var_t(&vec3f::s_zero, 1));
-    parser_.set_var("normal", normal_data?var_t(normal_data, num_vtx):var_t(&vec3f::s_zero, 1));
-    parser_.set_var("binormal", binormal_data?var_t(binormal_data, num_vtx):var_t(&vec3f::s_zero, 1));
-    parser_.set_var("tangent", tangent_data?var_t(tangent_data, num_vtx):var_t(&vec3f::s_zero, 1));
-    parser_.set_var("uv", uv_data[0]?var_t(uv_data[0], num_vtx):var_t(&vec2f::s_zero, 1));
-    parser_.set_var("uv0", uv_data[0]?var_t(uv_data[0], num_vtx):var_t(&vec2f::s_zero, 1));
-    parser_.set_var("uv1", uv_data[1]?var_t(uv_data[1], num_vtx):var_t(&vec2f::s_zero, 1));
-    parser_.set_var("uv2", uv_data[2]?var_t(uv_data[2], num_vtx):var_t(&vec2f::s_zero, 1));
-    parser_.set_var("uv3", uv_data[3]?var_t(uv_data[3], num_vtx):var_t(&vec2f::s_zero, 1));
-    parser_.set_var("color", color_data[0]?var_t(color_data[0], num_vtx):var_t(&vec4f::s_zero, 1));
-    parser_.set_var("color0", color_data[0]?var_t(color_data[0], num_vtx):var_t(&vec4f::s_zero, 1));
-    parser_.set_var("color1", color_data[1]?var_t(color_data[1], num_vtx):var_t(&vec4f::s_zero, 1));
-    parser_.set_var("color2", color_data[2]?var_t(color_data[2], num_vtx):var_t(&vec4f::s_zero, 1));
-    parser_.set_var("color3", color_data[3]?var_t(color_data[3], num_vtx):var_t(&vec4f::s_zero, 1));
+    // setup vertex data streams (missing channels as uniform zero)
+    add_vbuf_expression_stream(streams_, "pos", pos_data?pos_data:&vec3f::s_zero, pos_data?num_vtx:1, 3);
+    add_vbuf_expression_stream(streams_, "normal", normal_data?normal_data:&vec3f::s_zero, normal_data?num_vtx:1, 3);
+    add_vbuf_expression_stream(streams_, "binormal", binormal_data?binormal_data:&vec3f::s_zero, binormal_data?num_vtx:1, 3);
+    add_vbuf_expression_stream(streams_, "tangent", tangent_data?tangent_data:&vec3f::s_zero, tangent_data?num_vtx:1, 3);
+    add_vbuf_expression_stream(streams_, "uv", uv_data[0]?uv_data[0]:&vec2f::s_zero, uv_data[0]?num_vtx:1, 2);
+    add_vbuf_expression_stream(streams_, "uv0", uv_data[0]?uv_data[0]:&vec2f::s_zero, uv_data[0]?num_vtx:1, 2);
+    add_vbuf_expression_stream(streams_, "uv1", uv_data[1]?uv_data[1]:&vec2f::s_zero, uv_data[1]?num_vtx:1, 2);
+    add_vbuf_expression_stream(streams_, "uv2", uv_data[2]?uv_data[2]:&vec2f::s_zero, uv_data[2]?num_vtx:1, 2);
+    add_vbuf_expression_stream(streams_, "uv3", uv_data[3]?uv_data[3]:&vec2f::s_zero, uv_data[3]?num_vtx:1, 2);
+    add_vbuf_expression_stream(streams_, "color", color_data[0]?color_data[0]:&vec4f::s_zero, color_data[0]?num_vtx:1, 4);
+    add_vbuf_expression_stream(streams_, "color0", color_data[0]?color_data[0]:&vec4f::s_zero, color_data[0]?num_vtx:1, 4);
+    add_vbuf_expression_stream(streams_, "color1", color_data[1]?color_data[1]:&vec4f::s_zero, color_data[1]?num_vtx:1, 4);
+    add_vbuf_expression_stream(streams_, "color2", color_data[2]?color_data[2]:&vec4f::s_zero, color_data[2]?num_vtx:1, 4);
+    add_vbuf_expression_stream(streams_, "color3", color_data[3]?color_data[3]:&vec4f::s_zero, color_data[3]?num_vtx:1, 4);
 
+    // add tangent frame streams (only if referenced by the format). the data is generated per vertex chunk
+    qframe_sidx_=no_stream;
+    tbn32_sidx_=no_stream;
     if(normal_data && binormal_data && tangent_data)
     {
-      // generate quaternion and 32bit quantized rotations from the tangent frame
-      vec4f *qframe_data=(vec4f*)PFC_MEM_ALLOC(num_vtx*sizeof(vec4f));
-      int32_t *tbn32_data=(int32_t*)PFC_MEM_ALLOC(num_vtx*sizeof(uint32_t));
-      for(uint32_t i=0; i<num_vtx; ++i)
+      if(is_vtx_format_var_referenced(vfmt_, "qframe"))
+      {
+        qframe_sidx_=unsigned(streams_.size());
+        add_vbuf_expression_stream(streams_, "qframe", 0, num_vtx, 4);
+      }
+      if(is_vtx_format_var_referenced(vfmt_, "tbn32"))
+      {
+        tbn32_sidx_=unsigned(streams_.size());
+        add_vbuf_expression_stream(streams_, "tbn32", 0, num_vtx, 1, true);
+      }
+    }
+  }
+  //----
+
+  void generate_tangent_frames(vec4f *qframes_, int32_t *tbn32s_, const mesh_vertex_buffer &vbuf_, uint32_t first_vtx_, uint32_t num_vtx_, unsigned num_threads_)
+  {
+    // generate quaternion and 32bit quantized rotations from the tangent frame of the vertex range in parallel blocks
+    enum {tframe_block_size=16384};
+    const vec3f *normal_data=(const vec3f*)vbuf_.vertex_channel(vtxchannel_normal)+first_vtx_;
+    const vec3f *binormal_data=(const vec3f*)vbuf_.vertex_channel(vtxchannel_binormal)+first_vtx_;
+    const vec3f *tangent_data=(const vec3f*)vbuf_.vertex_channel(vtxchannel_tangent)+first_vtx_;
+    parallel_for((num_vtx_+tframe_block_size-1)/tframe_block_size, num_threads_, [&](uint32_t block_idx_, unsigned)
+    {
+      uint32_t i=block_idx_*tframe_block_size, i_end=min<uint32_t>(i+tframe_block_size, num_vtx_);
+      for(; i<i_end; ++i)
       {
         vec3f n=normal_data[i];
         vec3f b=unit_z(cross(n, tangent_data[i]));
@@ -72,158 +144,420 @@ namespace
           // setup quaternion rotation
           vec3f t=cross(b, n);
           bool is_right_handed=dot(b, binormal_data[i])<0.0f;
-          quatf q;
-          convert(q, mat33f(t, b, n));
-          qframe_data[i].set(q.x, q.y, q.z, is_right_handed?1.0f:0.0f);
+          if(qframes_)
+          {
+            quatf q;
+            convert(q, mat33f(t, b, n));
+            qframes_[i].set(q.x, q.y, q.z, is_right_handed?1.0f:0.0f);
+          }
 
           // setup 32bit quantized rotation
-          uint32_t tbn32=quantize_mat33_32(mat33f(t, is_right_handed?-b:b, n));
-          tbn32_data[i]=tbn32;
+          if(tbn32s_)
+            tbn32s_[i]=quantize_mat33_32(mat33f(t, is_right_handed?-b:b, n));
         }
         else
         {
-          qframe_data[i].set(0.0f, 0.0f, 0.0f, 1.0f);
-          vec2f oct=vec3_to_oct2x1(n);
-          uint32_t qx=uint32_t((oct.x+2.0f)*(0.25f*2047.0f)+0.5f); // 11 bits
-          uint32_t qy=uint32_t((oct.y+1.0f)*(0.5f*1023.0f)+0.5f);  // 10 bits
-          tbn32_data[i]=(qy<<11)|qx;
+          if(qframes_)
+            qframes_[i].set(0.0f, 0.0f, 0.0f, 1.0f);
+          if(tbn32s_)
+          {
+            vec2f oct=vec3_to_oct2x1(n);
+            uint32_t qx=uint32_t((oct.x+2.0f)*(0.25f*2047.0f)+0.5f); // 11 bits
+            uint32_t qy=uint32_t((oct.y+1.0f)*(0.5f*1023.0f)+0.5f);  // 10 bits
+            tbn32s_[i]=(qy<<11)|qx;
+          }
         }
       }
-
-      // setup expression variables
-      parser_.set_var("qframe", var_t(qframe_data, num_vtx));
-      ((var_t*)parser_.var("qframe"))->pinned_owner=true;
-      parser_.set_var("tbn32", var_t(tbn32_data, num_vtx));
-      ((var_t*)parser_.var("tbn32"))->pinned_owner=true;
-    }
+    });
   }
   //--------------------------------------------------------------------------
 
   //==========================================================================
-  // e_vtx_element_type
+  // vertex chunk evaluation
   //==========================================================================
-  enum e_vtx_element_type
+  enum {vtx_chunk_size=1024*1024};
+  enum {vtx_kernel_range_size=16384};
+  //----
+
+  void get_vbuf_expression_stream_range(array<vbuf_expression_stream> &range_streams_, const array<vbuf_expression_stream> &streams_, uint32_t first_vtx_, uint32_t num_vtx_)
   {
-    vtxelemtype_none,
-    // integer formats
-    vtxelemtype_int8,
-    vtxelemtype_uint8,
-    vtxelemtype_int16,
-    vtxelemtype_uint16,
-    vtxelemtype_int32,
-    vtxelemtype_uint32,
-    // float formats
-    vtxelemtype_float16,
-    vtxelemtype_float32,
-  };
-  PFC_ENUM(e_vtx_element_type);
+    // offset per-vertex streams to the vertex range (uniform streams as is)
+    range_streams_=streams_;
+    for(vbuf_expression_stream &s:range_streams_)
+      if(s.num_vals>1)
+      {
+        s.data=((const uint32_t*)s.data)+usize_t(first_vtx_)*s.num_elems;
+        s.num_vals=num_vtx_;
+      }
+  }
   //----
 
-  #define PFC_ENUM_TYPE e_vtx_element_type
-  #define PFC_ENUM_PREFIX vtxelemtype_
-  #define PFC_ENUM_VALS PFC_ENUM_VAL(int8)\
-                        PFC_ENUM_VAL(uint8)\
-                        PFC_ENUM_VAL(int16)\
-                        PFC_ENUM_VAL(uint16)\
-                        PFC_ENUM_VAL(int32)\
-                        PFC_ENUM_VAL(uint32)\
-                        PFC_ENUM_VAL(float16)\
-                        PFC_ENUM_VAL(float32)
-  #include "sxp_src/core/enum.inc"
+  void setup_chunk_vbuf_expression_streams(array<vbuf_expression_stream> &chunk_streams_, array<vec4f> &qframes_, array<int32_t> &tbn32s_, const array<vbuf_expression_stream> &streams_, unsigned qframe_sidx_, unsigned tbn32_sidx_, const mesh_vertex_buffer &vbuf_, uint32_t first_vtx_, uint32_t num_vtx_, unsigned num_threads_)
+  {
+    // offset streams to the chunk and generate tangent frames only for the chunk vertices
+    get_vbuf_expression_stream_range(chunk_streams_, streams_, first_vtx_, num_vtx_);
+    if(qframe_sidx_==no_stream && tbn32_sidx_==no_stream)
+      return;
+    qframes_.resize(qframe_sidx_!=no_stream?num_vtx_:0);
+    tbn32s_.resize(tbn32_sidx_!=no_stream?num_vtx_:0);
+    generate_tangent_frames(qframes_.data(), tbn32s_.data(), vbuf_, first_vtx_, num_vtx_, num_threads_);
+    if(qframe_sidx_!=no_stream)
+      chunk_streams_[qframe_sidx_].data=qframes_.data();
+    if(tbn32_sidx_!=no_stream)
+      chunk_streams_[tbn32_sidx_].data=tbn32s_.data();
+  }
   //----
 
-  unsigned vtx_element_type_size(e_vtx_element_type type_)
+  bool evaluate_vtx_format(vbuf_expression_parser_t &parser_, const vtx_format &vfmt_, uint8_t *vbuf_, unsigned vtx_size_, uint32_t num_vtx_, unsigned &failed_velem_idx_)
   {
-    switch(type_)
+    // evaluate element expressions over the vertex arrays of the parser streams
+    mem_zero(vbuf_, usize_t(num_vtx_)*vtx_size_);
+    unsigned velem_idx=0;
+    for(const vtx_element &elem_: vfmt_.elements)
     {
-      case vtxelemtype_int8:     return 1;
-      case vtxelemtype_uint8:    return 1;
-      case vtxelemtype_int16:    return 2;
-      case vtxelemtype_uint16:   return 2;
-      case vtxelemtype_int32:    return 4;
-      case vtxelemtype_uint32:   return 4;
-      case vtxelemtype_float16:  return 2;
-      case vtxelemtype_float32:  return 4;
-      default: PFC_ERRORF("Unsupported vertex element type \"%s\"\r\n", enum_string(type_));
+      vbuf_expression_value v=parser_.evaluate(elem_.expr.c_str());
+      if(!v.num_data_elems)
+      {
+        failed_velem_idx_=velem_idx;
+        return false;
+      }
+      switch(elem_.type)
+      {
+        case vtxelemtype_int8:    v.get((int8_t*)vbuf_, num_vtx_, vtx_size_); break;
+        case vtxelemtype_uint8:   v.get((uint8_t*)vbuf_, num_vtx_, vtx_size_); break;
+        case vtxelemtype_int16:   v.get((int16_t*)vbuf_, num_vtx_, vtx_size_); break;
+        case vtxelemtype_uint16:  v.get((uint16_t*)vbuf_, num_vtx_, vtx_size_); break;
+        case vtxelemtype_int32:   v.get((int32_t*)vbuf_, num_vtx_, vtx_size_); break;
+        case vtxelemtype_uint32:  v.get((uint32_t*)vbuf_, num_vtx_, vtx_size_); break;
+        case vtxelemtype_float16: v.get((vtx_float16*)vbuf_, num_vtx_, vtx_size_); break;
+        case vtxelemtype_float32: v.get((float32_t*)vbuf_, num_vtx_, vtx_size_); break;
+        default: PFC_ERROR_NOT_IMPL();
+      }
+      vbuf_+=vtx_element_type_size(elem_.type);
+      ++velem_idx;
     }
-    return 0;
+    return true;
   }
   //--------------------------------------------------------------------------
 
   //==========================================================================
-  // vtx_element
+  // hash_vertex
   //==========================================================================
-  struct vtx_element
-  { PFC_MONO(vtx_element) {PFC_VAR2(type, expr);}
-    e_vtx_element_type type;
-    heap_str expr;
-  };
+  PFC_INLINE uint32_t rotl32(uint32_t v_, unsigned shift_)
+  {
+    return (v_<<shift_)|(v_>>(32-shift_));
+  }
+  //----
+
+  uint32_t hash_vertex(const uint8_t *data_, unsigned size_)
+  {
+    // MurmurHash3 (x86_32) of the packed vertex data
+    uint32_t h=size_;
+    for(; size_>=4; size_-=4, data_+=4)
+    {
+      uint32_t k;
+      mem_copy(&k, data_, 4);
+      h^=rotl32(k*0xcc9e2d51, 15)*0x1b873593;
+      h=rotl32(h, 13)*5+0xe6546b64;
+    }
+    if(size_)
+    {
+      uint32_t k=0;
+      mem_copy(&k, data_, size_);
+      h^=rotl32(k*0xcc9e2d51, 15)*0x1b873593;
+    }
+    h^=h>>16;
+    h*=0x85ebca6b;
+    h^=h>>13;
+    h*=0xc2b2ae35;
+    h^=h>>16;
+    return h;
+  }
   //--------------------------------------------------------------------------
 
   //==========================================================================
-  // vtx_format
+  // vertex_welder
   //==========================================================================
-  struct vtx_format
-  { PFC_MONO(vtx_format) {PFC_VAR2(id, name);}
-    PFC_INLINE bool operator==(const char *name_) const  {return name==name_;}
+  class vertex_welder
+  {
+  public:
+    // construction
+    vertex_welder(unsigned vtx_size_, uint32_t expected_num_vtx_, unsigned num_threads_);
+    //------------------------------------------------------------------------
+
+    // welding
+    void weld(const uint8_t *vdata_, const vec3f *vpos_, uint32_t num_vtx_, uint32_t *reindices_, array<uint8_t> &vbuf_, array<vec3f> &vertices_);
+    //------------------------------------------------------------------------
+
+  private:
+    enum {pending_flag=0x80000000};
+    enum {empty_slot=0xffffffff};
+    //------------------------------------------------------------------------
+
+    //========================================================================
+    // partition
+    //========================================================================
+    struct partition
+    {
+      array<uint32_t> slots;
+      array<uint32_t> slot_hashes;
+      array<uint32_t> pending_slots;
+      uint32_t num_entries;
+    };
+    //------------------------------------------------------------------------
+
+    void insert_partition(partition&, const uint32_t *vidx_, uint32_t num_vidx_, const uint8_t *vdata_, const uint8_t *vbuf_data_);
+    void grow_partition(partition&);
     //------------------------------------------------------------------------
 
-    uint8_t id;
-    heap_str name;
-    array<vtx_element> elements;
+    const unsigned m_vtx_size;
+    const unsigned m_num_threads;
+    unsigned m_partition_shift;
+    array<partition> m_partitions;
+    array<uint32_t> m_hashes;
+    array<uint32_t> m_reps;
+    array<uint32_t> m_partition_vidx;
+    array<uint32_t> m_partition_starts;
   };
   //--------------------------------------------------------------------------
 
-  //==========================================================================
-  // vtx_float16
-  //==========================================================================
-  struct vtx_float16
+  vertex_welder::vertex_welder(unsigned vtx_size_, uint32_t expected_num_vtx_, unsigned num_threads_)
+    :m_vtx_size(vtx_size_)
+    ,m_num_threads(num_threads_)
   {
-    PFC_INLINE vtx_float16(float32_t v_)  {data=fp32_to_s16f(clamp(v_, -65504.0f, 65504.0f));}
-    PFC_INLINE vtx_float16(int32_t v_)    {data=fp32_to_s16f(float32_t(clamp(v_, -65504, 65504)));}
-    uint16_t data;
-  };
-  //--------------------------------------------------------------------------
+    // partition the hash space with the top hash bits for parallel insertion (single partition if not threaded)
+    unsigned num_partition_bits=0;
+    while(num_threads_>1 && (1u<<num_partition_bits)<num_threads_*4 && num_partition_bits<8)
+      ++num_partition_bits;
+    m_partition_shift=32-num_partition_bits;
+    m_partitions.resize(1u<<num_partition_bits);
 
-  //==========================================================================
-  // vtx_id
-  //==========================================================================
-  struct vtx_id
+    // size partition tables for max 50% load factor of the expected vertex count
+    uint32_t slots_per_partition=64;
+    while(slots_per_partition<2*expected_num_vtx_/m_partitions.size())
+      slots_per_partition*=2;
+    for(partition &p:m_partitions)
+    {
+      p.slots.resize(slots_per_partition, uint32_t(empty_slot));
+      p.slot_hashes.resize(slots_per_partition);
+      p.num_entries=0;
+    }
+  }
+  //----
+
+  void vertex_welder::weld(const uint8_t *vdata_, const vec3f *vpos_, uint32_t num_vtx_, uint32_t *reindices_, array<uint8_t> &vbuf_, array<vec3f> &vertices_)
   {
-    PFC_INLINE bool operator<(const vtx_id &vid_) const  {return crc32<vid_.crc32;}
-    uint32_t crc32;
-    uint32_t orig_vidx;
-  };
+    // hash vertices
+    enum {hash_block_size=16384};
+    m_hashes.resize(num_vtx_);
+    m_reps.resize(num_vtx_);
+    uint32_t *hashes=m_hashes.data();
+    parallel_for((num_vtx_+hash_block_size-1)/hash_block_size, m_num_threads, [&](uint32_t block_idx_, unsigned)
+    {
+      uint32_t vidx=block_idx_*hash_block_size, vidx_end=min<uint32_t>(vidx+hash_block_size, num_vtx_);
+      for(; vidx<vidx_end; ++vidx)
+        hashes[vidx]=hash_vertex(vdata_+vidx*m_vtx_size, m_vtx_size);
+    });
+
+    // bucket vertex indices by hash partition preserving the vertex order
+    unsigned num_partitions=(unsigned)m_partitions.size();
+    m_partition_starts.resize(num_partitions+1);
+    m_partition_vidx.resize(num_vtx_);
+    uint32_t *pstarts=m_partition_starts.data();
+    uint32_t *pvidx=m_partition_vidx.data();
+    mem_zero(pstarts, (num_partitions+1)*sizeof(uint32_t));
+    if(num_partitions>1)
+    {
+      for(uint32_t vidx=0; vidx<num_vtx_; ++vidx)
+        ++pstarts[(hashes[vidx]>>m_partition_shift)+1];
+      for(unsigned pi=0; pi<num_partitions; ++pi)
+        pstarts[pi+1]+=pstarts[pi];
+      for(uint32_t vidx=0; vidx<num_vtx_; ++vidx)
+        pvidx[pstarts[hashes[vidx]>>m_partition_shift]++]=vidx;
+      for(unsigned pi=num_partitions; pi>0; --pi)
+        pstarts[pi]=pstarts[pi-1];
+      pstarts[0]=0;
+    }
+    else
+    {
+      for(uint32_t vidx=0; vidx<num_vtx_; ++vidx)
+        pvidx[vidx]=vidx;
+      pstarts[1]=num_vtx_;
+    }
+
+    // insert vertices to the partition hash tables
+    const uint8_t *vbuf_data=vbuf_.data();
+    parallel_for(num_partitions, m_num_threads, [&](uint32_t pidx_, unsigned)
+    {
+      insert_partition(m_partitions[pidx_], pvidx+pstarts[pidx_], pstarts[pidx_+1]-pstarts[pidx_], vdata_, vbuf_data);
+    });
+
+    // assign unique indices to new vertices in the vertex order and reindex duplicates
+    const uint32_t *reps=m_reps.data();
+    uint32_t num_unique=(uint32_t)vertices_.size();
+    uint32_t num_new=0;
+    for(uint32_t vidx=0; vidx<num_vtx_; ++vidx)
+      num_new+=reps[vidx]==(vidx|pending_flag);
+    vbuf_.resize((num_unique+num_new)*m_vtx_size);
+    vertices_.reserve(num_unique+num_new);
+    uint8_t *new_vdata=vbuf_.data()+num_unique*m_vtx_size;
+    for(uint32_t vidx=0; vidx<num_vtx_; ++vidx)
+    {
+      uint32_t rep=reps[vidx];
+      if(rep==(vidx|pending_flag))
+      {
+        reindices_[vidx]=num_unique++;
+        mem_copy(new_vdata, vdata_+vidx*m_vtx_size, m_vtx_size);
+        new_vdata+=m_vtx_size;
+        vertices_.push_back(vpos_[vidx]);
+      }
+      else
+        reindices_[vidx]=rep&pending_flag?reindices_[rep&~pending_flag]:rep;
+    }
+
+    // replace pending table entries with the final vertex indices
+    parallel_for(num_partitions, m_num_threads, [&](uint32_t pidx_, unsigned)
+    {
+      partition &p=m_partitions[pidx_];
+      uint32_t *slots=p.slots.data();
+      for(uint32_t slot_idx:p.pending_slots)
+        slots[slot_idx]=reindices_[slots[slot_idx]&~pending_flag];
+      p.pending_slots.clear();
+    });
+  }
+  //----
+
+  void vertex_welder::insert_partition(partition &p_, const uint32_t *vidx_, uint32_t num_vidx_, const uint8_t *vdata_, const uint8_t *vbuf_data_)
+  {
+    // find or insert vertices with linear probing. table entries are either final vertex indices or
+    // indices to the currently welded vertex data flagged as pending
+    const uint32_t *hashes=m_hashes.data();
+    uint32_t *reps=m_reps.data();
+    for(uint32_t i=0; i<num_vidx_; ++i)
+    {
+      uint32_t vidx=vidx_[i];
+      uint32_t hash=hashes[vidx];
+      const uint8_t *vdata=vdata_+vidx*m_vtx_size;
+      uint32_t slot_mask=uint32_t(p_.slots.size()-1);
+      uint32_t *slots=p_.slots.data();
+      const uint32_t *slot_hashes=p_.slot_hashes.data();
+      uint32_t slot_idx=hash&slot_mask;
+      while(true)
+      {
+        uint32_t entry=slots[slot_idx];
+        if(entry==empty_slot)
+        {
+          // add new entry
+          slots[slot_idx]=vidx|pending_flag;
+          p_.slot_hashes[slot_idx]=hash;
+          p_.pending_slots.push_back(slot_idx);
+          reps[vidx]=vidx|pending_flag;
+          if(++p_.num_entries*2>p_.slots.size())
+            grow_partition(p_);
+          break;
+        }
+        if(slot_hashes[slot_idx]==hash)
+        {
+          // check for duplicate vertex
+          const uint8_t *entry_vdata=entry&pending_flag?vdata_+(entry&~pending_flag)*m_vtx_size:vbuf_data_+entry*m_vtx_size;
+          if(mem_eq(vdata, entry_vdata, m_vtx_size))
+          {
+            reps[vidx]=entry;
+            break;
+          }
+        }
+        slot_idx=(slot_idx+1)&slot_mask;
+      }
+    }
+  }
+  //----
+
+  void vertex_welder::grow_partition(partition &p_)
+  {
+    // rehash entries to a table of double size
+    usize_t num_slots=p_.slots.size();
+    array<uint32_t> old_slots(p_.slots), old_slot_hashes(p_.slot_hashes);
+    p_.slots.clear();
+    p_.slots.resize(num_slots*2, uint32_t(empty_slot));
+    p_.slot_hashes.resize(num_slots*2);
+    p_.pending_slots.clear();
+    uint32_t *slots=p_.slots.data(), *slot_hashes=p_.slot_hashes.data();
+    uint32_t slot_mask=uint32_t(num_slots*2-1);
+    for(usize_t i=0; i<num_slots; ++i)
+    {
+      uint32_t entry=old_slots[i];
+      if(entry==empty_slot)
+        continue;
+      uint32_t hash=old_slot_hashes[i];
+      uint32_t slot_idx=hash&slot_mask;
+      while(slots[slot_idx]!=empty_slot)
+        slot_idx=(slot_idx+1)&slot_mask;
+      slots[slot_idx]=entry;
+      slot_hashes[slot_idx]=hash;
+      if(entry&pending_flag)
+        p_.pending_slots.push_back(slot_idx);
+    }
+  }
 } // namespace <anonymous>
 //----------------------------------------------------------------------------
 
 
 //============================================================================
-// setup_geometry
+// vtx_element_type_size
 //============================================================================
-bool pfc::setup_mesh_geometry(const mesh &mesh_, const mesh_geometry_setup_cfg &cfg_, mesh_geometry &mgeo_, mesh_geometry_container &mgeo_container_)
+unsigned pfc::vtx_element_type_size(e_vtx_element_type type_)
 {
-  // parse vertex config
-  logf("> Setting up geometry...\r\n");
-  array<vtx_format> vtx_formats;
+  switch(type_)
   {
-    owner_ptr<bin_input_stream_base> xmlf=afs_open_read(cfg_.vcfg_file);
-    if(!xmlf.data)
-    {
-      errorf(">   Error: Unable to read vertex config file \"%s\"\r\n", cfg_.vcfg_file);
-      return false;
-    }
-    xml_stream_parser xml_parser;
-    xml_parser.begin_element("vertex_formats")
-                .begin_element("format", vtx_formats, true)
-                  .begin_element("element", &vtx_format::elements, true).end_element()
-                .end_element()
-              .end_element();
-    xml_input_stream xmls(*xmlf);
-    xml_parser.process_stream(xmls);
+    case vtxelemtype_int8:     return 1;
+    case vtxelemtype_uint8:    return 1;
+    case vtxelemtype_int16:    return 2;
+    case vtxelemtype_uint16:   return 2;
+    case vtxelemtype_int32:    return 4;
+    case vtxelemtype_uint32:   return 4;
+    case vtxelemtype_float16:  return 2;
+    case vtxelemtype_float32:  return 4;
+    default: PFC_ERRORF("Unsupported vertex element type \"%s\"\r\n", enum_string(type_));
+  }
+  return 0;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// load_vtx_format_config
+//============================================================================
+bool pfc::load_vtx_format_config(vtx_format_config &vcfg_, const char *vcfg_file_)
+{
+  // parse vertex format config file
+  owner_ptr<bin_input_stream_base> xmlf=afs_open_read(vcfg_file_);
+  if(!xmlf.data)
+  {
+    errorf("> Error: Unable to read vertex config file \"%s\"\r\n", vcfg_file_);
+    return false;
   }
+  xml_stream_parser xml_parser;
+  xml_parser.begin_element("vertex_formats")
+              .begin_element("format", vcfg_.formats, true)
+                .begin_element("element", &vtx_format::elements, true).end_element()
+              .end_element()
+            .end_element();
+  xml_input_stream xmls(*xmlf);
+  xml_parser.process_stream(xmls);
+  return true;
+}
+//----------------------------------------------------------------------------
 
+
+//============================================================================
+// setup_geometry
+//============================================================================
+bool pfc::setup_mesh_geometry(const mesh &mesh_, const mesh_geometry_setup_cfg &cfg_, mesh_geometry &mgeo_, mesh_geometry_container &mgeo_container_)
+{
   // calculate vertex size
+  if(cfg_.log_progress)
+    logf("> Setting up geometry...\r\n");
+  const array<vtx_format> &vtx_formats=cfg_.vcfg->formats;
   const vtx_format *vfmt=linear_search(vtx_formats.data(), vtx_formats.size(), cfg_.vfmt_name);
   if(!vfmt)
   {
@@ -233,7 +567,8 @@ bool pfc::setup_mesh_geometry(const mesh &mesh_, const mesh_geometry_setup_cfg &
   unsigned vtx_size=0;
   for(const vtx_element &elem_: vfmt->elements)
     vtx_size+=vtx_element_type_size(elem_.type);
-  logf(">   Vertex format: \"%s\" (%i bytes)\r\n", cfg_.vfmt_name, vtx_size);
+  if(cfg_.log_progress)
+    logf(">   Vertex format: \"%s\" (%i bytes)\r\n", cfg_.vfmt_name, vtx_size);
 
   // calculate mesh bounding volume
   const mesh_vertex_buffer &mesh_vbuf=mesh_.vertex_buffer(0);
@@ -242,127 +577,158 @@ bool pfc::setup_mesh_geometry(const mesh &mesh_, const mesh_geometry_setup_cfg &
   seed_oobox3f mesh_sbox=seed_oobox3_discrete(mesh_pos_data, num_mesh_vtx, discrete_axes3_49);
   sphere3f mesh_bvol=bounding_sphere3_exp(mesh_pos_data, num_mesh_vtx, mesh_sbox, true);
 
-  // generate temporary vertex buffer
-  uint32_t tmp_vbuf_size=(uint32_t)num_mesh_vtx*vtx_size;
-  owner_data tmp_vbuf=PFC_MEM_ALLOC(tmp_vbuf_size);
+  // setup geometry segments with the source mesh vertex indices, which are
+  // remapped to the welded vertices after all vertex chunks are welded
+  usize_t num_mesh_segs=mesh_.num_segments();
+  const uint32_t *mesh_indices=mesh_.indices();
+  usize_t num_seg_indices=0;
+  for(unsigned msi=0; msi<num_mesh_segs; ++msi)
   {
-    uint8_t *tmp_vbuf_data=(uint8_t*)tmp_vbuf.data;
-    mem_zero(tmp_vbuf_data, tmp_vbuf_size);
-    vbuf_expression_parser_t expr_parser;
-    init_vbuf_expression_parser(expr_parser, mesh_bvol, mesh_vbuf);
-    unsigned velem_idx=0;
-    for(const vtx_element &elem_: vfmt->elements)
+    const mesh_segment &mseg=mesh_.segment(msi);
+    if(mseg.primitive_type==meshprim_trilist || mseg.primitive_type==meshprim_tristrip)
+      num_seg_indices+=usize_t(mseg.num_primitives)*3;
+  }
+  mgeo_container_.indices.resize(num_seg_indices);
+  uint32_t *seg_idx_data=mgeo_container_.indices.data();
+  for(unsigned msi=0; msi<num_mesh_segs; ++msi)
+  {
+    // validate primitive type
+    const mesh_segment &mseg=mesh_.segment(msi);
+    if(mseg.primitive_type!=meshprim_trilist && mseg.primitive_type!=meshprim_tristrip)
+      continue;
+
+    // add new segment
+    mesh_geometry_segment &mgseg=mgeo_container_.segs.push_back();
+    mgseg.material_id=crc32(mseg.material_name.c_str());
+    mgseg.start_tri_idx=uint32_t(seg_idx_data-mgeo_container_.indices.data());
+    mgseg.num_tris=mseg.num_primitives;
+    const unsigned prim_step=mseg.primitive_type==meshprim_trilist?3:1;
+    const uint32_t *seg_indices=mesh_indices+mseg.prim_start_index;
+    for(uint32_t ti=0; ti<mseg.num_primitives; ++ti)
     {
-      const char *expr=elem_.expr.c_str();
-      vbuf_expression_value v=expr_parser.evaluate(expr);
-      if(!v.num_data_elems)
-      {
-        errorf(">   Error: Failed to evaluate vertex format \"%s\" expression for element #%i: \"%s\"\r\n", cfg_.vfmt_name, velem_idx+1, expr);
-        return false;
-      }
-      switch(elem_.type)
-      {
-        case vtxelemtype_int8:    v.get((int8_t*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        case vtxelemtype_uint8:   v.get((uint8_t*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        case vtxelemtype_int16:   v.get((int16_t*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        case vtxelemtype_uint16:  v.get((uint16_t*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        case vtxelemtype_int32:   v.get((int32_t*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        case vtxelemtype_uint32:  v.get((uint32_t*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        case vtxelemtype_float16: v.get((vtx_float16*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        case vtxelemtype_float32: v.get((float32_t*)tmp_vbuf_data, num_mesh_vtx, vtx_size); break;
-        default: PFC_ERROR_NOT_IMPL();
-      }
-      tmp_vbuf_data+=vtx_element_type_size(elem_.type);
-      ++velem_idx;
+      seg_idx_data[0]=seg_indices[0];
+      seg_idx_data[1]=seg_indices[1];
+      seg_idx_data[2]=seg_indices[2];
+      seg_indices+=prim_step;
+      seg_idx_data+=3;
     }
   }
 
-  // remove vertex duplicates for the target vertex format
-  mgeo_container_.vbuf=PFC_MEM_ALLOC(tmp_vbuf_size);
-  array<uint32_t> reindices(num_mesh_vtx, 0xffffffff);
-  uint32_t *reindices_data=reindices.data();
-  uint32_t num_vtx=0;
+  // generate vertex buffer in chunks of vertices and remove vertex duplicates
+  // for the target vertex format. all per-vertex temporaries except the source
+  // to welded vertex remap table are chunk sized
+  uint32_t chunk_size=min<uint32_t>(num_mesh_vtx, vtx_chunk_size);
   {
-    // create crc32 (of data) sorted list of vertices
-    array<vtx_id> vtx_ids(num_mesh_vtx);
-    vtx_id *vtx_ids_data=vtx_ids.data();
-    const uint8_t *tmp_vbuf_data=(uint8_t*)tmp_vbuf.data;
-    for(uint32_t vidx=0; vidx<num_mesh_vtx; ++vidx)
-    {
-      vtx_id &vid=vtx_ids_data[vidx];
-      vid.crc32=crc32(tmp_vbuf_data+vidx*vtx_size, vtx_size);
-      vid.orig_vidx=vidx;
-    }
-    quick_sort(vtx_ids_data, num_mesh_vtx);
+    // setup vertex format evaluation with compiled kernel or fall back to evaluating element expressions for vertex arrays
+    array<vbuf_expression_stream> vstreams, chunk_vstreams;
+    array<vec4f> qframes;
+    array<int32_t> tbn32s;
+    unsigned qframe_sidx, tbn32_sidx;
+    unsigned num_threads=max(cfg_.num_threads, 1u);
+    collect_vbuf_expression_streams(vstreams, qframe_sidx, tbn32_sidx, *vfmt, mesh_bvol, mesh_vbuf);
+    setup_chunk_vbuf_expression_streams(chunk_vstreams, qframes, tbn32s, vstreams, qframe_sidx, tbn32_sidx, mesh_vbuf, 0, chunk_size, num_threads);
+    vbuf_kernel vkernel;
+    bool use_kernel=vkernel.compile(*vfmt, chunk_vstreams.data(), chunk_vstreams.size());
+    usize_t scratch_size=use_kernel?vkernel.scratch_size():0;
+    owner_data scratch=PFC_MEM_ALLOC(scratch_size*num_threads);
 
-    // reindex vertices and build new vertex buffer
-    uint8_t *vbuf_data=(uint8_t*)mgeo_container_.vbuf.data;
-    for(uint32_t vidx=0; vidx<num_mesh_vtx; ++vidx)
+    // evaluate and weld vertex chunks
+    owner_data tmp_vbuf=PFC_MEM_ALLOC(usize_t(chunk_size)*vtx_size);
+    uint8_t *tmp_vbuf_data=(uint8_t*)tmp_vbuf.data;
+    array<uint32_t> reindices(num_mesh_vtx);
+    uint32_t *reindices_data=reindices.data();
+    uint32_t *indices_data=mgeo_container_.indices.data();
+    vertex_welder welder(vtx_size, chunk_size, num_threads);
+    for(uint32_t chunk_start=0; chunk_start<num_mesh_vtx; chunk_start+=chunk_size)
     {
-      // check for already reindexed vertex
-      const vtx_id &vid=vtx_ids_data[vidx];
-      if(reindices_data[vid.orig_vidx]!=0xffffffff)
-        continue;
-
-      // reindex the vertex and add new vertex buffer data
-      reindices_data[vid.orig_vidx]=num_vtx;
-      const void *ref_vdata=tmp_vbuf_data+vid.orig_vidx*vtx_size;
-      mem_copy(vbuf_data+num_vtx*vtx_size, ref_vdata, vtx_size);
-      mgeo_container_.vertices.push_back(mesh_pos_data[vid.orig_vidx]);
+      // offset the streams to the chunk (the first chunk was setup for the kernel compilation)
+      uint32_t num_chunk_vtx=min(chunk_size, num_mesh_vtx-chunk_start);
+      if(chunk_start)
+      {
+        setup_chunk_vbuf_expression_streams(chunk_vstreams, qframes, tbn32s, vstreams, qframe_sidx, tbn32_sidx, mesh_vbuf, chunk_start, num_chunk_vtx, num_threads);
+        if(use_kernel)
+          vkernel.set_stream_data(chunk_vstreams.data(), chunk_vstreams.size());
+      }
 
-      // search for duplicates
-      uint32_t ref_crc32=vid.crc32;
-      for(uint32_t tvidx=vidx+1; tvidx<num_mesh_vtx; ++tvidx)
+      if(use_kernel)
       {
-        const vtx_id &tvid=vtx_ids_data[tvidx];
-        if(ref_crc32!=tvid.crc32)
-          break;
-        if(mem_eq(ref_vdata, tmp_vbuf_data+tvid.orig_vidx*vtx_size, vtx_size))
-          reindices_data[tvid.orig_vidx]=num_vtx;
+        // run the kernel for vertex ranges of the chunk on worker threads with per-thread scratch
+        parallel_for((num_chunk_vtx+vtx_kernel_range_size-1)/vtx_kernel_range_size, num_threads, [&](uint32_t range_idx_, unsigned thread_idx_)
+        {
+          uint32_t range_start=range_idx_*vtx_kernel_range_size;
+          uint32_t num_range_vtx=min<uint32_t>(vtx_kernel_range_size, num_chunk_vtx-range_start);
+          vkernel.execute((uint8_t*)scratch.data+scratch_size*thread_idx_, tmp_vbuf_data+usize_t(range_start)*vtx_size, range_start, num_range_vtx);
+        });
+      }
+      else
+      {
+        // evaluate element expressions for a vertex range per thread with thread-local parser and arena
+        uint32_t range_size=(num_chunk_vtx+num_threads-1)/num_threads;
+        std::atomic<unsigned> failed_velem_idx(unsigned(-1));
+        parallel_for((num_chunk_vtx+range_size-1)/range_size, num_threads, [&](uint32_t range_idx_, unsigned)
+        {
+          uint32_t range_start=range_idx_*range_size;
+          uint32_t num_range_vtx=min(range_size, num_chunk_vtx-range_start);
+          array<vbuf_expression_stream> range_vstreams;
+          get_vbuf_expression_stream_range(range_vstreams, chunk_vstreams, range_start, num_range_vtx);
+          vbuf_expression_arena expr_arena(num_range_vtx);
+          vbuf_expression_parser_t expr_parser;
+          init_vbuf_expression_parser_funcs(expr_parser);
+          set_vbuf_expression_streams(expr_parser, range_vstreams.data(), range_vstreams.size());
+          unsigned velem_idx;
+          if(!evaluate_vtx_format(expr_parser, *vfmt, tmp_vbuf_data+usize_t(range_start)*vtx_size, vtx_size, num_range_vtx, velem_idx))
+            failed_velem_idx=velem_idx;
+        });
+        if(failed_velem_idx!=unsigned(-1))
+        {
+          errorf(">   Error: Failed to evaluate vertex format \"%s\" expression for element #%i: \"%s\"\r\n", cfg_.vfmt_name, failed_velem_idx+1, vfmt->elements[failed_velem_idx].expr.c_str());
+          return false;
+        }
       }
-      ++num_vtx;
+      welder.weld(tmp_vbuf_data, mesh_pos_data+chunk_start, num_chunk_vtx, reindices_data+chunk_start, mgeo_container_.vbuf, mgeo_container_.vertices);
     }
+
+    // remap the segment indices to the welded vertices in a single pass
+    parallel_for(uint32_t((num_seg_indices+vtx_kernel_range_size-1)/vtx_kernel_range_size), num_threads, [&](uint32_t range_idx_, unsigned)
+    {
+      usize_t i=usize_t(range_idx_)*vtx_kernel_range_size, i_end=min<usize_t>(i+vtx_kernel_range_size, num_seg_indices);
+      for(; i<i_end; ++i)
+        indices_data[i]=reindices_data[indices_data[i]];
+    });
   }
+  uint32_t num_vtx=(uint32_t)mgeo_container_.vertices.size();
 
-  // setup geometry segments
-  usize_t num_mesh_segs=mesh_.num_segments();
-  const uint32_t *mesh_indices=mesh_.indices();
-  mgeo_container_.indices.reserve(mesh_.num_indices());
-  for(unsigned msi=0; msi<num_mesh_segs; ++msi)
+  // remove degenerate triangles of the welded segments
+  uint32_t *dst_indices=mgeo_container_.indices.data();
+  for(mesh_geometry_segment &mgseg:mgeo_container_.segs)
   {
-    // validate primitive type
-    const mesh_segment &mseg=mesh_.segment(msi);
-    if(mseg.primitive_type!=meshprim_trilist && mseg.primitive_type!=meshprim_tristrip)
-      continue;
-
-    // add new segment
-    mesh_geometry_segment &mgseg=mgeo_container_.segs.push_back();
-    mgseg.material_id=crc32(mseg.material_name.c_str());
-    mgseg.start_tri_idx=(uint32_t)mgeo_container_.indices.size();
-    const unsigned prim_step=mseg.primitive_type==meshprim_trilist?3:1;
-    const uint32_t *seg_indices=mesh_indices+mseg.prim_start_index;
+    const uint32_t *src_indices=mgeo_container_.indices.data()+mgseg.start_tri_idx;
+    uint32_t num_src_tris=mgseg.num_tris;
+    mgseg.start_tri_idx=uint32_t(dst_indices-mgeo_container_.indices.data());
     mgseg.num_tris=0;
-    for(uint32_t ti=0; ti<mseg.num_primitives; ++ti)
+    for(uint32_t ti=0; ti<num_src_tris; ++ti)
     {
       // check for degenerate triangle
-      uint32_t tidx[3]={reindices_data[seg_indices[0]],
-                        reindices_data[seg_indices[1]],
-                        reindices_data[seg_indices[2]]};
-      seg_indices+=prim_step;
+      uint32_t tidx[3]={src_indices[0], src_indices[1], src_indices[2]};
+      src_indices+=3;
       if(tidx[0]==tidx[1] || tidx[0]==tidx[2] || tidx[1]==tidx[2])
         continue;
-      mgeo_container_.indices.insert_back(3, tidx);
+      dst_indices[0]=tidx[0];
+      dst_indices[1]=tidx[1];
+      dst_indices[2]=tidx[2];
+      dst_indices+=3;
       ++mgseg.num_tris;
     }
     mgseg.sbox=seed_oobox3_discrete(mgeo_container_.vertices.data(), mgseg.num_tris*3, discrete_axes3_49, mgeo_container_.indices.data()+mgseg.start_tri_idx);
   }
+  mgeo_container_.indices.resize(dst_indices-mgeo_container_.indices.data());
 
   // setup mesh geometry
   mgeo_.bvol=mesh_bvol;
   mgeo_.segs=mgeo_container_.segs.data();
   mgeo_.vertices=mgeo_container_.vertices.data();
   mgeo_.indices=mgeo_container_.indices.data();
-  mgeo_.vbuf=mgeo_container_.vbuf.data;
+  mgeo_.vbuf=mgeo_container_.vbuf.data();
   mgeo_.vbuf_size=num_vtx*vtx_size;
   mgeo_.vfmt_id=vfmt->id;
   mgeo_.num_segs=mgeo_container_.segs.size();
@@ -370,7 +736,56 @@ bool pfc::setup_mesh_geometry(const mesh &mesh_, const mesh_geometry_setup_cfg &
   mgeo_.num_indices=uint32_t(mgeo_container_.indices.size());
   usize_t num_segs=mgeo_container_.segs.size();
   unsigned num_tris=unsigned(mgeo_.num_indices/3);
-  logf(">   %i %s, %i %s, %i %s\r\n", num_segs, num_segs>1?"segments":"segment", num_vtx, num_vtx>1?"vertices":"vertex", num_tris, num_tris>1?"triangles":"triangle");
+  if(cfg_.log_progress)
+    logf(">   %i %s, %i %s, %i %s\r\n", num_segs, num_segs>1?"segments":"segment", num_vtx, num_vtx>1?"vertices":"vertex", num_tris, num_tris>1?"triangles":"triangle");
   return true;
 }
 //----------------------------------------------------------------------------
+
+
+//============================================================================
+// reorder_mesh_geometry_vertices
+//============================================================================
+void pfc::reorder_mesh_geometry_vertices(mesh_geometry &mgeo_, mesh_geometry_container &mgeo_container_, p3g_mesh_geometry &p3g_geo_)
+{
+  // assign new vertex indices in the first reference order of the meshlet sequence (unreferenced vertices last)
+  uint32_t num_vtx=(uint32_t)mgeo_.num_vertices;
+  array<uint32_t> remap;
+  remap.resize(num_vtx, uint32_t(-1));
+  uint32_t *remap_data=remap.data();
+  uint32_t num_remapped=0;
+  for(uint32_t &vidx:p3g_geo_.mlet_vidx)
+  {
+    uint32_t &new_vidx=remap_data[vidx];
+    if(new_vidx==uint32_t(-1))
+      new_vidx=num_remapped++;
+    vidx=new_vidx;
+  }
+  for(uint32_t vidx=0; vidx<num_vtx; ++vidx)
+    if(remap_data[vidx]==uint32_t(-1))
+      remap_data[vidx]=num_remapped++;
+
+  // reorder vertex data and remap triangle indices
+  unsigned vtx_size=num_vtx?unsigned(mgeo_.vbuf_size/num_vtx):0;
+  array<uint8_t> vbuf(mgeo_container_.vbuf.size());
+  array<vec3f> vertices(num_vtx);
+  const uint8_t *src_vbuf_data=mgeo_container_.vbuf.data();
+  const vec3f *src_vertices=mgeo_container_.vertices.data();
+  uint8_t *vbuf_data=vbuf.data();
+  vec3f *vertices_data=vertices.data();
+  for(uint32_t vidx=0; vidx<num_vtx; ++vidx)
+  {
+    uint32_t new_vidx=remap_data[vidx];
+    mem_copy(vbuf_data+usize_t(new_vidx)*vtx_size, src_vbuf_data+usize_t(vidx)*vtx_size, vtx_size);
+    vertices_data[new_vidx]=src_vertices[vidx];
+  }
+  for(uint32_t &vidx:mgeo_container_.indices)
+    vidx=remap_data[vidx];
+  mgeo_container_.vbuf=vbuf;
+  mgeo_container_.vertices=vertices;
+
+  // update mesh geometry
+  mgeo_.vertices=mgeo_container_.vertices.data();
+  mgeo_.vbuf=mgeo_container_.vbuf.data();
+}
+//----------------------------------------------------------------------------
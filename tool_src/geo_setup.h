@@ -20,9 +20,100 @@ namespace pfc
 {
 
 // new
+struct vtx_element;
+struct vtx_format;
+struct vtx_format_config;
 struct mesh_geometry_setup_cfg;
 struct mesh_geometry_container;
+struct vtx_float16;
+bool load_vtx_format_config(vtx_format_config&, const char *vcfg_file_);
 bool setup_mesh_geometry(const mesh&, const mesh_geometry_setup_cfg&, mesh_geometry&, mesh_geometry_container&);
+void reorder_mesh_geometry_vertices(mesh_geometry&, mesh_geometry_container&, p3g_mesh_geometry&);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// e_vtx_element_type
+//============================================================================
+enum e_vtx_element_type
+{
+  vtxelemtype_none,
+  // integer formats
+  vtxelemtype_int8,
+  vtxelemtype_uint8,
+  vtxelemtype_int16,
+  vtxelemtype_uint16,
+  vtxelemtype_int32,
+  vtxelemtype_uint32,
+  // float formats
+  vtxelemtype_float16,
+  vtxelemtype_float32,
+};
+PFC_ENUM(e_vtx_element_type);
+//----
+
+#define PFC_ENUM_TYPE e_vtx_element_type
+#define PFC_ENUM_PREFIX vtxelemtype_
+#define PFC_ENUM_VALS PFC_ENUM_VAL(int8)\
+                      PFC_ENUM_VAL(uint8)\
+                      PFC_ENUM_VAL(int16)\
+                      PFC_ENUM_VAL(uint16)\
+                      PFC_ENUM_VAL(int32)\
+                      PFC_ENUM_VAL(uint32)\
+                      PFC_ENUM_VAL(float16)\
+                      PFC_ENUM_VAL(float32)
+#include "sxp_src/core/enum.inc"
+//----
+
+unsigned vtx_element_type_size(e_vtx_element_type);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vtx_float16
+//============================================================================
+struct vtx_float16
+{
+  PFC_INLINE vtx_float16(float32_t v_)  {data=fp32_to_s16f(clamp(v_, -65504.0f, 65504.0f));}
+  PFC_INLINE vtx_float16(int32_t v_)    {data=fp32_to_s16f(float32_t(clamp(v_, -65504, 65504)));}
+  uint16_t data;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vtx_element
+//============================================================================
+struct vtx_element
+{ PFC_MONO(vtx_element) {PFC_VAR2(type, expr);}
+  e_vtx_element_type type;
+  heap_str expr;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vtx_format
+//============================================================================
+struct vtx_format
+{ PFC_MONO(vtx_format) {PFC_VAR2(id, name);}
+  PFC_INLINE bool operator==(const char *name_) const  {return name==name_;}
+  //--------------------------------------------------------------------------
+
+  uint8_t id;
+  heap_str name;
+  array<vtx_element> elements;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vtx_format_config
+//============================================================================
+struct vtx_format_config
+{
+  array<vtx_format> formats;
+};
 //----------------------------------------------------------------------------
 
 
@@ -31,8 +122,10 @@ bool setup_mesh_geometry(const mesh&, const mesh_geometry_setup_cfg&, mesh_geome
 //============================================================================
 struct mesh_geometry_setup_cfg
 {
-  const char *vcfg_file;
+  const vtx_format_config *vcfg;
   const char *vfmt_name;
+  unsigned num_threads;
+  bool log_progress;
 };
 //----------------------------------------------------------------------------
 
@@ -45,7 +138,7 @@ struct mesh_geometry_container
   array<mesh_geometry_segment> segs;
   array<vec3f> vertices;
   array<uint32_t> indices;
-  owner_data vbuf;
+  array<uint8_t> vbuf;
 };
 //----------------------------------------------------------------------------
 
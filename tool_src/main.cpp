@@ -6,13 +6,17 @@
 //============================================================================
 
 #include "geo_setup.h"
+#include "batch.h"
+#include "mlet_stats.h"
+#include "parallel.h"
+#include "profile.h"
 #include "src/export.h"
 #include "src/mlet_gen.h"
 #include "sxp_src/core_engine/mesh.h"
 #include "sxp_src/core/fsys/fsys.h"
 #include "sxp_src/core/math/bit_math.h"
-#include "sxp_src/core/sort.h"
 #include "sxp_src/core/main.h"
+#include <chrono>
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -23,7 +27,8 @@ using namespace pfc;
 static const char *s_tool_name="Meshlete v0.1.7";
 static const char *s_tool_desc="Meshlet-based 3D object converter";
 static const char *s_copyright_message="Copyright (c) 2022, Jarkko Lempiainen. All rights reserved.";
-static const char *s_usage_message="Usage: meshlete [options] -i <input.obj> -o <output.p3g>   (-h for help)";
+static const char *s_usage_message="Usage: meshlete [options] -i <input.obj> -o <output.p3g>   (-h for help)\r\n"
+                                   "       meshlete [options] -b <manifest.txt|\"*.obj\"> [-bo <output_dir>]";
 static const char *s_conversion_fail_msg="Conversion failed!\r\n";
 static const char *s_conversion_success_msg="Done!\r\n";
 static const char *s_default_vcfg_filename="vfmt.xml";
@@ -66,6 +71,9 @@ enum e_p3g_output_type
   p3gouttype_bin,
   p3gouttype_hex,
   p3gouttype_hexd,
+  p3gouttype_carray,
+  p3gouttype_embed,
+  p3gouttype_incbin,
 };
 //----------------------------------------------------------------------------
 
@@ -84,12 +92,19 @@ struct command_arguments
     p3g_output_type=p3gouttype_bin;
     num_vcone_views=1024;
     vcone_render_res=1024;
+    num_threads=0;
     mlet_bvols=false;
     mlet_vcones=false;
     mlet_stripify=false;
+    mlet_packed_tidx=false;
+    vtx_reorder=false;
+    vtx_local=false;
+    vtx_packed=false;
     debug_bvols=false;
     debug_vcones=false;
+    debug_merge=false;
     suppress_copyright=false;
+    quiet=false;
   }
   //----
 
@@ -99,23 +114,53 @@ struct command_arguments
   heap_str friendly_output_file;
   heap_str debug_output_file;
   heap_str friendly_debug_output_file;
+  heap_str batch_src;
+  heap_str batch_output_dir;
   heap_str vcfg_filename;
   heap_str vfmt_name;
+  heap_str symbol_name;
+  heap_str profile_file;
+  heap_str stats_file;
   uint32_t vbuf_align;
   uint8_t mlet_max_vtx;
   uint8_t mlet_max_tris;
   e_p3g_output_type p3g_output_type;
   uint32_t num_vcone_views;
   uint32_t vcone_render_res;
+  unsigned num_threads;
   bool mlet_bvols;
   bool mlet_vcones;
   bool mlet_stripify;
+  bool mlet_packed_tidx;
+  bool vtx_reorder;
+  bool vtx_local;
+  bool vtx_packed;
   bool debug_bvols;
   bool debug_vcones;
+  bool debug_merge;
   bool suppress_copyright;
+  bool quiet;  // suppress conversion stage logs (batch jobs)
 };
 //----
 
+void set_input_file(command_arguments &ca_, const char *input_file_)
+{
+  ca_.input_file=input_file_;
+  str_strip_quotes(ca_.input_file);
+  ca_.friendly_input_file=get_filename(ca_.input_file.c_str());
+  str_lower(ca_.friendly_input_file.c_str());
+}
+//----
+
+void set_output_file(command_arguments &ca_, const char *output_file_)
+{
+  ca_.output_file=output_file_;
+  str_strip_quotes(ca_.output_file);
+  ca_.friendly_output_file=get_filename(ca_.output_file.c_str());
+  str_lower(ca_.friendly_output_file.c_str());
+}
+//----
+
 bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigned num_args_)
 {
   // parse arguments
@@ -146,10 +191,22 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
                  "  -o <file>    Output file (p3g format)\r\n"
                  "  -hex         Output data as comma separated byte ASCII hex codes\r\n"
                  "  -hexd        Output data as comma separated dword ASCII hex codes\r\n"
+                 "  -ca          Output data as a C/C++ header with an alignas(4) byte array\r\n"
+                 "  -embed       Output a C/C++ header #embed:ing the binary written next to it (.p3g)\r\n"
+                 "  -incbin      Output an assembler file .incbin:ing the binary written next to it (.p3g)\r\n"
+                 "  -sym <name>  Array/symbol name for -ca/-embed/-incbin (default: output file name)\r\n"
+                 "\r\n"
+                 "  -b <src>     Batch convert files listed in a manifest file (\"<input> [<output>]\"\r\n"
+                 "               per line) or matching a quoted wildcard pattern (e.g. \"meshes/*.obj\")\r\n"
+                 "  -bo <dir>    Batch output directory (default: next to the input files)\r\n"
+                 "  -j <num>     Number of worker threads (default: number of CPU threads)\r\n"
                  "\r\n"
                  "  -vf <vfmt>   Output vertex format (default: \"pnu\")\r\n"
                  "  -vc <file>   Vertex format config file (default: \"%s\")\r\n"
                  "  -va <align>  Vertex data file alignment (default: 4)\r\n"
+                 "  -vr          Reorder vertices to meshlet first-reference order\r\n"
+                 "  -vl          Meshlet-local vertex blocks (duplicates shared vertices, no vertex indices)\r\n"
+                 "  -vp          Bitpack meshlet vertex indices (per-meshlet base index + delta bits, not with -vl)\r\n"
                  "\r\n"
                  "  -mv <num>    Max meshlet vertices (8-255, default: 64)\r\n"
                  "  -mt <num>    Max meshlet triangles (8-255, default: 128)\r\n"
@@ -157,11 +214,16 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
                  "  -mc          Export meshlet visibility cones (forces -mb)\r\n"
                  "  -mcv <num>   Number of visibility cone views (default: 1024)\r\n"
                  "  -mcr <res>   Visibility cone render resolution (default: 1024)\r\n"
+                 "  -mp          Bitpack meshlet triangle indices (minimal width for meshlet vertex count)\r\n"
 //                 "  -ms          Stripify meshlets\r\n"
                  "\r\n"
-                 "  -do <file>   Debug output file (Collada .dae format)\r\n"
+                 "  -do <file>   Debug output file (Collada .dae or binary glTF .glb format)\r\n"
                  "  -db          Debug bounding spheres\r\n"
                  "  -dc          Debug visibility cones\r\n"
+                 "  -dm          Merge debug spheres/cones to single meshes (Collada only, glTF uses GPU instancing)\r\n"
+                 "\r\n"
+                 "  -prof <file> Write per-stage timing and peak memory report (JSON)\r\n"
+                 "  -stats <file> Write meshlet quality statistics report (JSON)\r\n"
                  "\r\n"
                  "  -h           Print this screen\n"
                  "  -c           Suppress copyright message\r\n", 
@@ -180,11 +242,40 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
         case 'i':
         {
           if(arg_size==2 && arg_idx<num_args_-1)
+            set_input_file(ca_, args_[++arg_idx]);
+          else if(str_eq(carg, "-incbin"))
+            ca_.p3g_output_type=p3gouttype_incbin;
+        } break;
+
+        // embedded output
+        case 'e':
+        {
+          if(str_eq(carg, "-embed"))
+            ca_.p3g_output_type=p3gouttype_embed;
+        } break;
+
+        // profiling report
+        case 'p':
+        {
+          if(str_eq(carg, "-prof") && arg_idx<num_args_-1)
+          {
+            ca_.profile_file=args_[++arg_idx];
+            str_strip_quotes(ca_.profile_file);
+          }
+        } break;
+
+        // output symbol name and stats report
+        case 's':
+        {
+          if(str_eq(carg, "-sym") && arg_idx<num_args_-1)
+          {
+            ca_.symbol_name=args_[++arg_idx];
+            str_strip_quotes(ca_.symbol_name);
+          }
+          else if(str_eq(carg, "-stats") && arg_idx<num_args_-1)
           {
-            ca_.input_file=args_[++arg_idx];
-            str_strip_quotes(ca_.input_file);
-            ca_.friendly_input_file=get_filename(ca_.input_file.c_str());
-            str_lower(ca_.friendly_input_file.c_str());
+            ca_.stats_file=args_[++arg_idx];
+            str_strip_quotes(ca_.stats_file);
           }
         } break;
 
@@ -192,11 +283,41 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
         case 'o':
         {
           if(arg_size==2 && arg_idx<num_args_-1)
+            set_output_file(ca_, args_[++arg_idx]);
+        } break;
+
+        // batch conversion
+        case 'b':
+        {
+          if(arg_size==2 && arg_idx<num_args_-1)
+          {
+            ca_.batch_src=args_[++arg_idx];
+            str_strip_quotes(ca_.batch_src);
+          }
+          else if(str_eq(carg, "-bo") && arg_idx<num_args_-1)
           {
-            ca_.output_file=args_[++arg_idx];
-            str_strip_quotes(ca_.output_file);
-            ca_.friendly_output_file=get_filename(ca_.output_file.c_str());
-            str_lower(ca_.friendly_output_file.c_str());
+            ca_.batch_output_dir=args_[++arg_idx];
+            str_strip_quotes(ca_.batch_output_dir);
+          }
+        } break;
+
+        // number of worker threads
+        case 'j':
+        {
+          if(arg_size==2 && arg_idx<num_args_-1)
+          {
+            int num_threads=0;
+            if(!str_to_int(num_threads, args_[++arg_idx]))
+            {
+              error_msg+="> Error: Invalid worker thread count parameter\r\n";
+              break;
+            }
+            if(num_threads<1 || num_threads>256)
+            {
+              error_msg.push_back_format("> Error: Number of worker threads (-j %i) must be 1-256\r\n", num_threads);
+              break;
+            }
+            ca_.num_threads=num_threads;
           }
         } break;
 
@@ -229,6 +350,12 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
             }
             ca_.vbuf_align=valign;
           }
+          else if(str_eq(carg, "-vr"))
+            ca_.vtx_reorder=true;
+          else if(str_eq(carg, "-vl"))
+            ca_.vtx_local=true;
+          else if(str_eq(carg, "-vp"))
+            ca_.vtx_packed=true;
         } break;
 
         // meshlet data generation
@@ -307,6 +434,8 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
           }
           else if(str_eq(carg, "-ms"))
             ca_.mlet_stripify=true;
+          else if(str_eq(carg, "-mp"))
+            ca_.mlet_packed_tidx=true;
         } break;
 
         // debug
@@ -323,6 +452,8 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
             ca_.debug_bvols=true;
           if(str_eq(carg, "-dc"))
             ca_.debug_vcones=true;
+          if(str_eq(carg, "-dm"))
+            ca_.debug_merge=true;
         } break;
 
         // suppress copyright text
@@ -330,10 +461,14 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
         {
           if(arg_size==2)
             ca_.suppress_copyright=true;
+          else if(str_eq(carg, "-ca"))
+            ca_.p3g_output_type=p3gouttype_carray;
         } break;
       }
     }
   }
+  if(ca_.vtx_local && ca_.vtx_packed)
+    error_msg.push_back_format("> Error: Meshlet-local vertex blocks (-vl) have no vertex indices to bitpack (-vp)\r\n");
 
   // check for help string and copyright message output
   if(!ca_.suppress_copyright)
@@ -342,7 +477,7 @@ bool parse_command_arguments(command_arguments &ca_, const char **args_, unsigne
     log("");
     logf("%s\r\n\r\n", s_copyright_message);
   }
-  if(!ca_.input_file.size() || (!ca_.output_file.size() && !ca_.debug_output_file.size()))
+  if(!ca_.batch_src.size() && (!ca_.input_file.size() || (!ca_.output_file.size() && !ca_.debug_output_file.size())))
   {
     log(s_usage_message);
     log("\r\n");
@@ -381,8 +516,7 @@ void log_meshlet_stats(const sphere3f &mesh_bvol_, const p3g_mesh_geometry &p3g_
       mlet_bvol_rads[mlet_idx++]=rad;
     }
   }
-  quick_sort(mlet_bvol_rads.data(), mlet_bvol_rads.size());
-  float med_bvol_rad=mlet_bvol_rads[mlet_idx/2];
+  float med_bvol_rad=num_mlets?select_quantile(mlet_bvol_rads, 0.5f):0.0f;
 
   // setup average bounding volume unit
   stack_str8 bvol_unit="m";
@@ -412,28 +546,132 @@ void log_meshlet_stats(const sphere3f &mesh_bvol_, const p3g_mesh_geometry &p3g_
 
 
 //============================================================================
-// main
+// make_symbol_name
 //============================================================================
-PFC_MAIN(const char *args_[], unsigned num_args_)
+void make_symbol_name(heap_str &res_, const char *file_)
 {
-  // parse command line arguments
-  command_arguments ca;
-  if(!parse_command_arguments(ca, args_, num_args_))
-    return -1;
-  owner_ref<file_system_base> fsys=create_default_file_system(true);
+  // use the file name without extension with non-alphanumeric chars replaced by '_'
+  res_=get_filename(file_);
+  usize_t stem_size=res_.size();
+  for(usize_t i=0; i<res_.size(); ++i)
+    if(res_.c_str()[i]=='.')
+      stem_size=i;
+  res_.resize(stem_size);
+  char *c=res_.c_str();
+  for(usize_t i=0; i<stem_size; ++i)
+    if(!((c[i]>='a' && c[i]<='z') || (c[i]>='A' && c[i]<='Z') || (c[i]>='0' && c[i]<='9')))
+      c[i]='_';
+  if(!stem_size || (c[0]>='0' && c[0]<='9'))
+  {
+    heap_str s="p3g_";
+    s+=res_.c_str();
+    res_=s;
+  }
+}
+//----------------------------------------------------------------------------
 
+
+//============================================================================
+// make_include_guard
+//============================================================================
+void make_include_guard(heap_str &res_, const char *sym_name_)
+{
+  // use the upper-case symbol name with non-alphanumeric chars replaced by '_'
+  res_=sym_name_;
+  res_+="_P3G_H";
+  char *c=res_.c_str();
+  for(usize_t i=0; i<res_.size(); ++i)
+    if(c[i]>='a' && c[i]<='z')
+      c[i]-='a'-'A';
+    else if(!((c[i]>='A' && c[i]<='Z') || (c[i]>='0' && c[i]<='9')))
+      c[i]='_';
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// write_hex_text
+//============================================================================
+void write_hex_text(bin_output_stream_base &fout_, const uint8_t *data_, usize_t size_, bool dwords_, usize_t items_per_line_, const char *indent_)
+{
+  // setup byte to hex digit pair lookup table
+  static const struct hex_byte_table
+  {
+    hex_byte_table()
+    {
+      static const char s_digits[]="0123456789abcdef";
+      for(unsigned i=0; i<256; ++i)
+      {
+        chars[i*2+0]=s_digits[i>>4];
+        chars[i*2+1]=s_digits[i&15];
+      }
+    }
+    char chars[512];
+  } s_hex_table;
+
+  // calculate the text size and encode the data ("0x??, " or "0x????????, " per item)
+  PFC_ASSERT(!dwords_ || !(size_&3));
+  const usize_t item_bytes=dwords_?4:1;
+  const usize_t item_chars=4+item_bytes*2;
+  const usize_t indent_size=str_size(indent_);
+  const usize_t num_items=size_/item_bytes;
+  const usize_t num_lines=(num_items+items_per_line_-1)/items_per_line_;
+  const usize_t text_size=num_items*item_chars+num_lines*(indent_size+2);
+  array<char> text;
+  text.resize(text_size);
+  char *p=text.data();
+  usize_t items_left=num_items;
+  while(items_left)
+  {
+    usize_t num_line_items=min<usize_t>(items_left, items_per_line_);
+    mem_copy(p, indent_, indent_size);
+    p+=indent_size;
+    for(usize_t i=0; i<num_line_items; ++i)
+    {
+      // write bytes of little-endian dwords in the most significant first order
+      *p++='0';
+      *p++='x';
+      for(usize_t b=item_bytes; b--;)
+      {
+        const char *hex=s_hex_table.chars+data_[b]*2;
+        *p++=hex[0];
+        *p++=hex[1];
+      }
+      *p++=',';
+      *p++=' ';
+      data_+=item_bytes;
+    }
+    *p++='\r';
+    *p++='\n';
+    items_left-=num_line_items;
+  }
+  PFC_ASSERT(p==text.data()+text_size);
+  fout_.write_bytes(text.data(), text_size);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// convert_mesh_file
+//============================================================================
+bool convert_mesh_file(const command_arguments &ca_, const vtx_format_config &vcfg_)
+{
   // try open the mesh input file
-  owner_ptr<bin_input_stream_base> fin=fsys->open_read(ca.input_file.c_str(), 0, fopencheck_none);
+  owner_ref<file_system_base> fsys=create_default_file_system(true);
+  owner_ptr<bin_input_stream_base> fin=fsys->open_read(ca_.input_file.c_str(), 0, fopencheck_none);
   if(!fin.data)
   {
-    errorf("> Error: Unable to read file \"%s\"\r\n", ca.input_file.c_str());
-    errorf(s_conversion_fail_msg);
-    return -1;
+    errorf("> Error: Unable to read file \"%s\"\r\n", ca_.input_file.c_str());
+    return false;
   }
 
   // load mesh and access mesh data
-  logf("> Loading 3D mesh \"%s\"...\r\n", ca.friendly_input_file.c_str());
+  profiler prof(ca_.profile_file.size()!=0);
+  prof.begin_stage("load_mesh");
+  if(!ca_.quiet)
+    logf("> Loading 3D mesh \"%s\"...\r\n", ca_.friendly_input_file.c_str());
   mesh msh(*fin);
+  if(!ca_.quiet)
   {
     unsigned num_mesh_vertices=(unsigned)msh.vertex_buffer(0).num_vertices();
     usize_t num_mesh_segs=msh.num_segments();
@@ -442,105 +680,172 @@ PFC_MAIN(const char *args_[], unsigned num_args_)
       num_mesh_triangles+=msh.segment(i).num_primitives;
     logf(">   %i %s, %i %s, %i %s\r\n", num_mesh_segs, num_mesh_segs==1?"segment":"segments", num_mesh_vertices, num_mesh_vertices==1?"vertex":"vertices", num_mesh_triangles, num_mesh_triangles==1?"triangle":"triangles");
   }
+  prof.end_stage();
 
   // setup mesh geometry
   mesh_geometry_setup_cfg setup_cfg;
-  heap_str vcfg_filename;
-  if(ca.vcfg_filename.size())
-    vcfg_filename=ca.vcfg_filename;
-  else
-  {
-    vcfg_filename=executable_dir();
-    vcfg_filename+="/";
-    vcfg_filename+=s_default_vcfg_filename;
-  }
-  setup_cfg.vcfg_file=vcfg_filename.c_str();
-  setup_cfg.vfmt_name=ca.vfmt_name.c_str();
+  setup_cfg.vcfg=&vcfg_;
+  setup_cfg.vfmt_name=ca_.vfmt_name.c_str();
+  setup_cfg.num_threads=ca_.num_threads?ca_.num_threads:default_num_worker_threads();
+  setup_cfg.log_progress=!ca_.quiet;
   mesh_geometry mgeo;
   mesh_geometry_container mgeo_container;
+  prof.begin_stage("setup_mesh_geometry");
   if(!setup_mesh_geometry(msh, setup_cfg, mgeo, mgeo_container))
-    return -1;
+    return false;
+  prof.end_stage();
 
   // generate meshlets for the mesh
-  logf("> Generating meshlets (max %i verts, %i tris)...\r\n", ca.mlet_max_vtx, ca.mlet_max_tris);
+  if(!ca_.quiet)
+    logf("> Generating meshlets (max %i verts, %i tris)...\r\n", ca_.mlet_max_vtx, ca_.mlet_max_tris);
   p3g_mesh_geometry p3g_geo;
   meshlet_gen_cfg mgen_cfg;
-  mgen_cfg.max_mlet_vtx=ca.mlet_max_vtx;
-  mgen_cfg.max_mlet_tris=ca.mlet_max_tris;
-  mgen_cfg.mlet_stripify=ca.mlet_stripify;
-  generate_meshlets(mgen_cfg, mgeo, p3g_geo);
+  mgen_cfg.max_mlet_vtx=ca_.mlet_max_vtx;
+  mgen_cfg.max_mlet_tris=ca_.mlet_max_tris;
+  mgen_cfg.mlet_stripify=ca_.mlet_stripify;
+  prof.begin_stage("generate_meshlets");
+  generate_meshlets(mgen_cfg, mgeo, p3g_geo, prof.stage_segment_times());
+  prof.end_stage();
 
   // generate bounding volumes and visibility cones
-  logf("> Generating meshlet bounding volumes...\r\n");
-  generate_bvols(mgeo, p3g_geo);
-  log_meshlet_stats(mgeo.bvol, p3g_geo);
-  if(ca.mlet_vcones || ca.debug_vcones)
-    generate_vcones(mgeo, p3g_geo, ca.num_vcone_views, uint16_t(ca.vcone_render_res));
+  if(!ca_.quiet)
+    logf("> Generating meshlet bounding volumes...\r\n");
+  prof.begin_stage("generate_bvols");
+  generate_bvols(mgeo, p3g_geo, prof.stage_segment_times());
+  prof.end_stage();
+  if(!ca_.quiet)
+    log_meshlet_stats(mgeo.bvol, p3g_geo);
+  if(ca_.mlet_vcones || ca_.debug_vcones)
+  {
+    prof.begin_stage("generate_vcones");
+    generate_vcones(mgeo, p3g_geo, ca_.num_vcone_views, uint16_t(ca_.vcone_render_res), !ca_.quiet);
+    prof.end_stage();
+  }
 
-  if(ca.debug_output_file.size())
+  // reorder vertices for meshlet vertex fetch locality
+  if(ca_.vtx_reorder)
   {
-    // export debug Collada mesh
-    owner_ptr<bin_output_stream_base> fout=fsys->open_write(ca.debug_output_file.c_str());
+    if(!ca_.quiet)
+      logf("> Reordering vertices for meshlets...\r\n");
+    prof.begin_stage("reorder_vertices");
+    reorder_mesh_geometry_vertices(mgeo, mgeo_container, p3g_geo);
+    prof.end_stage();
+  }
+
+  if(ca_.debug_output_file.size())
+  {
+    // export debug Collada or binary glTF mesh
+    owner_ptr<bin_output_stream_base> fout=fsys->open_write(ca_.debug_output_file.c_str());
     if(!fout.data)
     {
-      errorf("> Error: Unable to write debug file \"%s\"\r\n", ca.debug_output_file.c_str());
-      errorf(s_conversion_fail_msg);
-      return -1;
+      errorf("> Error: Unable to write debug file \"%s\"\r\n", ca_.debug_output_file.c_str());
+      return false;
     }
     else
     {
-      logf("> Exporting Collada file \"%s\"...\r\n", ca.friendly_debug_output_file.c_str());
+      usize_t fname_size=ca_.friendly_debug_output_file.size();
+      bool is_glb=fname_size>=4 && str_eq(ca_.friendly_debug_output_file.c_str()+fname_size-4, ".glb");
+      if(!ca_.quiet)
+        logf("> Exporting %s file \"%s\"...\r\n", is_glb?"glTF":"Collada", ca_.friendly_debug_output_file.c_str());
       export_cfg_dae cfg;
-      cfg.export_meshlet_bvols=ca.debug_bvols;
-      cfg.export_meshlet_vcones=ca.debug_vcones;
-      if(!export_dae(*fout.data, cfg, mgeo, p3g_geo))
-      {
-        errorf(s_conversion_fail_msg);
-        return -1;
-      }
+      cfg.export_meshlet_bvols=ca_.debug_bvols;
+      cfg.export_meshlet_vcones=ca_.debug_vcones;
+      cfg.merge_instances=ca_.debug_merge;
+      prof.begin_stage("export_debug");
+      if(!(is_glb?export_glb(*fout.data, cfg, mgeo, p3g_geo):export_dae(*fout.data, cfg, mgeo, p3g_geo)))
+        return false;
+      prof.end_stage();
     }
   }
 
-  if(ca.output_file.size())
+  // setup p3g export config
+  export_cfg_p3g p3g_cfg;
+  p3g_cfg.export_meshlet_bvols=ca_.mlet_bvols;
+  p3g_cfg.export_meshlet_vcones=ca_.mlet_vcones;
+  p3g_cfg.local_vbuf=ca_.vtx_local;
+  p3g_cfg.packed_vidx=ca_.vtx_packed;
+  p3g_cfg.packed_tidx=ca_.mlet_packed_tidx;
+  p3g_cfg.vbuf_align=ca_.vbuf_align;
+  p3g_cfg.log_stats=!ca_.quiet;
+  array<uint8_t> p3g_data;
+  usize_t p3g_data_size=0;
+
+  if(ca_.output_file.size())
   {
     // export p3g file
-    owner_ptr<bin_output_stream_base> fout=fsys->open_write(ca.output_file.c_str());
+    owner_ptr<bin_output_stream_base> fout=fsys->open_write(ca_.output_file.c_str());
     if(!fout.data)
     {
-      errorf("> Error: Unable to write p3g file \"%s\"\r\n", ca.output_file.c_str());
-      errorf(s_conversion_fail_msg);
-      return -1;
+      errorf("> Error: Unable to write p3g file \"%s\"\r\n", ca_.output_file.c_str());
+      return false;
     }
-    logf("> Exporting P3G file \"%s\"...\r\n", ca.friendly_output_file.c_str());
-    export_cfg_p3g cfg;
-    cfg.export_meshlet_bvols=ca.mlet_bvols;
-    cfg.export_meshlet_vcones=ca.mlet_vcones;
-    cfg.vbuf_align=ca.vbuf_align;
-    switch(ca.p3g_output_type)
+    if(!ca_.quiet)
+      logf("> Exporting P3G file \"%s\"...\r\n", ca_.friendly_output_file.c_str());
+    prof.begin_stage("export_p3g");
+    switch(ca_.p3g_output_type)
     {
       // export binary file
       case p3gouttype_bin:
       {
-        if(!export_p3g(*fout, cfg, mgeo, p3g_geo))
+        if(!ca_.stats_file.size())
         {
-          errorf(s_conversion_fail_msg);
-          return -1;
+          if(!export_p3g(*fout, p3g_cfg, mgeo, p3g_geo))
+            return false;
+          break;
         }
+
+        // export via container to keep the data for the stats report
+        {
+          container_output_stream<array<uint8_t> > cout(p3g_data);
+          if(!export_p3g(cout, p3g_cfg, mgeo, p3g_geo))
+            return false;
+        }
+        p3g_data_size=p3g_data.size();
+        fout.data->write_bytes(p3g_data.data(), p3g_data_size);
       } break;
 
-      // export hex ASCII file
+      // export text file
       case p3gouttype_hex:
       case p3gouttype_hexd:
+      case p3gouttype_carray:
+      case p3gouttype_embed:
+      case p3gouttype_incbin:
       {
         // export data to container
-        array<uint8_t> p3g_data;
         {
           container_output_stream<array<uint8_t> > cout(p3g_data);
-          if(!export_p3g(cout, cfg, mgeo, p3g_geo))
+          if(!export_p3g(cout, p3g_cfg, mgeo, p3g_geo))
+            return false;
+        }
+        p3g_data_size=p3g_data.size();
+
+        // write the binary next to the output file for #embed/.incbin
+        heap_str bin_file;
+        const bool is_asm=ca_.p3g_output_type==p3gouttype_incbin;
+        if(ca_.p3g_output_type==p3gouttype_embed || is_asm)
+        {
+          const char *output_file=ca_.output_file.c_str();
+          usize_t stem_size=str_size(output_file);
+          for(usize_t i=0; output_file[i]; ++i)
+            if(output_file[i]=='.')
+              stem_size=i;
+            else if(output_file[i]=='/' || output_file[i]=='\\')
+              stem_size=str_size(output_file);
+          bin_file=output_file;
+          bin_file.resize(stem_size);
+          bin_file+=".p3g";
+          if(str_eq(bin_file.c_str(), output_file))
+          {
+            errorf("> Error: Output file \"%s\" conflicts with the embedded binary file name\r\n", ca_.friendly_output_file.c_str());
+            return false;
+          }
+          owner_ptr<bin_output_stream_base> fbin=fsys->open_write(bin_file.c_str());
+          if(!fbin.data)
           {
-            errorf(s_conversion_fail_msg);
-            return -1;
+            errorf("> Error: Unable to write p3g file \"%s\"\r\n", bin_file.c_str());
+            return false;
           }
+          fbin.data->write_bytes(p3g_data.data(), p3g_data.size());
         }
 
         // output stats
@@ -558,58 +863,234 @@ PFC_MAIN(const char *args_[], unsigned num_args_)
         float avg_mlet_tris=float(total_mlet_tris)/num_mlets;
         avg_vtx_str.format("%.1f", avg_mlet_vtx);
         avg_tris_str.format("%.1f", avg_mlet_tris);
-        text_output_stream(*fout)<<"//  Mesh file: "<<ca.friendly_input_file.c_str()<<"\r\n"
-                                 <<"//   Segments: "<<mgeo.num_segs<<"\r\n"
-                                 <<"//   Meshlets: "<<p3g_geo.mlets.size()<<" (avg. "<<avg_vtx_str.c_str()<<" vtx, "<<avg_tris_str.c_str()<<" tris)\r\n"
-                                 <<"//  Triangles: "<<mgeo.num_indices/3<<"\r\n"
-                                 <<"//   Vertices: "<<mgeo.num_vertices<<"\r\n"
-                                 <<"// Vertex fmt: "<<ca.vfmt_name.c_str()<<" (id="<<mgeo.vfmt_id<<", size="<<mgeo.vbuf_size/mgeo.num_vertices<<")\r\n"
-                                 <<"//    Options: BVols: "<<(ca.mlet_bvols?"yes":"no")<<", VCones: "<<(ca.mlet_vcones?"yes":"no")<<"\r\n"
-                                 <<"//       Size: "<<p3g_data.size()<<" bytes\r\n"
-                                 <<"//   Exporter: "<<s_tool_name<<" (P3G v"<<bcd16_version_str(p3g_file_version).c_str()<<")\r\n";
-
-        // export the ASCII file
-        if(ca.p3g_output_type==p3gouttype_hexd)
+        uint16_t version=uint16_t(p3g_data[4]|(p3g_data[5]<<8));
+        const char *cmt=is_asm?"#":"//";
+        text_output_stream(*fout)<<cmt<<"  Mesh file: "<<ca_.friendly_input_file.c_str()<<"\r\n"
+                                 <<cmt<<"   Segments: "<<mgeo.num_segs<<"\r\n"
+                                 <<cmt<<"   Meshlets: "<<p3g_geo.mlets.size()<<" (avg. "<<avg_vtx_str.c_str()<<" vtx, "<<avg_tris_str.c_str()<<" tris)\r\n"
+                                 <<cmt<<"  Triangles: "<<mgeo.num_indices/3<<"\r\n"
+                                 <<cmt<<"   Vertices: "<<mgeo.num_vertices<<"\r\n"
+                                 <<cmt<<" Vertex fmt: "<<ca_.vfmt_name.c_str()<<" (id="<<mgeo.vfmt_id<<", size="<<mgeo.vbuf_size/mgeo.num_vertices<<")\r\n"
+                                 <<cmt<<"    Options: BVols: "<<(ca_.mlet_bvols?"yes":"no")<<", VCones: "<<(ca_.mlet_vcones?"yes":"no")<<"\r\n"
+                                 <<cmt<<"       Size: "<<p3g_data.size()<<" bytes\r\n"
+                                 <<cmt<<"   Exporter: "<<s_tool_name<<" (P3G v"<<bcd16_version_str(version).c_str()<<")\r\n";
+
+        // setup array/symbol name and the binary file name relative to the output file
+        heap_str bin_filename=get_filename(bin_file.c_str());
+        heap_str sym_name=ca_.symbol_name;
+        if(!sym_name.size())
+          make_symbol_name(sym_name, ca_.output_file.c_str());
+
+        // start C/C++ headers with an include guard and alignas support for C
+        heap_str include_guard;
+        if(ca_.p3g_output_type==p3gouttype_carray || ca_.p3g_output_type==p3gouttype_embed)
         {
-          // write data as dword hex codes
-          stack_str32 strbuf;
-          p3g_data.insert_back((0-p3g_data.size())&3, uint8_t(0));
-          usize_t dwords_left=p3g_data.size()/4;
-          const uint32_t *dwords=(const uint32_t*)p3g_data.data();
-          while(dwords_left)
-          {
-            usize_t num_dwords=min<usize_t>(dwords_left, 128);
-            for(unsigned i=0; i<num_dwords; ++i)
-            {
-              strbuf.format("0x%08x, ", dwords[i]);
-              *fout.data<<strbuf.c_str();
-            }
-            *fout.data<<"\r\n";
-            dwords+=num_dwords;
-            dwords_left-=num_dwords;
-          }
+          make_include_guard(include_guard, sym_name.c_str());
+          text_output_stream(*fout)<<"\r\n"
+                                   <<"#ifndef "<<include_guard.c_str()<<"\r\n"
+                                   <<"#define "<<include_guard.c_str()<<"\r\n"
+                                   <<"#include <stdint.h>\r\n"
+                                   <<"#ifndef __cplusplus\r\n"
+                                   <<"#include <stdalign.h>\r\n"
+                                   <<"#endif\r\n";
         }
-        else
+
+        // export the text file
+        switch(ca_.p3g_output_type)
         {
-          // write data as byte hex codes
-          stack_str32 strbuf;
-          usize_t data_left=p3g_data.size();
-          const uint8_t *bytes=p3g_data.data();
-          while(data_left)
+          // byte/dword hex codes
+          case p3gouttype_hex: write_hex_text(*fout, p3g_data.data(), p3g_data.size(), false, 256, ""); break;
+          case p3gouttype_hexd:
           {
-            usize_t num_bytes=min<usize_t>(data_left, 256);
-            for(unsigned i=0; i<num_bytes; ++i)
-            {
-              strbuf.format("0x%02x, ", bytes[i]);
-              *fout.data<<strbuf.c_str();
-            }
-            *fout.data<<"\r\n";
-            bytes+=num_bytes;
-            data_left-=num_bytes;
-          }
+            p3g_data.insert_back((0-p3g_data.size())&3, uint8_t(0));
+            write_hex_text(*fout, p3g_data.data(), p3g_data.size(), true, 128, "");
+          } break;
+
+          // C/C++ header with the data as a byte array
+          case p3gouttype_carray:
+          {
+            text_output_stream(*fout)<<"alignas(4) const uint8_t "<<sym_name.c_str()<<"[]=\r\n"
+                                     <<"{\r\n";
+            write_hex_text(*fout, p3g_data.data(), p3g_data.size(), false, 32, "  ");
+            text_output_stream(*fout)<<"};\r\n"
+                                     <<"#endif\r\n";
+          } break;
+
+          // C/C++ header #embed:ing the binary
+          case p3gouttype_embed:
+          {
+            text_output_stream(*fout)<<"alignas(4) const uint8_t "<<sym_name.c_str()<<"[]=\r\n"
+                                     <<"{\r\n"
+                                     <<"#embed \""<<bin_filename.c_str()<<"\"\r\n"
+                                     <<"};\r\n"
+                                     <<"#endif\r\n";
+          } break;
+
+          // GNU assembler file .incbin:ing the binary with <sym> and <sym>_end labels
+          case p3gouttype_incbin:
+          {
+            text_output_stream(*fout)<<"\r\n"
+                                     <<"  .section .rodata\r\n"
+                                     <<"  .global "<<sym_name.c_str()<<"\r\n"
+                                     <<"  .global "<<sym_name.c_str()<<"_end\r\n"
+                                     <<"  .balign 4\r\n"
+                                     <<sym_name.c_str()<<":\r\n"
+                                     <<"  .incbin \""<<bin_filename.c_str()<<"\"\r\n"
+                                     <<sym_name.c_str()<<"_end:\r\n";
+          } break;
+
+          default: PFC_ASSERT(false);
         }
       } break;
     }
+    prof.end_stage();
+  }
+
+  // write meshlet stats report
+  if(ca_.stats_file.size())
+  {
+    if(!ca_.output_file.size())
+    {
+      // export p3g data only for the section size stats
+      container_output_stream<array<uint8_t> > cout(p3g_data);
+      if(!export_p3g(cout, p3g_cfg, mgeo, p3g_geo))
+        return false;
+      p3g_data_size=p3g_data.size();
+    }
+    owner_ptr<bin_output_stream_base> fout=fsys->open_write(ca_.stats_file.c_str());
+    if(!fout.data)
+    {
+      errorf("> Error: Unable to write stats report \"%s\"\r\n", ca_.stats_file.c_str());
+      return false;
+    }
+    logf("> Writing meshlet stats report \"%s\"...\r\n", ca_.stats_file.c_str());
+    meshlet_stats_cfg stats_cfg;
+    stats_cfg.input_file=ca_.friendly_input_file.c_str();
+    stats_cfg.max_mlet_vtx=ca_.mlet_max_vtx;
+    stats_cfg.max_mlet_tris=ca_.mlet_max_tris;
+    stats_cfg.has_vcones=ca_.mlet_vcones || ca_.debug_vcones;
+    stats_cfg.num_cull_views=64;
+    if(!write_meshlet_stats_report(*fout.data, stats_cfg, mgeo, p3g_geo, p3g_data.data(), p3g_data_size))
+      return false;
+  }
+
+  // write profiling report
+  if(ca_.profile_file.size())
+  {
+    owner_ptr<bin_output_stream_base> fout=fsys->open_write(ca_.profile_file.c_str());
+    if(!fout.data)
+    {
+      errorf("> Error: Unable to write profile report \"%s\"\r\n", ca_.profile_file.c_str());
+      return false;
+    }
+    logf("> Writing profile report \"%s\"...\r\n", ca_.profile_file.c_str());
+    if(!prof.write_json_report(*fout.data, s_tool_name, ca_.friendly_input_file.c_str()))
+      return false;
+  }
+  return true;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// batch_convert_mesh_files
+//============================================================================
+bool batch_convert_mesh_files(const command_arguments &ca_, const vtx_format_config &vcfg_)
+{
+  // collect batch jobs
+  array<batch_job> jobs;
+  const char *output_ext=".p3g";
+  switch(ca_.p3g_output_type)
+  {
+    case p3gouttype_bin: break;
+    case p3gouttype_hex:
+    case p3gouttype_hexd: output_ext=".txt"; break;
+    case p3gouttype_carray:
+    case p3gouttype_embed: output_ext=".h"; break;
+    case p3gouttype_incbin: output_ext=".s"; break;
+  }
+  if(!collect_batch_jobs(jobs, ca_.batch_src.c_str(), ca_.batch_output_dir.c_str(), output_ext))
+    return false;
+  if(ca_.debug_output_file.size())
+    warnf("> Warning: Debug output (-do) is ignored in batch mode\r\n");
+  if(ca_.symbol_name.size())
+    warnf("> Warning: Symbol name (-sym) is ignored in batch mode\r\n");
+  if(ca_.profile_file.size())
+    warnf("> Warning: Profile report (-prof) is ignored in batch mode\r\n");
+  if(ca_.stats_file.size())
+    warnf("> Warning: Stats report (-stats) is ignored in batch mode\r\n");
+  unsigned num_threads=ca_.num_threads?ca_.num_threads:default_num_worker_threads();
+  uint32_t num_jobs=(uint32_t)jobs.size();
+  logf("> Batch converting %i %s with %i worker %s...\r\n", num_jobs, num_jobs==1?"file":"files", num_threads, num_threads==1?"thread":"threads");
+
+  // convert files in parallel sharing the vertex format config
+  std::atomic<uint32_t> num_jobs_done(0);
+  std::chrono::steady_clock::time_point batch_start=std::chrono::steady_clock::now();
+  parallel_for(num_jobs, num_threads, [&](uint32_t job_idx_, unsigned)
+  {
+    batch_job &job=jobs[job_idx_];
+    command_arguments job_ca=ca_;
+    set_input_file(job_ca, job.input_file.c_str());
+    set_output_file(job_ca, job.output_file.c_str());
+    job_ca.debug_output_file.resize(0);
+    job_ca.symbol_name.resize(0);
+    job_ca.profile_file.resize(0);
+    job_ca.stats_file.resize(0);
+    job_ca.num_threads=1;
+    job_ca.quiet=true;
+    std::chrono::steady_clock::time_point job_start=std::chrono::steady_clock::now();
+    job.success=convert_mesh_file(job_ca, vcfg_);
+    job.time=std::chrono::duration<double>(std::chrono::steady_clock::now()-job_start).count();
+    uint32_t job_num=++num_jobs_done;
+    if(job.success)
+      logf("> [%i/%i] Converted \"%s\" (%.2fs)\r\n", job_num, num_jobs, job_ca.friendly_input_file.c_str(), job.time);
+    else
+      errorf("> [%i/%i] Failed to convert \"%s\" (%.2fs)\r\n", job_num, num_jobs, job_ca.friendly_input_file.c_str(), job.time);
+  });
+  double wall_time=std::chrono::duration<double>(std::chrono::steady_clock::now()-batch_start).count();
+
+  // log summary
+  log_batch_summary(jobs, wall_time);
+  for(const batch_job &job:jobs)
+    if(!job.success)
+      return false;
+  return true;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// main
+//============================================================================
+PFC_MAIN(const char *args_[], unsigned num_args_)
+{
+  // parse command line arguments
+  command_arguments ca;
+  if(!parse_command_arguments(ca, args_, num_args_))
+    return -1;
+
+  // load vertex format config
+  heap_str vcfg_filename;
+  if(ca.vcfg_filename.size())
+    vcfg_filename=ca.vcfg_filename;
+  else
+  {
+    vcfg_filename=executable_dir();
+    vcfg_filename+="/";
+    vcfg_filename+=s_default_vcfg_filename;
+  }
+  vtx_format_config vcfg;
+  if(!load_vtx_format_config(vcfg, vcfg_filename.c_str()))
+  {
+    errorf(s_conversion_fail_msg);
+    return -1;
+  }
+
+  // convert a single file or a batch of files
+  if(!(ca.batch_src.size()?batch_convert_mesh_files(ca, vcfg):convert_mesh_file(ca, vcfg)))
+  {
+    errorf(s_conversion_fail_msg);
+    return -1;
   }
   log(s_conversion_success_msg);
   return 0;
@@ -0,0 +1,190 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "mlet_stats.h"
+#include "profile.h"
+#include "src/mlet_gen.h"
+#include "src/p3g_view.h"
+#include "sxp_src/core/math/monte_carlo.h"
+#include "sxp_src/core/streams.h"
+#include "sxp_src/core/str.h"
+#include <algorithm>
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  //==========================================================================
+  // push_back_value_stats
+  //==========================================================================
+  void push_back_value_stats(heap_str &json_, const char *name_, array<float> &vals_, float hist_min_, float hist_max_, unsigned num_hist_bins_)
+  {
+    // write mean, min/max and quantiles (reorders the values)
+    usize_t num_vals=vals_.size();
+    json_.push_back_format(",\r\n  \"%s\": {\"count\": %zi", name_, num_vals);
+    if(!num_vals)
+    {
+      json_+="}";
+      return;
+    }
+    double sum=0.0;
+    float vmin=vals_[0], vmax=vals_[0];
+    for(float v:vals_)
+    {
+      sum+=v;
+      vmin=min(vmin, v);
+      vmax=max(vmax, v);
+    }
+    json_.push_back_format(", \"mean\": %g, \"min\": %g, \"max\": %g", sum/num_vals, vmin, vmax);
+    json_.push_back_format(", \"p10\": %g", select_quantile(vals_, 0.1f));
+    json_.push_back_format(", \"p50\": %g", select_quantile(vals_, 0.5f));
+    json_.push_back_format(", \"p90\": %g", select_quantile(vals_, 0.9f));
+
+    // write histogram of the values in range [hist_min_, hist_max_]
+    array<uint32_t> hist(num_hist_bins_, uint32_t(0));
+    float bin_scale=hist_max_>hist_min_?float(num_hist_bins_)/(hist_max_-hist_min_):0.0f;
+    for(float v:vals_)
+    {
+      int bin=int((v-hist_min_)*bin_scale);
+      ++hist[min(unsigned(max(bin, 0)), num_hist_bins_-1)];
+    }
+    json_.push_back_format(", \"hist_min\": %g, \"hist_max\": %g, \"hist\": [", hist_min_, hist_max_);
+    for(unsigned i=0; i<num_hist_bins_; ++i)
+      json_.push_back_format("%s%i", i?", ":"", hist[i]);
+    json_+="]}";
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// select_quantile
+//============================================================================
+float pfc::select_quantile(array<float> &vals_, float q_)
+{
+  // linear-time selection of the q-quantile (partially reorders the values)
+  PFC_ASSERT(vals_.size());
+  usize_t k=min<usize_t>(usize_t(q_*vals_.size()), vals_.size()-1);
+  std::nth_element(vals_.data(), vals_.data()+k, vals_.data()+vals_.size());
+  return vals_[k];
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// write_meshlet_stats_report
+//============================================================================
+bool pfc::write_meshlet_stats_report(bin_output_stream_base &fout_, const meshlet_stats_cfg &cfg_, const mesh_geometry &mgeo_, const p3g_mesh_geometry &p3g_geo_, const void *p3g_data_, usize_t p3g_size_)
+{
+  // collect per-meshlet values
+  const array<p3g_meshlet> &mlets=p3g_geo_.mlets;
+  usize_t num_mlets=mlets.size();
+  array<float> vtx_fill, tri_fill, bvol_rads, vcone_angles;
+  array<vec3f> vcone_dirs;
+  array<float> vcone_dots;
+  uint32_t total_mlet_vtx=0, num_unbounded_vcones=0;
+  float max_bvol_rad=0.0f;
+  for(const p3g_mesh_segment &seg:p3g_geo_.segs)
+  {
+    sphere3f seg_bvol=dequantize_segment_bvol(seg.qbvol_pos, seg.qbvol_rad, mgeo_.bvol);
+    for(uint32_t midx=0; midx<seg.num_mlets; ++midx)
+    {
+      const p3g_meshlet &mlet=mlets[seg.start_mlet+midx];
+      total_mlet_vtx+=mlet.num_vtx;
+      vtx_fill.push_back(float(mlet.num_vtx)/cfg_.max_mlet_vtx);
+      tri_fill.push_back(float(mlet.num_tris)/cfg_.max_mlet_tris);
+      float bvol_rad=dequantize_meshlet_bvol(mlet.qbvol_pos, mlet.qbvol_rad, seg_bvol).rad;
+      bvol_rads.push_back(bvol_rad);
+      max_bvol_rad=max(max_bvol_rad, bvol_rad);
+      if(!cfg_.has_vcones)
+        continue;
+      if(mlet.qvcone_dot==-127)
+      {
+        // meshlet visible from all directions
+        ++num_unbounded_vcones;
+        continue;
+      }
+      vec3f vcone_dir;
+      float vcone_dot;
+      dequantize_meshlet_vcone(vcone_dir, vcone_dot, mlet.qvcone_dir, mlet.qvcone_dot);
+      vcone_dirs.push_back(vcone_dir);
+      vcone_dots.push_back(vcone_dot);
+      vcone_angles.push_back(acos(min(max(vcone_dot, -1.0f), 1.0f))*(180.0f/mathf::pi));
+    }
+  }
+
+  // write mesh info and vertex reuse stats
+  heap_str json="{\r\n  \"input\": ";
+  push_back_json_str(json, cfg_.input_file);
+  json.push_back_format(",\r\n  \"max_mlet_vtx\": %i,\r\n  \"max_mlet_tris\": %i,\r\n", cfg_.max_mlet_vtx, cfg_.max_mlet_tris);
+  json.push_back_format("  \"num_segments\": %zi,\r\n  \"num_meshlets\": %zi,\r\n  \"num_triangles\": %i,\r\n  \"num_vertices\": %zi,\r\n",
+                        p3g_geo_.segs.size(), num_mlets, p3g_geo_.num_tris, mgeo_.num_vertices);
+  json.push_back_format("  \"vertex_reuse\": {\"acmr\": %g, \"vertex_duplication\": %g}",
+                        p3g_geo_.num_tris?double(total_mlet_vtx)/p3g_geo_.num_tris:0.0,
+                        mgeo_.num_vertices?double(total_mlet_vtx)/mgeo_.num_vertices:0.0);
+
+  // write meshlet fill ratio, bounding sphere and visibility cone angle stats
+  push_back_value_stats(json, "vertex_fill", vtx_fill, 0.0f, 1.0f, 10);
+  push_back_value_stats(json, "triangle_fill", tri_fill, 0.0f, 1.0f, 10);
+  push_back_value_stats(json, "bvol_radius", bvol_rads, 0.0f, max_bvol_rad, 16);
+  if(cfg_.has_vcones)
+  {
+    json.push_back_format(",\r\n  \"num_unbounded_vcones\": %i", num_unbounded_vcones);
+    push_back_value_stats(json, "vcone_angle", vcone_angles, 0.0f, 180.0f, 18);
+
+    // write fraction of meshlets culled by the visibility cones for stratified view directions
+    json.push_back_format(",\r\n  \"vcone_culling\": {\"num_views\": %i, \"views\": [", cfg_.num_cull_views);
+    usize_t num_vcones=vcone_dirs.size();
+    double sum_culled=0.0;
+    for(unsigned view_idx=0; view_idx<cfg_.num_cull_views; ++view_idx)
+    {
+      vec3f to_view=cone_strata_vector<float>(view_idx, cfg_.num_cull_views, -1.0f);
+      usize_t num_culled=0;
+      for(usize_t i=0; i<num_vcones; ++i)
+        if(dot(vcone_dirs[i], to_view)<vcone_dots[i])
+          ++num_culled;
+      float culled=num_mlets?float(num_culled)/num_mlets:0.0f;
+      sum_culled+=culled;
+      json.push_back_format("%s\r\n    {\"dir\": [%.4f, %.4f, %.4f], \"culled\": %.4f}", view_idx?",":"", to_view.x, to_view.y, to_view.z, culled);
+    }
+    json.push_back_format("\r\n  ], \"mean_culled\": %.4f}", cfg_.num_cull_views?sum_culled/cfg_.num_cull_views:0.0);
+  }
+
+  // write P3G section byte breakdown of the exported data
+  p3g_view p3g;
+  if(p3g_data_ && p3g.init(p3g_data_, p3g_size_))
+  {
+    const uint8_t *data=(const uint8_t*)p3g_data_;
+    const uint16_t flags=p3g.flags();
+    const bool is_large=(flags&p3gflag_large)!=0;
+    const usize_t header_size=is_large?sizeof(p3g_file_header_large):sizeof(p3g_file_header);
+    const usize_t segs_size=p3g.num_segments()*(is_large?sizeof(p3g_file_segment_large):sizeof(p3g_file_segment));
+    const usize_t mlets_size=p3g.num_meshlets()*((is_large?12:8)+(flags&p3gflag_bvols?4:0)+(flags&p3gflag_vcones?4:0));
+    const usize_t offs_vibuf=header_size+segs_size+mlets_size;
+    const usize_t offs_vbuf=usize_t((const uint8_t*)p3g.vbuf()-data);
+    usize_t offs_tibuf=offs_vbuf;
+    for(unsigned mlet_idx=0; mlet_idx<p3g.num_meshlets(); ++mlet_idx)
+      offs_tibuf=min(offs_tibuf, usize_t(p3g.meshlet_triangle_data(mlet_idx)-data));
+
+    // report the alignment padding between the triangle indices and the vertex data separately
+    const bool is_packed_tidx=(flags&p3gflag_packed_tidx)!=0;
+    usize_t tidx_size=is_packed_tidx?p3g_packed_tidx_guard_size:0;
+    for(const p3g_meshlet &mlet:mlets)
+      tidx_size+=is_packed_tidx?(mlet.num_idx*p3g_packed_tidx_width(mlet.num_vtx)+7)/8:mlet.num_idx;
+    tidx_size=min(tidx_size, offs_vbuf-offs_tibuf);
+    json.push_back_format(",\r\n  \"p3g_sections\": {\"header\": %zi, \"segments\": %zi, \"meshlets\": %zi, \"vertex_indices\": %zi, \"triangle_indices\": %zi, \"padding\": %zi, \"vertex_data\": %i, \"total\": %i}",
+                          header_size, segs_size, mlets_size, offs_tibuf-offs_vibuf, tidx_size, offs_vbuf-offs_tibuf-tidx_size, p3g.vbuf_size(), p3g.size());
+  }
+  json+="\r\n}\r\n";
+  fout_.write_bytes(json.c_str(), json.size());
+  return true;
+}
+//----------------------------------------------------------------------------
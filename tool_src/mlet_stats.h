@@ -0,0 +1,46 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_MLET_STATS_H
+#define PFC_MESHLETE_MLET_STATS_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "sxp_src/core/containers.h"
+namespace pfc
+{
+struct mesh_geometry;
+struct p3g_mesh_geometry;
+class bin_output_stream_base;
+
+// new
+struct meshlet_stats_cfg;
+float select_quantile(array<float>&, float q_);
+bool write_meshlet_stats_report(bin_output_stream_base&, const meshlet_stats_cfg&, const mesh_geometry&, const p3g_mesh_geometry&, const void *p3g_data_=0, usize_t p3g_size_=0);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// meshlet_stats_cfg
+//============================================================================
+struct meshlet_stats_cfg
+{
+  const char *input_file;
+  uint8_t max_mlet_vtx;
+  uint8_t max_mlet_tris;
+  bool has_vcones;           // meshlet visibility cones have been generated
+  unsigned num_cull_views;   // number of view directions for the visibility cone culling stats
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
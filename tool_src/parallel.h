@@ -0,0 +1,78 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_PARALLEL_H
+#define PFC_MESHLETE_PARALLEL_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "sxp_src/core/math/math.h"
+#include <thread>
+#include <atomic>
+#include <vector>
+namespace pfc
+{
+
+// new
+unsigned default_num_worker_threads();
+template<class Func> void parallel_for(uint32_t num_jobs_, unsigned num_threads_, const Func&);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// default_num_worker_threads
+//============================================================================
+PFC_INLINE unsigned default_num_worker_threads()
+{
+  unsigned num_threads=std::thread::hardware_concurrency();
+  return num_threads?num_threads:1;
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// parallel_for
+//============================================================================
+template<class Func>
+void parallel_for(uint32_t num_jobs_, unsigned num_threads_, const Func &func_)
+{
+  // run jobs on the calling thread if there's nothing to parallelize
+  // note: func_(job_idx, thread_idx) is called exactly once for each job index.
+  //       thread_idx is in range [0, num_threads_) and can be used to index per-thread scratch data
+  num_threads_=min<unsigned>(num_threads_, num_jobs_);
+  if(num_threads_<=1)
+  {
+    for(uint32_t job_idx=0; job_idx<num_jobs_; ++job_idx)
+      func_(job_idx, 0u);
+    return;
+  }
+
+  // pull jobs from a shared counter with the calling thread taking part as worker #0
+  std::atomic<uint32_t> next_job(0);
+  auto worker=[&](unsigned thread_idx_)
+  {
+    uint32_t job_idx;
+    while((job_idx=next_job.fetch_add(1, std::memory_order_relaxed))<num_jobs_)
+      func_(job_idx, thread_idx_);
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(num_threads_-1);
+  for(unsigned ti=1; ti<num_threads_; ++ti)
+    workers.emplace_back(worker, ti);
+  worker(0);
+  for(std::thread &t:workers)
+    t.join();
+}
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
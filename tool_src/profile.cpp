@@ -0,0 +1,291 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "profile.h"
+#include "sxp_src/core/streams.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#if defined(PFC_PLATFORM_WIN32) || defined(PFC_PLATFORM_WIN64)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <stdio.h>
+#endif
+#endif
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// process_cpu_time
+//============================================================================
+double pfc::process_cpu_time()
+{
+#if defined(PFC_PLATFORM_WIN32) || defined(PFC_PLATFORM_WIN64)
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if(!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+    return 0.0;
+  uint64_t kt=(uint64_t(kernel_time.dwHighDateTime)<<32)|kernel_time.dwLowDateTime;
+  uint64_t ut=(uint64_t(user_time.dwHighDateTime)<<32)|user_time.dwLowDateTime;
+  return double(kt+ut)*1.0e-7;
+#else
+  rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage))
+    return 0.0;
+  return double(usage.ru_utime.tv_sec+usage.ru_stime.tv_sec)+double(usage.ru_utime.tv_usec+usage.ru_stime.tv_usec)*1.0e-6;
+#endif
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// process_peak_memory
+//============================================================================
+uint64_t pfc::process_peak_memory()
+{
+#if defined(PFC_PLATFORM_WIN32) || defined(PFC_PLATFORM_WIN64)
+  PROCESS_MEMORY_COUNTERS pmc;
+  if(!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return 0;
+  return pmc.PeakWorkingSetSize;
+#else
+  rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage))
+    return 0;
+#if defined(__APPLE__)
+  return uint64_t(usage.ru_maxrss); // bytes on macOS
+#else
+  return uint64_t(usage.ru_maxrss)*1024; // KB on Linux
+#endif
+#endif
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// process_resident_memory
+//============================================================================
+uint64_t pfc::process_resident_memory()
+{
+#if defined(PFC_PLATFORM_WIN32) || defined(PFC_PLATFORM_WIN64)
+  PROCESS_MEMORY_COUNTERS pmc;
+  if(!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return 0;
+  return pmc.WorkingSetSize;
+#elif defined(__APPLE__)
+  mach_task_basic_info info;
+  mach_msg_type_number_t count=MACH_TASK_BASIC_INFO_COUNT;
+  if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count)!=KERN_SUCCESS)
+    return 0;
+  return info.resident_size;
+#else
+  // resident pages are the second field of statm
+  FILE *f=fopen("/proc/self/statm", "r");
+  if(!f)
+    return 0;
+  unsigned long long num_pages=0, num_resident_pages=0;
+  int num_read=fscanf(f, "%llu %llu", &num_pages, &num_resident_pages);
+  fclose(f);
+  return num_read==2?uint64_t(num_resident_pages)*uint64_t(sysconf(_SC_PAGESIZE)):0;
+#endif
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// push_back_json_str
+//============================================================================
+void pfc::push_back_json_str(heap_str &json_, const char *str_)
+{
+  // append quoted string with JSON escapes for quotes, backslashes and control chars
+  json_+="\"";
+  for(; *str_; ++str_)
+  {
+    char c=*str_;
+    if(c=='\"' || c=='\\')
+    {
+      char esc[3]={'\\', c, 0};
+      json_+=esc;
+    }
+    else if(uint8_t(c)<0x20)
+      json_.push_back_format("\\u%04x", c);
+    else
+    {
+      char chr[2]={c, 0};
+      json_+=chr;
+    }
+  }
+  json_+="\"";
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// profiler
+//============================================================================
+struct profiler::state
+{
+  state()
+  {
+    start_time=std::chrono::steady_clock::now();
+    stage_start_time=start_time;
+    start_cpu_time=process_cpu_time();
+    stage_start_cpu_time=start_cpu_time;
+    stage_start_mem=0;
+    stage_max_mem=0;
+    is_sampling_mem=false;
+    is_stage_active=false;
+  }
+  //----
+
+  void stop_memory_sampling()
+  {
+    is_sampling_mem=false;
+    if(mem_sampler.joinable())
+      mem_sampler.join();
+  }
+  //----
+
+  std::chrono::steady_clock::time_point start_time;
+  std::chrono::steady_clock::time_point stage_start_time;
+  double start_cpu_time;
+  double stage_start_cpu_time;
+  uint64_t stage_start_mem;
+  std::atomic<uint64_t> stage_max_mem;
+  std::atomic<bool> is_sampling_mem;
+  std::thread mem_sampler;
+  bool is_stage_active;
+};
+//----
+
+profiler::profiler(bool is_enabled_)
+{
+  m_state=is_enabled_?new state:0;
+}
+//----
+
+profiler::~profiler()
+{
+  // stop sampling if the conversion failed during a stage
+  if(m_state)
+  {
+    m_state->stop_memory_sampling();
+    delete m_state;
+  }
+}
+//----
+
+void profiler::begin_stage(const char *name_)
+{
+  // start new stage
+  if(!m_state)
+    return;
+  PFC_ASSERT_MSG(!m_state->is_stage_active, ("Profile stage \"%s\" started before ending the previous stage\r\n", name_));
+  profile_stage &stage=m_stages.push_back();
+  stage.name=name_;
+  stage.wall_time=0.0;
+  stage.cpu_time=0.0;
+  stage.peak_mem=0;
+  stage.stage_peak_mem=0;
+  m_state->is_stage_active=true;
+
+  // sample the resident memory during the stage for the stage peak
+  enum {mem_sample_interval_us=1000};
+  state &st=*m_state;
+  st.stage_start_mem=process_resident_memory();
+  st.stage_max_mem=st.stage_start_mem;
+  st.is_sampling_mem=true;
+  st.mem_sampler=std::thread([&st]()
+  {
+    while(st.is_sampling_mem.load(std::memory_order_relaxed))
+    {
+      uint64_t mem=process_resident_memory();
+      if(mem>st.stage_max_mem.load(std::memory_order_relaxed))
+        st.stage_max_mem.store(mem, std::memory_order_relaxed);
+      std::this_thread::sleep_for(std::chrono::microseconds(mem_sample_interval_us));
+    }
+  });
+  st.stage_start_cpu_time=process_cpu_time();
+  st.stage_start_time=std::chrono::steady_clock::now();
+}
+//----
+
+array<double> *profiler::stage_segment_times()
+{
+  if(!m_state)
+    return 0;
+  PFC_ASSERT(m_state->is_stage_active);
+  return &m_stages[m_stages.size()-1].seg_times;
+}
+//----
+
+void profiler::end_stage()
+{
+  // record stage times and memory
+  if(!m_state)
+    return;
+  state &st=*m_state;
+  PFC_ASSERT(st.is_stage_active);
+  profile_stage &stage=m_stages[m_stages.size()-1];
+  stage.wall_time=std::chrono::duration<double>(std::chrono::steady_clock::now()-st.stage_start_time).count();
+  stage.cpu_time=process_cpu_time()-st.stage_start_cpu_time;
+  st.stop_memory_sampling();
+  uint64_t max_mem=max<uint64_t>(st.stage_max_mem.load(), process_resident_memory());
+  stage.peak_mem=process_peak_memory();
+  stage.stage_peak_mem=max_mem>st.stage_start_mem?max_mem-st.stage_start_mem:0;
+  st.is_stage_active=false;
+}
+//----
+
+bool profiler::write_json_report(bin_output_stream_base &fout_, const char *tool_name_, const char *input_file_) const
+{
+  // write report header with the totals
+  PFC_ASSERT(m_state);
+  double wall_time=std::chrono::duration<double>(std::chrono::steady_clock::now()-m_state->start_time).count();
+  double cpu_time=process_cpu_time()-m_state->start_cpu_time;
+  heap_str json="{\r\n  \"tool\": ";
+  push_back_json_str(json, tool_name_);
+  json+=",\r\n  \"input\": ";
+  push_back_json_str(json, input_file_);
+  json.push_back_format(",\r\n"
+                        "  \"wall_time\": %.6f,\r\n"
+                        "  \"cpu_time\": %.6f,\r\n"
+                        "  \"peak_mem\": %llu,\r\n"
+                        "  \"stages\": [", wall_time, cpu_time, (unsigned long long)process_peak_memory());
+
+  // write stages
+  for(usize_t i=0; i<m_stages.size(); ++i)
+  {
+    const profile_stage &stage=m_stages[i];
+    json.push_back_format("%s\r\n    {\"name\": \"%s\", \"wall_time\": %.6f, \"cpu_time\": %.6f, \"peak_mem\": %llu, \"stage_peak_mem\": %llu",
+                          i?",":"", stage.name.c_str(), stage.wall_time, stage.cpu_time, (unsigned long long)stage.peak_mem, (unsigned long long)stage.stage_peak_mem);
+    if(stage.seg_times.size())
+    {
+      json+=", \"seg_times\": [";
+      for(usize_t si=0; si<stage.seg_times.size(); ++si)
+        json.push_back_format("%s%.6f", si?", ":"", stage.seg_times[si]);
+      json+="]";
+    }
+    json+="}";
+  }
+  json+="\r\n  ]\r\n}\r\n";
+  fout_.write_bytes(json.c_str(), json.size());
+  return true;
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,112 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_PROFILE_H
+#define PFC_MESHLETE_PROFILE_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "sxp_src/core/containers.h"
+#include "sxp_src/core/str.h"
+namespace pfc
+{
+class bin_output_stream_base;
+
+// new
+struct profile_stage;
+class profiler;
+double process_cpu_time();
+uint64_t process_peak_memory();
+uint64_t process_resident_memory();
+void push_back_json_str(heap_str&, const char *str_);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// profile_stage
+//============================================================================
+struct profile_stage
+{
+  heap_str name;
+  double wall_time;        // seconds
+  double cpu_time;         // process CPU time (user+system, all threads) in seconds
+  uint64_t peak_mem;       // process peak resident memory at the end of the stage in bytes
+  uint64_t stage_peak_mem; // peak resident memory during the stage above the resident memory at the stage start in bytes
+  array<double> seg_times; // per-segment wall times in seconds (if recorded by the stage)
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// profiler
+//============================================================================
+// Records wall/CPU time and peak memory of sequential conversion stages.
+// The stage peak memory is sampled from the process resident memory on a
+// background thread during the stage, so it's measured for every stage
+// independent of the process high-water mark set by earlier stages. Peaks
+// shorter than the sampling interval may be missed. A disabled profiler
+// doesn't record anything or start the sampling thread.
+class profiler
+{
+public:
+  // construction
+  explicit profiler(bool is_enabled_=true);
+  ~profiler();
+  //--------------------------------------------------------------------------
+
+  // profiling
+  void begin_stage(const char *name_);
+  array<double> *stage_segment_times();
+  void end_stage();
+  PFC_INLINE bool is_enabled() const;
+  PFC_INLINE const array<profile_stage> &stages() const;
+  bool write_json_report(bin_output_stream_base&, const char *tool_name_, const char *input_file_) const;
+  //--------------------------------------------------------------------------
+
+private:
+  profiler(const profiler&); // not implemented
+  void operator=(const profiler&); // not implemented
+  struct state;
+  //--------------------------------------------------------------------------
+
+  array<profile_stage> m_stages;
+  state *m_state; // timing and memory sampling state (null if disabled)
+};
+//----------------------------------------------------------------------------
+
+
+
+
+//============================================================================
+//============================================================================
+// inline & template implementations
+//============================================================================
+//============================================================================
+
+
+//============================================================================
+// profiler
+//============================================================================
+bool profiler::is_enabled() const
+{
+  return m_state!=0;
+}
+//----
+
+const array<profile_stage> &profiler::stages() const
+{
+  return m_stages;
+}
+//----------------------------------------------------------------------------
+
+//============================================================================
+} // namespace pfc
+#endif
@@ -6,6 +6,7 @@
 //============================================================================
 
 #include "vbuf_expr.h"
+#include "vbuf_simd.h"
 using namespace pfc;
 //----------------------------------------------------------------------------
 
@@ -15,6 +16,7 @@ using namespace pfc;
 //============================================================================
 namespace
 {
+  #include "vbuf_expr_ops.inc"
   typedef vbuf_expression_parser_t::var_t var_t;
   typedef vbuf_expression_parser_t::var_stack_t var_stack_t;
   //--------------------------------------------------------------------------
@@ -47,6 +49,14 @@ namespace
     vstack_.push_back();
     return false;
   }
+  //----
+
+  PFC_INLINE bool is_contiguous(const var_t &v_, unsigned tidx_, uint32_t num_vals_, uint8_t num_data_elems_)
+  {
+    // check if value is a contiguous array of given type and layout (for SIMD kernels)
+    return    v_.value.type_index()==tidx_ && v_.num_vals==num_vals_ && v_.num_data_elems==num_data_elems_
+           && v_.data_stride==num_data_elems_ && !v_.data_offset;
+  }
   //--------------------------------------------------------------------------
 
   //==========================================================================
@@ -81,7 +91,7 @@ namespace
 
     // prepare the result
     var_t &res=vstack_.push_back();
-    res.data=PFC_MEM_ALLOC(sv.num_vals*sv.num_data_elems*sizeof(float32_t));
+    res.data.alloc(sv.num_vals*sv.num_data_elems*sizeof(float32_t));
     res.init(sv.num_data_elems, sv.num_vals);
 
     // evaluate the expression
@@ -96,7 +106,7 @@ namespace
   //----
 
   template<typename T, typename Expr>
-  void eval_1arg_expr_fixed(int num_args_, var_stack_t &vstack_, const Expr &expr_)
+  void eval_1arg_expr_fixed(int num_args_, var_stack_t &vstack_, const Expr &expr_, void(*simd_)(T*, const T*, usize_t)=0)
   {
     // get the top value from the variable stack
     var_t sv;
@@ -109,9 +119,16 @@ namespace
     if(sv_tidx!=vbuf_expression_value::value_t::find_type<T*>::res)
       return;
 
-    // prepare the result and evaluate the expression
-    res.data=PFC_MEM_ALLOC(sv.num_vals*sv.num_data_elems*sizeof(T));
+    // prepare the result and evaluate the expression (with SIMD kernel for contiguous data)
+    res.data.alloc(sv.num_vals*sv.num_data_elems*sizeof(T));
     res.init(sv.num_data_elems, sv.num_vals);
+    if(simd_ && is_contiguous(sv, sv_tidx, sv.num_vals, sv.num_data_elems))
+    {
+      T *res_data=(T*)res.data.data;
+      simd_(res_data, type_ref<T*>(sv.value), usize_t(sv.num_vals)*sv.num_data_elems);
+      res.value=res_data;
+      return;
+    }
     eval_1arg_expr_impl<T, T>(res, sv, expr_);
   }
   //----
@@ -127,7 +144,7 @@ namespace
 
     // prepare the result
     var_t &res=vstack_.push_back();
-    res.data=PFC_MEM_ALLOC(sv.num_vals*sv.num_data_elems*sizeof(float32_t));
+    res.data.alloc(sv.num_vals*sv.num_data_elems*sizeof(float32_t));
     res.init(sv.num_data_elems, sv.num_vals);
 
     // evaluate the expression
@@ -165,7 +182,7 @@ namespace
   //----
 
   template<typename Expr>
-  void eval_2arg_expr(int num_args_, var_stack_t &vstack_, const Expr &expr_)
+  void eval_2arg_expr(int num_args_, var_stack_t &vstack_, const Expr &expr_, vbuf_simd_funcs::f32_2arg_t simd_f32_=0, vbuf_simd_funcs::i32_2arg_t simd_i32_=0)
   {
     // get the top two values from the variable stack
     var_t sv[2];
@@ -181,9 +198,28 @@ namespace
     // prepare the result
     uint32_t num_vals=max(sv[0].num_vals, sv[1].num_vals);
     uint8_t num_data_elems=max(sv[0].num_data_elems, sv[1].num_data_elems);
-    res.data=PFC_MEM_ALLOC(num_vals*num_data_elems*sizeof(float32_t));
+    res.data.alloc(num_vals*num_data_elems*sizeof(float32_t));
     res.init(num_data_elems, num_vals);
 
+    // use SIMD kernels for contiguous operands of the same type
+    unsigned tidx_float=vbuf_expression_value::value_t::find_type<float32_t*>::res;
+    unsigned tidx_int=vbuf_expression_value::value_t::find_type<int32_t*>::res;
+    usize_t num_res_elems=usize_t(num_vals)*num_data_elems;
+    if(simd_f32_ && is_contiguous(sv[0], tidx_float, num_vals, num_data_elems) && is_contiguous(sv[1], tidx_float, num_vals, num_data_elems))
+    {
+      float32_t *res_data=(float32_t*)res.data.data;
+      simd_f32_(res_data, type_ref<float32_t*>(sv[0].value), type_ref<float32_t*>(sv[1].value), num_res_elems);
+      res.value=res_data;
+      return;
+    }
+    if(simd_i32_ && is_contiguous(sv[0], tidx_int, num_vals, num_data_elems) && is_contiguous(sv[1], tidx_int, num_vals, num_data_elems))
+    {
+      int32_t *res_data=(int32_t*)res.data.data;
+      simd_i32_(res_data, type_ref<int32_t*>(sv[0].value), type_ref<int32_t*>(sv[1].value), num_res_elems);
+      res.value=res_data;
+      return;
+    }
+
     // evaluate the expression for proper type combination
     typedef void(*expr_func_t)(var_t&, const var_t&, const var_t&, const Expr&);
     static const expr_func_t s_expr_funcs[]=
@@ -219,7 +255,7 @@ namespace
     // prepare the result and evaluate the expression
     uint32_t num_vals=max(sv[0].num_vals, sv[1].num_vals);
     uint8_t num_data_elems=max(sv[0].num_data_elems, sv[1].num_data_elems);
-    res.data=PFC_MEM_ALLOC(num_vals*num_data_elems*sizeof(T));
+    res.data.alloc(num_vals*num_data_elems*sizeof(T));
     res.init(num_data_elems, num_vals);
     eval_2arg_expr_impl<T, T, T, T>(res, sv[0], sv[1], expr_); 
   }
@@ -242,7 +278,7 @@ namespace
     // prepare the result
     uint32_t num_vals=max(sv[0].num_vals, sv[1].num_vals);
     uint8_t num_data_elems=max(sv[0].num_data_elems, sv[1].num_data_elems);
-    res.data=PFC_MEM_ALLOC(num_vals*num_data_elems*sizeof(int32_t));
+    res.data.alloc(num_vals*num_data_elems*sizeof(int32_t));
     res.init(num_data_elems, num_vals);
 
     // evaluate the expression for proper type combination
@@ -287,7 +323,7 @@ namespace
   //----
 
   template<typename Expr>
-  void eval_3arg_expr(int num_args_, var_stack_t &vstack_, const Expr &expr_)
+  void eval_3arg_expr(int num_args_, var_stack_t &vstack_, const Expr &expr_, vbuf_simd_funcs::f32_3arg_t simd_f32_=0)
   {
     // get the top three values from the variable stack
     var_t sv[3];
@@ -305,9 +341,22 @@ namespace
     // prepare the result
     uint32_t num_vals=max(sv[0].num_vals, sv[1].num_vals, sv[2].num_vals);
     uint8_t num_data_elems=max(sv[0].num_data_elems, sv[1].num_data_elems, sv[2].num_data_elems);
-    res.data=PFC_MEM_ALLOC(num_vals*num_data_elems*sizeof(float32_t));
+    res.data.alloc(num_vals*num_data_elems*sizeof(float32_t));
     res.init(num_data_elems, num_vals);
 
+    // use SIMD kernel for contiguous float operands
+    unsigned tidx_float=vbuf_expression_value::value_t::find_type<float32_t*>::res;
+    if(   simd_f32_
+       && is_contiguous(sv[0], tidx_float, num_vals, num_data_elems)
+       && is_contiguous(sv[1], tidx_float, num_vals, num_data_elems)
+       && is_contiguous(sv[2], tidx_float, num_vals, num_data_elems))
+    {
+      float32_t *res_data=(float32_t*)res.data.data;
+      simd_f32_(res_data, type_ref<float32_t*>(sv[0].value), type_ref<float32_t*>(sv[1].value), type_ref<float32_t*>(sv[2].value), usize_t(num_vals)*num_data_elems);
+      res.value=res_data;
+      return;
+    }
+
     // evaluate the expression for proper type combination
     typedef void(*expr_func_t)(var_t&, const var_t&, const var_t&, const var_t&, const Expr&);
     static const expr_func_t s_expr_funcs[]=
@@ -330,7 +379,7 @@ namespace
   //----
 
   template<typename T, typename Expr>
-  void eval_3arg_expr_fixed(int num_args_, var_stack_t &vstack_, const Expr &expr_)
+  void eval_3arg_expr_fixed(int num_args_, var_stack_t &vstack_, const Expr &expr_, void(*simd_)(T*, const T*, const T*, const T*, usize_t)=0)
   {
     // get the top three values from the variable stack
     var_t sv[3];
@@ -351,8 +400,18 @@ namespace
     // prepare the result and evaluate the expression
     uint32_t num_vals=max(sv[0].num_vals, sv[1].num_vals, sv[2].num_vals);
     uint8_t num_data_elems=max(sv[0].num_data_elems, sv[1].num_data_elems, sv[2].num_data_elems);
-    res.data=PFC_MEM_ALLOC(num_vals*num_data_elems*sizeof(T));
+    res.data.alloc(num_vals*num_data_elems*sizeof(T));
     res.init(num_data_elems,  num_vals);
+    if(   simd_
+       && is_contiguous(sv[0], sv_tidx[0], num_vals, num_data_elems)
+       && is_contiguous(sv[1], sv_tidx[1], num_vals, num_data_elems)
+       && is_contiguous(sv[2], sv_tidx[2], num_vals, num_data_elems))
+    {
+      T *res_data=(T*)res.data.data;
+      simd_(res_data, type_ref<T*>(sv[0].value), type_ref<T*>(sv[1].value), type_ref<T*>(sv[2].value), usize_t(num_vals)*num_data_elems);
+      res.value=res_data;
+      return;
+    }
     eval_3arg_expr_impl<T, T, T, T>(res, sv[0], sv[1], sv[2], expr_); 
   }
   //--------------------------------------------------------------------------
@@ -373,7 +432,7 @@ namespace
     }
     if(!is_vec_)
       num_data_elems=1;
-    if(!num_data_elems || num_data_elems>4)
+    if(!num_data_elems || num_data_elems>4 || (!is_vec_ && num_args_!=1))
     {
       vstack_.remove_back(num_args_);
       vstack_.push_back();
@@ -382,8 +441,7 @@ namespace
 
     // prepare the result
     var_t res;
-    T *res_data=(T*)PFC_MEM_ALLOC(num_vals*num_data_elems*sizeof(T)), *res_data_end=res_data+num_vals*num_data_elems;
-    res.data=res_data;
+    T *res_data=(T*)res.data.alloc(num_vals*num_data_elems*sizeof(T)), *res_data_end=res_data+num_vals*num_data_elems;
     res.init(res_data, (uint8_t)num_data_elems,  num_vals);
 
     // vectorize all arguments
@@ -433,6 +491,30 @@ namespace
   }
   //--------------------------------------------------------------------------
 
+  //==========================================================================
+  // eval_select_impl
+  //==========================================================================
+  template<typename TR, typename T1, typename T2>
+  void eval_select_impl(var_t &res_, const uint32_t *cond_, uint32_t cond_mask_, unsigned cond_stride_, const var_t &v1_, const var_t &v2_)
+  {
+    // access data and setup result type
+    T1 *v1=type_ref<T1*>(v1_.value)+v1_.data_offset;
+    T2 *v2=type_ref<T2*>(v2_.value)+v2_.data_offset;
+    TR *res=(TR*)res_.data.data, *res_end=res+res_.num_vals*res_.num_data_elems;
+    res_.value=res;
+
+    // select values by the condition being non-zero (masked condition bits)
+    while(res<res_end)
+    {
+      for(uint8_t ei=0; ei<res_.num_data_elems; ++ei)
+        *res++=*cond_&cond_mask_?(TR)v1[v1_.data_stride?ei:0]:(TR)v2[v2_.data_stride?ei:0];
+      cond_+=cond_stride_;
+      v1+=v1_.data_stride;
+      v2+=v2_.data_stride;
+    }
+  }
+  //--------------------------------------------------------------------------
+
   //==========================================================================
   // operators
   //==========================================================================
@@ -508,44 +590,74 @@ namespace
 
     // check for proper variables
     var_t &res=vstack_.push_back();
-    if(   sv_tidx[0]!=vbuf_expression_value::value_t::find_type<float32_t*>::res
-       && sv_tidx[0]!=vbuf_expression_value::value_t::find_type<int32_t*>::res)
+    unsigned tidx_float=vbuf_expression_value::value_t::find_type<float32_t*>::res;
+    unsigned tidx_int=vbuf_expression_value::value_t::find_type<int32_t*>::res;
+    if(   (sv_tidx[0]!=tidx_float && sv_tidx[0]!=tidx_int)
+       || (sv_tidx[1]!=tidx_float && sv_tidx[1]!=tidx_int)
+       || (sv_tidx[2]!=tidx_float && sv_tidx[2]!=tidx_int)
+       || (sv[1].num_data_elems!=1 && sv[2].num_data_elems!=1 && sv[1].num_data_elems!=sv[2].num_data_elems))
       return;
 
-    // apply ternary operator
-    uint32_t v=*(uint32_t*)sv[0].value.data();
-    res=v?sv[1]:sv[2];
+    // select the value for uniform condition
+    // float conditions ignore the sign bit so that -0.0 is false
+    const uint32_t *cond=(sv_tidx[0]==tidx_float?(const uint32_t*)type_ref<float32_t*>(sv[0].value):(const uint32_t*)type_ref<int32_t*>(sv[0].value))+sv[0].data_offset;
+    const uint32_t cond_mask=sv_tidx[0]==tidx_float?0x7fffffff:0xffffffff;
+    if(!sv[0].data_stride)
+    {
+      res=*cond&cond_mask?sv[1]:sv[2];
+      return;
+    }
+
+    // prepare the result
+    uint32_t num_vals=max(sv[0].num_vals, sv[1].num_vals, sv[2].num_vals);
+    uint8_t num_data_elems=max(sv[1].num_data_elems, sv[2].num_data_elems);
+    res.data.alloc(num_vals*num_data_elems*sizeof(float32_t));
+    res.init(num_data_elems, num_vals);
+
+    // select values per condition value for proper type combination
+    typedef void(*expr_func_t)(var_t&, const uint32_t*, uint32_t, unsigned, const var_t&, const var_t&);
+    static const expr_func_t s_expr_funcs[]=
+    {
+      &eval_select_impl<float32_t, float32_t, float32_t>,
+      &eval_select_impl<float32_t,   int32_t, float32_t>,
+      &eval_select_impl<float32_t, float32_t,   int32_t>,
+      &eval_select_impl<  int32_t,   int32_t,   int32_t>,
+    };
+    unsigned sv1_offs=sv_tidx[1]==tidx_float?0:1;
+    unsigned sv2_offs=sv_tidx[2]==tidx_float?0:2;
+    expr_func_t efunc=s_expr_funcs[sv1_offs|sv2_offs];
+    efunc(res, cond, cond_mask, sv[0].data_stride, sv[1], sv[2]);
   }
   //--------------------------------------------------------------------------
 
   //==========================================================================
   // basic low-level operators
   //==========================================================================
-  void op_add(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_+v1_;});}
-  void op_sub(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_-v1_;});}
-  void op_mul(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_*v1_;});}
-  void op_div(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v1_?v0_/v1_:0;});}
-  void op_mod(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, [](int32_t v0_, int32_t v1_) {return v1_?v0_%v1_:0;});}
-  void op_bw_not(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<int32_t>(num_args_, vstack_, [](int32_t v_) {return ~v_;});}
-  void op_bw_and(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, [](int32_t v0_, int32_t v1_) {return v0_&v1_;});}
-  void op_bw_or (int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, [](int32_t v0_, int32_t v1_) {return v0_|v1_;});}
-  void op_bw_xor(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, [](int32_t v0_, int32_t v1_) {return v0_^v1_;});}
-  void op_bw_shl(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, [](int32_t v0_, int32_t v1_) {return v0_<<v1_;});}
-  void op_bw_shr(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, [](int32_t v0_, int32_t v1_) {return v0_>>v1_;});}
+  void op_add(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, vbuf_op_add(), vbuf_simd().add_f32, vbuf_simd().add_i32);}
+  void op_sub(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, vbuf_op_sub(), vbuf_simd().sub_f32, vbuf_simd().sub_i32);}
+  void op_mul(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, vbuf_op_mul(), vbuf_simd().mul_f32, vbuf_simd().mul_i32);}
+  void op_div(int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, vbuf_op_div(), vbuf_simd().div_f32);}
+  void op_mod(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, vbuf_op_mod());}
+  void op_bw_not(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<int32_t>(num_args_, vstack_, vbuf_op_bw_not());}
+  void op_bw_and(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, vbuf_op_bw_and());}
+  void op_bw_or (int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, vbuf_op_bw_or());}
+  void op_bw_xor(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, vbuf_op_bw_xor());}
+  void op_bw_shl(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, vbuf_op_bw_shl());}
+  void op_bw_shr(int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<int32_t>(num_args_, vstack_, vbuf_op_bw_shr());}
   //--------------------------------------------------------------------------
 
   //==========================================================================
   // logical and comparison operators
   //==========================================================================
-  void op_and(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_&&v1_?1:0;});}
-  void op_or(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_||v1_?1:0;});}
-  void op_not(int num_args_, var_stack_t &vstack_) {eval_1arg_cmp_expr(num_args_, vstack_, [](auto v_) {return !v_?1:0;});}
-  void op_eq(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_==v1_?1:0;});}
-  void op_neq(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_!=v1_?1:0;});}
-  void op_lt(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_<v1_?1:0;});}
-  void op_gt(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_>v1_?1:0;});}
-  void op_lte(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_<=v1_?1:0;});}
-  void op_gte(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return v0_>=v1_?1:0;});}
+  void op_and(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_and());}
+  void op_or(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_or());}
+  void op_not(int num_args_, var_stack_t &vstack_) {eval_1arg_cmp_expr(num_args_, vstack_, vbuf_op_not());}
+  void op_eq(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_eq());}
+  void op_neq(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_neq());}
+  void op_lt(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_lt());}
+  void op_gt(int num_args_, var_stack_t &vstack_)  {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_gt());}
+  void op_lte(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_lte());}
+  void op_gte(int num_args_, var_stack_t &vstack_) {eval_2arg_cmp_expr(num_args_, vstack_, vbuf_op_gte());}
   //--------------------------------------------------------------------------
 
   //==========================================================================
@@ -560,43 +672,43 @@ namespace
   //==========================================================================
   // basic component-wise functions
   //==========================================================================
-  void func_min    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return min(v0_, v1_);});}
-  void func_max    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, [](auto v0_, auto v1_) {return max(v0_, v1_);});}
-  void func_sat    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, [](auto v_) {return sat(v_);});}
-  void func_ssat   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, [](auto v_) {return ssat(v_);});}
-  void func_abs    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, [](auto v_) {return abs(v_);});}
-  void func_clamp  (int num_args_, var_stack_t &vstack_) {eval_3arg_expr(num_args_, vstack_, [](auto v_, auto min_, auto max_) {return clamp(v_, min_, max_);});}
-  void func_floor  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return floor(v_);});}
-  void func_ceil   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return ceil(v_);});}
-  void func_trunc  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return trunc(v_);});}
-  void func_round  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return round(v_);});}
-  void func_frc    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return frc(v_);});}
-  void func_mod    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_, float32_t div_) {return mod(v_, div_);});}
-  void func_sgn    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, [](auto v_) {return sgn(v_);});}
-  void func_sgn_zp (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, [](auto v_) {return sgn_zp(v_);});}
-  void func_sqr    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, [](auto v_) {return sqr(v_);});}
-  void func_cubic  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, [](auto v_) {return cubic(v_);});}
-  void func_sqrt   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return pfc::sqrt(v_);});}
-  void func_sqrt_z (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return sqrt_z(v_);});}
-  void func_cbrt   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return cbrt(v_);});}
-  void func_rsqrt  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return rsqrt(v_);});}
-  void func_rsqrt_z(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return rsqrt_z(v_);});}
-  void func_rcbrt  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return rcbrt(v_);});}
-  void func_rcbrt_z(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return rcbrt_z(v_);});}
-  void func_exp    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return exp(v_);});}
-  void func_exp2   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return exp2(v_);});}
-  void func_ln     (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return ln(v_);});}
-  void func_log2   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return log2(v_);});}
-  void func_log10  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return log10(v_);});}
-  void func_pow    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t b_, float32_t e_) {return pow(b_, e_);});}
+  void func_min    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, vbuf_op_min(), vbuf_simd().min_f32, vbuf_simd().min_i32);}
+  void func_max    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr(num_args_, vstack_, vbuf_op_max(), vbuf_simd().max_f32, vbuf_simd().max_i32);}
+  void func_sat    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, vbuf_op_sat());}
+  void func_ssat   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, vbuf_op_ssat());}
+  void func_abs    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, vbuf_op_abs());}
+  void func_clamp  (int num_args_, var_stack_t &vstack_) {eval_3arg_expr(num_args_, vstack_, vbuf_op_clamp(), vbuf_simd().clamp_f32);}
+  void func_floor  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_floor(), vbuf_simd().floor_f32);}
+  void func_ceil   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_ceil());}
+  void func_trunc  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_trunc());}
+  void func_round  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_round(), vbuf_simd().round_f32);}
+  void func_frc    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_frc());}
+  void func_mod    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_fmod());}
+  void func_sgn    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, vbuf_op_sgn());}
+  void func_sgn_zp (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, vbuf_op_sgn_zp());}
+  void func_sqr    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, vbuf_op_sqr());}
+  void func_cubic  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr(num_args_, vstack_, vbuf_op_cubic());}
+  void func_sqrt   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_sqrt(), vbuf_simd().sqrt_f32);}
+  void func_sqrt_z (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_sqrt_z());}
+  void func_cbrt   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_cbrt());}
+  void func_rsqrt  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_rsqrt());}
+  void func_rsqrt_z(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_rsqrt_z());}
+  void func_rcbrt  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_rcbrt());}
+  void func_rcbrt_z(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_rcbrt_z());}
+  void func_exp    (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_exp());}
+  void func_exp2   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_exp2());}
+  void func_ln     (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_ln());}
+  void func_log2   (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_log2());}
+  void func_log10  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_log10());}
+  void func_pow    (int num_args_, var_stack_t &vstack_) {eval_2arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_pow());}
   //--------------------------------------------------------------------------
 
   //==========================================================================
   // higher level functions
   //==========================================================================
-  void func_lerp        (int num_args_, var_stack_t &vstack_) {eval_3arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v0_, float32_t v1_, float32_t t_) {return lerp(v0_, v1_, t_);});}
-  void func_smoothstep  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return smoothstep(v_);});}
-  void func_smootherstep(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, [](float32_t v_) {return smootherstep(v_);});}
+  void func_lerp        (int num_args_, var_stack_t &vstack_) {eval_3arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_lerp(), vbuf_simd().lerp_f32);}
+  void func_smoothstep  (int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_smoothstep(), vbuf_simd().smoothstep_f32);}
+  void func_smootherstep(int num_args_, var_stack_t &vstack_) {eval_1arg_expr_fixed<float32_t>(num_args_, vstack_, vbuf_op_smootherstep());}
 } // namespace <anonymous>
 //----------------------------------------------------------------------------
 
@@ -673,6 +785,154 @@ void init_vbuf_expression_parser_funcs(vbuf_expression_parser_t &parser_)
 //----------------------------------------------------------------------------
 
 
+void set_vbuf_expression_streams(vbuf_expression_parser_t &parser_, const vbuf_expression_stream *streams_, usize_t num_streams_)
+{
+  // setup expression variables for the streams
+  for(usize_t si=0; si<num_streams_; ++si)
+  {
+    const vbuf_expression_stream &s=streams_[si];
+    var_t v;
+    if(s.is_int)
+      v.init((int32_t*)s.data, s.num_elems, s.num_vals);
+    else
+      v.init((float32_t*)s.data, s.num_elems, s.num_vals);
+    parser_.set_var(s.name, v);
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_expression_arena
+//============================================================================
+thread_local vbuf_expression_arena *vbuf_expression_arena::s_active=0;
+//----------------------------------------------------------------------------
+
+vbuf_expression_arena::vbuf_expression_arena(uint32_t num_vals_)
+  :m_prev_active(s_active)
+  ,m_min_alloc_size(usize_t(num_vals_)*sizeof(uint32_t))
+  ,m_buffer_size(usize_t(num_vals_)*4*sizeof(uint32_t))
+{
+  s_active=this;
+}
+//----
+
+vbuf_expression_arena::~vbuf_expression_arena()
+{
+  PFC_ASSERT_MSG(m_free_buffers.size()==m_buffers.size(), ("All vbuf expression arena buffers must be released before destruction\r\n"));
+  PFC_ASSERT_MSG(s_active==this, ("vbuf expression arenas must be destroyed in reverse order of construction\r\n"));
+  s_active=m_prev_active;
+}
+//----------------------------------------------------------------------------
+
+void *vbuf_expression_arena::alloc(usize_t size_, uint32_t &buffer_idx_)
+{
+  // reuse a released buffer if big enough
+  if(m_free_buffers.size())
+  {
+    buffer_idx_=m_free_buffers.back();
+    buffer &buf=m_buffers[buffer_idx_];
+    if(buf.size>=size_)
+    {
+      m_free_buffers.pop_back();
+      return buf.data.data;
+    }
+  }
+
+  // allocate new buffer
+  buffer_idx_=(uint32_t)m_buffers.size();
+  buffer &buf=m_buffers.push_back();
+  buf.size=max(size_, m_buffer_size);
+  buf.data=PFC_MEM_ALLOC(buf.size);
+  return buf.data.data;
+}
+//----
+
+void vbuf_expression_arena::release(uint32_t buffer_idx_)
+{
+  PFC_ASSERT(buffer_idx_<m_buffers.size());
+  m_free_buffers.push_back(buffer_idx_);
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_expression_data
+//============================================================================
+vbuf_expression_data::vbuf_expression_data()
+  :data(0)
+  ,arena(0)
+  ,arena_buffer_idx(0)
+{
+}
+//----
+
+vbuf_expression_data::vbuf_expression_data(const vbuf_expression_data &d_)
+  :data(d_.data)
+  ,heap_data(d_.heap_data)
+  ,arena(d_.arena)
+  ,arena_buffer_idx(d_.arena_buffer_idx)
+{
+  // transfer the ownership
+  vbuf_expression_data &d=const_cast<vbuf_expression_data&>(d_);
+  d.data=0;
+  d.arena=0;
+}
+//----
+
+void vbuf_expression_data::operator=(const vbuf_expression_data &d_)
+{
+  // release the data and transfer the ownership
+  if(this==&d_)
+    return;
+  release();
+  vbuf_expression_data &d=const_cast<vbuf_expression_data&>(d_);
+  data=d.data;
+  heap_data=d.heap_data;
+  arena=d.arena;
+  arena_buffer_idx=d.arena_buffer_idx;
+  d.data=0;
+  d.arena=0;
+}
+//----
+
+vbuf_expression_data::~vbuf_expression_data()
+{
+  release();
+}
+//----
+
+void *vbuf_expression_data::alloc(usize_t size_)
+{
+  // allocate vertex array sized data from the active arena and small data from the heap
+  release();
+  vbuf_expression_arena *active_arena=vbuf_expression_arena::active();
+  if(active_arena && size_>=active_arena->min_alloc_size())
+  {
+    arena=active_arena;
+    data=arena->alloc(size_, arena_buffer_idx);
+  }
+  else
+  {
+    heap_data=PFC_MEM_ALLOC(size_);
+    data=heap_data.data;
+  }
+  return data;
+}
+//----
+
+void vbuf_expression_data::release()
+{
+  // return the data to the arena or the heap
+  if(arena)
+    arena->release(arena_buffer_idx);
+  heap_data=0;
+  data=0;
+  arena=0;
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // vbuf_expression_value
 //============================================================================
@@ -684,7 +944,6 @@ vbuf_expression_value::vbuf_expression_value()
 
 vbuf_expression_value::vbuf_expression_value(const vbuf_expression_value &v_)
   :value(v_.value)
-  ,data(0)
   ,num_vals(v_.num_vals)
   ,pinned_owner(0)
   ,num_data_elems(v_.num_data_elems)
@@ -697,8 +956,7 @@ vbuf_expression_value::vbuf_expression_value(const vbuf_expression_value &v_)
 
 vbuf_expression_value::vbuf_expression_value(float64_t v_)
 {
-  data=PFC_MEM_ALLOC(sizeof(float32_t));
-  float32_t *v=(float*)data.data;
+  float32_t *v=(float32_t*)data.alloc(sizeof(float32_t));
   *v=float32_t(v_);
   init(v, 1, 1);
 }
@@ -706,8 +964,7 @@ vbuf_expression_value::vbuf_expression_value(float64_t v_)
 
 vbuf_expression_value::vbuf_expression_value(int64_t v_)
 {
-  data=PFC_MEM_ALLOC(sizeof(int32_t));
-  int32_t *v=(int32_t*)data.data;
+  int32_t *v=(int32_t*)data.alloc(sizeof(int32_t));
   *v=int32_t(v_);
   init(v, 1, 1);
 }
@@ -19,9 +19,89 @@
 #include "sxp_src/core/variant.h"
 
 // new
+class vbuf_expression_arena;
+struct vbuf_expression_data;
 struct vbuf_expression_value;
+struct vbuf_expression_stream;
 typedef pfc::expression_parser<pfc::expression_parser_config<vbuf_expression_value> > vbuf_expression_parser_t;
 void init_vbuf_expression_parser_funcs(vbuf_expression_parser_t&);
+void set_vbuf_expression_streams(vbuf_expression_parser_t&, const vbuf_expression_stream*, pfc::usize_t num_streams_);
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_expression_arena
+//============================================================================
+// Recycling allocator for vertex buffer expression temporaries. Buffers of
+// values consumed from the evaluation stack are returned to the arena and
+// reused by the following operations, so evaluation needs only about as many
+// buffers as the max stack depth of the expressions. Each buffer fits
+// num_vals_ 4-element values and serves allocations of at least num_vals_
+// 32-bit values. While alive, the arena is active for all expression
+// evaluation in the constructing thread.
+class vbuf_expression_arena
+{
+public:
+  // construction
+  vbuf_expression_arena(uint32_t num_vals_);
+  ~vbuf_expression_arena();
+  static PFC_INLINE vbuf_expression_arena *active();
+  //--------------------------------------------------------------------------
+
+  // allocation
+  void *alloc(pfc::usize_t size_, uint32_t &buffer_idx_);
+  void release(uint32_t buffer_idx_);
+  PFC_INLINE pfc::usize_t min_alloc_size() const;
+  PFC_INLINE pfc::usize_t num_buffers() const;
+  //--------------------------------------------------------------------------
+
+private:
+  vbuf_expression_arena(const vbuf_expression_arena&); // not implemented
+  void operator=(const vbuf_expression_arena&); // not implemented
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // buffer
+  //==========================================================================
+  struct buffer
+  {
+    pfc::owner_data data;
+    pfc::usize_t size;
+  };
+  //--------------------------------------------------------------------------
+
+  static thread_local vbuf_expression_arena *s_active;
+  vbuf_expression_arena *m_prev_active;
+  const pfc::usize_t m_min_alloc_size;
+  const pfc::usize_t m_buffer_size;
+  pfc::array<buffer> m_buffers;
+  pfc::array<uint32_t> m_free_buffers;
+};
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_expression_data
+//============================================================================
+// Data owned by vertex buffer expression value. Per-vertex arrays are
+// allocated from the active arena and small data from the heap. Like
+// owner_data, copying transfers the ownership.
+struct vbuf_expression_data
+{
+  // construction
+  vbuf_expression_data();
+  vbuf_expression_data(const vbuf_expression_data&);
+  void operator=(const vbuf_expression_data&);
+  ~vbuf_expression_data();
+  void *alloc(pfc::usize_t size_);
+  void release();
+  //--------------------------------------------------------------------------
+
+  void *data;
+  pfc::owner_data heap_data;
+  vbuf_expression_arena *arena;
+  uint32_t arena_buffer_idx;
+};
 //----------------------------------------------------------------------------
 
 
@@ -55,7 +135,7 @@ struct vbuf_expression_value
 
   typedef pfc::pod_variant<pfc::float32_t*, int32_t*, const char*> value_t;
   value_t value;
-  pfc::owner_data data;
+  vbuf_expression_data data;
   uint32_t num_vals;
   uint8_t pinned_owner;
   uint8_t num_data_elems;
@@ -64,6 +144,22 @@ struct vbuf_expression_value
 };
 //----------------------------------------------------------------------------
 
+
+//============================================================================
+// vbuf_expression_stream
+//============================================================================
+// Named input of vertex format expressions with 32-bit float/int components
+// (num_vals_=1 for a uniform value shared by all vertices)
+struct vbuf_expression_stream
+{
+  const char *name;
+  const void *data;
+  uint32_t num_vals;
+  uint8_t num_elems;
+  bool is_int;
+};
+//----------------------------------------------------------------------------
+
 //============================================================================
 #include "vbuf_expr.inl"
 #endif
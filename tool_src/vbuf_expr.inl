@@ -6,6 +6,28 @@
 //============================================================================
 
 
+//============================================================================
+// vbuf_expression_arena
+//============================================================================
+PFC_INLINE vbuf_expression_arena *vbuf_expression_arena::active()
+{
+  return s_active;
+}
+//----
+
+PFC_INLINE pfc::usize_t vbuf_expression_arena::min_alloc_size() const
+{
+  return m_min_alloc_size;
+}
+//----
+
+PFC_INLINE pfc::usize_t vbuf_expression_arena::num_buffers() const
+{
+  return m_buffers.size();
+}
+//----------------------------------------------------------------------------
+
+
 //============================================================================
 // vbuf_expression_value
 //============================================================================
@@ -0,0 +1,1002 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "vbuf_kernel.h"
+#include "vbuf_simd.h"
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  #include "vbuf_expr_ops.inc"
+  typedef vbuf_kernel::instruction instruction;
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // kernel enums
+  //==========================================================================
+  enum e_kernel_op
+  {
+    // data movement
+    kop_load,
+    kop_store,
+    kop_copy,
+    kop_itof,
+    kop_ftoi,
+    kop_select,
+    // basic low-level operators
+    kop_add,
+    kop_sub,
+    kop_mul,
+    kop_div,
+    kop_mod,
+    kop_bw_not,
+    kop_bw_and,
+    kop_bw_or,
+    kop_bw_xor,
+    kop_bw_shl,
+    kop_bw_shr,
+    // logical and comparison operators
+    kop_and,
+    kop_or,
+    kop_not,
+    kop_eq,
+    kop_neq,
+    kop_lt,
+    kop_gt,
+    kop_lte,
+    kop_gte,
+    // basic component-wise functions
+    kop_min,
+    kop_max,
+    kop_sat,
+    kop_ssat,
+    kop_abs,
+    kop_clamp,
+    kop_floor,
+    kop_ceil,
+    kop_trunc,
+    kop_round,
+    kop_frc,
+    kop_fmod,
+    kop_sgn,
+    kop_sgn_zp,
+    kop_sqr,
+    kop_cubic,
+    kop_sqrt,
+    kop_sqrt_z,
+    kop_cbrt,
+    kop_rsqrt,
+    kop_rsqrt_z,
+    kop_rcbrt,
+    kop_rcbrt_z,
+    kop_exp,
+    kop_exp2,
+    kop_ln,
+    kop_log2,
+    kop_log10,
+    kop_pow,
+    // higher level functions
+    kop_lerp,
+    kop_smoothstep,
+    kop_smootherstep,
+  };
+  //----
+
+  enum e_kernel_type
+  {
+    ktype_float,
+    ktype_int,
+  };
+  //----
+
+  enum e_arg_rule
+  {
+    argrule_generic, // operands promoted to float if any is float
+    argrule_cmp,     // as generic but with int result
+    argrule_float,   // all operands must be float
+    argrule_int,     // all operands must be int
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // kernel_value
+  //==========================================================================
+  enum e_kernel_value_kind
+  {
+    kvkind_invalid,
+    kvkind_const,
+    kvkind_stream,
+    kvkind_reg,
+    kvkind_str,
+  };
+  //----
+
+  struct kernel_value
+  {
+    kernel_value()                                  {init(kvkind_invalid, ktype_float, 0);}
+    kernel_value(float64_t v_)                      {init(kvkind_const, ktype_float, 1); float32_t v=float32_t(v_); mem_copy(vals, &v, sizeof(v));}
+    kernel_value(int64_t v_)                        {init(kvkind_const, ktype_int, 1); vals[0]=uint32_t(int32_t(v_));}
+    kernel_value(const char *str_, usize_t str_len_) {init(kvkind_str, ktype_int, 0); str=str_; str_len=uint32_t(str_len_);}
+    void init(uint8_t kind_, uint8_t type_, uint8_t num_elems_)
+    {
+      kernel=0;
+      str=0;
+      str_len=0;
+      mem_zero(vals, sizeof(vals));
+      row=0;
+      kind=kind_;
+      type=type_;
+      num_elems=num_elems_;
+      elem_offset=0;
+    }
+    PFC_INLINE bool is_valid() const  {return num_elems && kind!=kvkind_str;}
+    //------------------------------------------------------------------------
+
+    vbuf_kernel *kernel;
+    const char *str;
+    uint32_t str_len;
+    uint32_t vals[4]; // bits of constant components
+    uint16_t row;     // first row of register value or stream index
+    uint8_t kind;
+    uint8_t type;
+    uint8_t num_elems;
+    uint8_t elem_offset;
+  };
+  typedef expression_parser<expression_parser_config<kernel_value> > kernel_parser_t;
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // conversion operators
+  //==========================================================================
+  struct kernel_op_copy {PFC_INLINE uint32_t operator()(uint32_t v_) const {return v_;}};
+  struct kernel_op_itof {PFC_INLINE float32_t operator()(int32_t v_) const {return float32_t(v_);}};
+  struct kernel_op_ftoi {PFC_INLINE int32_t operator()(float32_t v_) const {return int32_t(v_);}};
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // instruction execution
+  //==========================================================================
+  template<typename T>
+  PFC_INLINE const T *arg_row(const instruction &ins_, unsigned arg_idx_, unsigned elem_idx_, const uint32_t *rows_, unsigned row_size_)
+  {
+    unsigned row=ins_.args[arg_idx_]+(ins_.bcast_mask&(1<<arg_idx_)?0:elem_idx_);
+    return (const T*)(rows_+row*row_size_);
+  }
+  //----
+
+  template<typename TR, typename T, class Op>
+  void exec_1arg(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_)
+  {
+    for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+    {
+      const T *v=arg_row<T>(ins_, 0, ei, rows_, row_size_);
+      TR *res=(TR*)(rows_+(ins_.dst+ei)*row_size_);
+      for(unsigned i=0; i<n_; ++i)
+        res[i]=TR(op_(v[i]));
+    }
+  }
+  //----
+
+  template<typename TR, typename T, class Op>
+  void exec_2arg(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_)
+  {
+    for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+    {
+      const T *v0=arg_row<T>(ins_, 0, ei, rows_, row_size_);
+      const T *v1=arg_row<T>(ins_, 1, ei, rows_, row_size_);
+      TR *res=(TR*)(rows_+(ins_.dst+ei)*row_size_);
+      for(unsigned i=0; i<n_; ++i)
+        res[i]=TR(op_(v0[i], v1[i]));
+    }
+  }
+  //----
+
+  template<typename TR, typename T, class Op>
+  void exec_3arg(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_)
+  {
+    for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+    {
+      const T *v0=arg_row<T>(ins_, 0, ei, rows_, row_size_);
+      const T *v1=arg_row<T>(ins_, 1, ei, rows_, row_size_);
+      const T *v2=arg_row<T>(ins_, 2, ei, rows_, row_size_);
+      TR *res=(TR*)(rows_+(ins_.dst+ei)*row_size_);
+      for(unsigned i=0; i<n_; ++i)
+        res[i]=TR(op_(v0[i], v1[i], v2[i]));
+    }
+  }
+  //----
+
+  void exec_select(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_)
+  {
+    // select per value by the condition being non-zero (aux=condition type).
+    // float conditions ignore the sign bit so that -0.0 is false
+    const uint32_t *cond=arg_row<uint32_t>(ins_, 0, 0, rows_, row_size_);
+    const uint32_t cond_mask=ins_.aux==ktype_float?0x7fffffff:0xffffffff;
+    for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+    {
+      const uint32_t *v0=arg_row<uint32_t>(ins_, 1, ei, rows_, row_size_);
+      const uint32_t *v1=arg_row<uint32_t>(ins_, 2, ei, rows_, row_size_);
+      uint32_t *res=rows_+(ins_.dst+ei)*row_size_;
+      for(unsigned i=0; i<n_; ++i)
+        res[i]=cond[i]&cond_mask?v0[i]:v1[i];
+    }
+  }
+  //----
+
+  template<class Op> void exec_1arg_float(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_, vbuf_simd_funcs::f32_1arg_t simd_)
+  {
+    // execute float operator with the SIMD kernel if available
+    if(!simd_)
+    {
+      exec_1arg<float32_t, float32_t>(ins_, rows_, row_size_, n_, op_);
+      return;
+    }
+    for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+      simd_((float32_t*)(rows_+(ins_.dst+ei)*row_size_), arg_row<float32_t>(ins_, 0, ei, rows_, row_size_), n_);
+  }
+  //----
+
+  template<class Op> void exec_3arg_float(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_, vbuf_simd_funcs::f32_3arg_t simd_)
+  {
+    // execute float operator with the SIMD kernel if available
+    if(!simd_)
+    {
+      exec_3arg<float32_t, float32_t>(ins_, rows_, row_size_, n_, op_);
+      return;
+    }
+    for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+      simd_((float32_t*)(rows_+(ins_.dst+ei)*row_size_),
+            arg_row<float32_t>(ins_, 0, ei, rows_, row_size_),
+            arg_row<float32_t>(ins_, 1, ei, rows_, row_size_),
+            arg_row<float32_t>(ins_, 2, ei, rows_, row_size_), n_);
+  }
+  //----
+
+  template<class Op> void exec_1arg_generic(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_)
+  {
+    if(ins_.type==ktype_float)
+      exec_1arg<float32_t, float32_t>(ins_, rows_, row_size_, n_, op_);
+    else
+      exec_1arg<int32_t, int32_t>(ins_, rows_, row_size_, n_, op_);
+  }
+  //----
+
+  template<class Op> void exec_1arg_cmp(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_)
+  {
+    if(ins_.type==ktype_float)
+      exec_1arg<int32_t, float32_t>(ins_, rows_, row_size_, n_, op_);
+    else
+      exec_1arg<int32_t, int32_t>(ins_, rows_, row_size_, n_, op_);
+  }
+  //----
+
+  template<class Op> void exec_2arg_generic(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_, vbuf_simd_funcs::f32_2arg_t simd_f32_=0, vbuf_simd_funcs::i32_2arg_t simd_i32_=0)
+  {
+    // execute operator with the SIMD kernel of the type if available
+    if(ins_.type==ktype_float)
+    {
+      if(!simd_f32_)
+      {
+        exec_2arg<float32_t, float32_t>(ins_, rows_, row_size_, n_, op_);
+        return;
+      }
+      for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+        simd_f32_((float32_t*)(rows_+(ins_.dst+ei)*row_size_), arg_row<float32_t>(ins_, 0, ei, rows_, row_size_), arg_row<float32_t>(ins_, 1, ei, rows_, row_size_), n_);
+    }
+    else
+    {
+      if(!simd_i32_)
+      {
+        exec_2arg<int32_t, int32_t>(ins_, rows_, row_size_, n_, op_);
+        return;
+      }
+      for(unsigned ei=0; ei<ins_.num_elems; ++ei)
+        simd_i32_((int32_t*)(rows_+(ins_.dst+ei)*row_size_), arg_row<int32_t>(ins_, 0, ei, rows_, row_size_), arg_row<int32_t>(ins_, 1, ei, rows_, row_size_), n_);
+    }
+  }
+  //----
+
+  template<class Op> void exec_2arg_cmp(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_)
+  {
+    if(ins_.type==ktype_float)
+      exec_2arg<int32_t, float32_t>(ins_, rows_, row_size_, n_, op_);
+    else
+      exec_2arg<int32_t, int32_t>(ins_, rows_, row_size_, n_, op_);
+  }
+  //----
+
+  template<class Op> void exec_3arg_generic(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_, const Op &op_, vbuf_simd_funcs::f32_3arg_t simd_f32_=0)
+  {
+    if(ins_.type==ktype_float)
+      exec_3arg_float(ins_, rows_, row_size_, n_, op_, simd_f32_);
+    else
+      exec_3arg<int32_t, int32_t>(ins_, rows_, row_size_, n_, op_);
+  }
+  //----
+
+  void exec_instruction(const instruction &ins_, uint32_t *rows_, unsigned row_size_, unsigned n_)
+  {
+    // execute arithmetic instruction for n_ values of the rows
+    typedef float32_t f32;
+    typedef int32_t i32;
+    const vbuf_simd_funcs &simd=vbuf_simd();
+    switch(ins_.op)
+    {
+      // data movement
+      case kop_copy:         exec_1arg<uint32_t, uint32_t>(ins_, rows_, row_size_, n_, kernel_op_copy()); break;
+      case kop_itof:         exec_1arg<f32, i32>(ins_, rows_, row_size_, n_, kernel_op_itof()); break;
+      case kop_ftoi:         exec_1arg<i32, f32>(ins_, rows_, row_size_, n_, kernel_op_ftoi()); break;
+      case kop_select:       exec_select(ins_, rows_, row_size_, n_); break;
+      // basic low-level operators
+      case kop_add:          exec_2arg_generic(ins_, rows_, row_size_, n_, vbuf_op_add(), simd.add_f32, simd.add_i32); break;
+      case kop_sub:          exec_2arg_generic(ins_, rows_, row_size_, n_, vbuf_op_sub(), simd.sub_f32, simd.sub_i32); break;
+      case kop_mul:          exec_2arg_generic(ins_, rows_, row_size_, n_, vbuf_op_mul(), simd.mul_f32, simd.mul_i32); break;
+      case kop_div:          exec_2arg_generic(ins_, rows_, row_size_, n_, vbuf_op_div(), simd.div_f32); break;
+      case kop_mod:          exec_2arg<i32, i32>(ins_, rows_, row_size_, n_, vbuf_op_mod()); break;
+      case kop_bw_not:       exec_1arg<i32, i32>(ins_, rows_, row_size_, n_, vbuf_op_bw_not()); break;
+      case kop_bw_and:       exec_2arg<i32, i32>(ins_, rows_, row_size_, n_, vbuf_op_bw_and()); break;
+      case kop_bw_or:        exec_2arg<i32, i32>(ins_, rows_, row_size_, n_, vbuf_op_bw_or()); break;
+      case kop_bw_xor:       exec_2arg<i32, i32>(ins_, rows_, row_size_, n_, vbuf_op_bw_xor()); break;
+      case kop_bw_shl:       exec_2arg<i32, i32>(ins_, rows_, row_size_, n_, vbuf_op_bw_shl()); break;
+      case kop_bw_shr:       exec_2arg<i32, i32>(ins_, rows_, row_size_, n_, vbuf_op_bw_shr()); break;
+      // logical and comparison operators
+      case kop_and:          exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_and()); break;
+      case kop_or:           exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_or()); break;
+      case kop_not:          exec_1arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_not()); break;
+      case kop_eq:           exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_eq()); break;
+      case kop_neq:          exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_neq()); break;
+      case kop_lt:           exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_lt()); break;
+      case kop_gt:           exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_gt()); break;
+      case kop_lte:          exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_lte()); break;
+      case kop_gte:          exec_2arg_cmp(ins_, rows_, row_size_, n_, vbuf_op_gte()); break;
+      // basic component-wise functions
+      case kop_min:          exec_2arg_generic(ins_, rows_, row_size_, n_, vbuf_op_min(), simd.min_f32, simd.min_i32); break;
+      case kop_max:          exec_2arg_generic(ins_, rows_, row_size_, n_, vbuf_op_max(), simd.max_f32, simd.max_i32); break;
+      case kop_sat:          exec_1arg_generic(ins_, rows_, row_size_, n_, vbuf_op_sat()); break;
+      case kop_ssat:         exec_1arg_generic(ins_, rows_, row_size_, n_, vbuf_op_ssat()); break;
+      case kop_abs:          exec_1arg_generic(ins_, rows_, row_size_, n_, vbuf_op_abs()); break;
+      case kop_clamp:        exec_3arg_generic(ins_, rows_, row_size_, n_, vbuf_op_clamp(), simd.clamp_f32); break;
+      case kop_floor:        exec_1arg_float(ins_, rows_, row_size_, n_, vbuf_op_floor(), simd.floor_f32); break;
+      case kop_ceil:         exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_ceil()); break;
+      case kop_trunc:        exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_trunc()); break;
+      case kop_round:        exec_1arg_float(ins_, rows_, row_size_, n_, vbuf_op_round(), simd.round_f32); break;
+      case kop_frc:          exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_frc()); break;
+      case kop_fmod:         exec_2arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_fmod()); break;
+      case kop_sgn:          exec_1arg_generic(ins_, rows_, row_size_, n_, vbuf_op_sgn()); break;
+      case kop_sgn_zp:       exec_1arg_generic(ins_, rows_, row_size_, n_, vbuf_op_sgn_zp()); break;
+      case kop_sqr:          exec_1arg_generic(ins_, rows_, row_size_, n_, vbuf_op_sqr()); break;
+      case kop_cubic:        exec_1arg_generic(ins_, rows_, row_size_, n_, vbuf_op_cubic()); break;
+      case kop_sqrt:         exec_1arg_float(ins_, rows_, row_size_, n_, vbuf_op_sqrt(), simd.sqrt_f32); break;
+      case kop_sqrt_z:       exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_sqrt_z()); break;
+      case kop_cbrt:         exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_cbrt()); break;
+      case kop_rsqrt:        exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_rsqrt()); break;
+      case kop_rsqrt_z:      exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_rsqrt_z()); break;
+      case kop_rcbrt:        exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_rcbrt()); break;
+      case kop_rcbrt_z:      exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_rcbrt_z()); break;
+      case kop_exp:          exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_exp()); break;
+      case kop_exp2:         exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_exp2()); break;
+      case kop_ln:           exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_ln()); break;
+      case kop_log2:         exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_log2()); break;
+      case kop_log10:        exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_log10()); break;
+      case kop_pow:          exec_2arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_pow()); break;
+      // higher level functions
+      case kop_lerp:         exec_3arg_float(ins_, rows_, row_size_, n_, vbuf_op_lerp(), simd.lerp_f32); break;
+      case kop_smoothstep:   exec_1arg_float(ins_, rows_, row_size_, n_, vbuf_op_smoothstep(), simd.smoothstep_f32); break;
+      case kop_smootherstep: exec_1arg<f32, f32>(ins_, rows_, row_size_, n_, vbuf_op_smootherstep()); break;
+      default: PFC_ERROR_NOT_IMPL();
+    }
+  }
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // exec_store
+  //==========================================================================
+  template<typename T, typename TS>
+  void exec_store_impl(const TS *src_, uint8_t *vbuf_, unsigned vtx_size_, unsigned n_)
+  {
+    for(unsigned i=0; i<n_; ++i)
+    {
+      T v=T(src_[i]);
+      mem_copy(vbuf_, &v, sizeof(T));
+      vbuf_+=vtx_size_;
+    }
+  }
+  //----
+
+  template<typename TS>
+  void exec_store(e_vtx_element_type type_, const TS *src_, uint8_t *vbuf_, unsigned vtx_size_, unsigned n_)
+  {
+    switch(type_)
+    {
+      case vtxelemtype_int8:    exec_store_impl<int8_t>(src_, vbuf_, vtx_size_, n_); break;
+      case vtxelemtype_uint8:   exec_store_impl<uint8_t>(src_, vbuf_, vtx_size_, n_); break;
+      case vtxelemtype_int16:   exec_store_impl<int16_t>(src_, vbuf_, vtx_size_, n_); break;
+      case vtxelemtype_uint16:  exec_store_impl<uint16_t>(src_, vbuf_, vtx_size_, n_); break;
+      case vtxelemtype_int32:   exec_store_impl<int32_t>(src_, vbuf_, vtx_size_, n_); break;
+      case vtxelemtype_uint32:  exec_store_impl<uint32_t>(src_, vbuf_, vtx_size_, n_); break;
+      case vtxelemtype_float16: exec_store_impl<vtx_float16>(src_, vbuf_, vtx_size_, n_); break;
+      case vtxelemtype_float32: exec_store_impl<float32_t>(src_, vbuf_, vtx_size_, n_); break;
+      default: PFC_ERROR_NOT_IMPL();
+    }
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_kernel::compiler
+//============================================================================
+struct vbuf_kernel::compiler
+{
+  typedef kernel_parser_t::var_t var_t;
+  typedef kernel_parser_t::var_stack_t var_stack_t;
+  //--------------------------------------------------------------------------
+
+  // parser setup and element output
+  static void init_parser(kernel_parser_t&, vbuf_kernel&, const vbuf_expression_stream*, usize_t num_streams_);
+  static bool emit_store(vbuf_kernel&, const var_t&, e_vtx_element_type, unsigned offset_);
+  //--------------------------------------------------------------------------
+
+  // code generation
+  static uint16_t alloc_rows(vbuf_kernel&, unsigned num_rows_);
+  static uint16_t operand_row(vbuf_kernel&, const var_t&);
+  static var_t evaluate(instruction&, const var_t *args_, unsigned num_args_, uint8_t res_type_);
+  static var_t convert(const var_t&, uint8_t type_);
+  static bool get_args(int num_args_, unsigned num_expected_args_, var_stack_t&, var_t *args_);
+  //--------------------------------------------------------------------------
+
+  // operators and functions
+  static void op_dot(int num_args_, var_stack_t&);
+  static void op_ternary(int num_args_, var_stack_t&);
+  template<unsigned Op, unsigned Rule, unsigned NumArgs> static void op_eval(int num_args_, var_stack_t&);
+  template<unsigned Type, bool IsVec> static void func_conv(int num_args_, var_stack_t&);
+};
+//----------------------------------------------------------------------------
+
+void vbuf_kernel::compiler::init_parser(kernel_parser_t &parser_, vbuf_kernel &kernel_, const vbuf_expression_stream *streams_, usize_t num_streams_)
+{
+  // add basic low-level operators
+  parser_.set_op(exprop_dot, &op_dot);
+  parser_.set_op(exprop_ternary, &op_ternary);
+  parser_.set_op(exprop_add, &op_eval<kop_add, argrule_generic, 2>);
+  parser_.set_op(exprop_sub, &op_eval<kop_sub, argrule_generic, 2>);
+  parser_.set_op(exprop_mul, &op_eval<kop_mul, argrule_generic, 2>);
+  parser_.set_op(exprop_div, &op_eval<kop_div, argrule_generic, 2>);
+  parser_.set_op(exprop_mod, &op_eval<kop_mod, argrule_int, 2>);
+  parser_.set_op(exprop_bw_not, &op_eval<kop_bw_not, argrule_int, 1>);
+  parser_.set_op(exprop_bw_and, &op_eval<kop_bw_and, argrule_int, 2>);
+  parser_.set_op(exprop_bw_or,  &op_eval<kop_bw_or,  argrule_int, 2>);
+  parser_.set_op(exprop_bw_xor, &op_eval<kop_bw_xor, argrule_int, 2>);
+  parser_.set_op(exprop_bw_shl, &op_eval<kop_bw_shl, argrule_int, 2>);
+  parser_.set_op(exprop_bw_shr, &op_eval<kop_bw_shr, argrule_int, 2>);
+
+  // add logical and comparison operators
+  parser_.set_op(exprop_and, &op_eval<kop_and, argrule_cmp, 2>);
+  parser_.set_op(exprop_or,  &op_eval<kop_or,  argrule_cmp, 2>);
+  parser_.set_op(exprop_not, &op_eval<kop_not, argrule_cmp, 1>);
+  parser_.set_op(exprop_eq,  &op_eval<kop_eq,  argrule_cmp, 2>);
+  parser_.set_op(exprop_neq, &op_eval<kop_neq, argrule_cmp, 2>);
+  parser_.set_op(exprop_lt,  &op_eval<kop_lt,  argrule_cmp, 2>);
+  parser_.set_op(exprop_gt,  &op_eval<kop_gt,  argrule_cmp, 2>);
+  parser_.set_op(exprop_lte, &op_eval<kop_lte, argrule_cmp, 2>);
+  parser_.set_op(exprop_gte, &op_eval<kop_gte, argrule_cmp, 2>);
+
+  // add data conversion functions
+  parser_.set_func("int",   &func_conv<ktype_int, false>);
+  parser_.set_func("float", &func_conv<ktype_float, false>);
+  parser_.set_func("veci",  &func_conv<ktype_int, true>);
+  parser_.set_func("vecf",  &func_conv<ktype_float, true>);
+
+  // add basic component-wise functions
+  parser_.set_func("min",     &op_eval<kop_min,     argrule_generic, 2>);
+  parser_.set_func("max",     &op_eval<kop_max,     argrule_generic, 2>);
+  parser_.set_func("sat",     &op_eval<kop_sat,     argrule_generic, 1>);
+  parser_.set_func("ssat",    &op_eval<kop_ssat,    argrule_generic, 1>);
+  parser_.set_func("abs",     &op_eval<kop_abs,     argrule_generic, 1>);
+  parser_.set_func("clamp",   &op_eval<kop_clamp,   argrule_generic, 3>);
+  parser_.set_func("floor",   &op_eval<kop_floor,   argrule_float, 1>);
+  parser_.set_func("ceil",    &op_eval<kop_ceil,    argrule_float, 1>);
+  parser_.set_func("trunc",   &op_eval<kop_trunc,   argrule_float, 1>);
+  parser_.set_func("round",   &op_eval<kop_round,   argrule_float, 1>);
+  parser_.set_func("frc",     &op_eval<kop_frc,     argrule_float, 1>);
+  parser_.set_func("mod",     &op_eval<kop_fmod,    argrule_float, 2>);
+  parser_.set_func("sgn",     &op_eval<kop_sgn,     argrule_generic, 1>);
+  parser_.set_func("sgn_zp",  &op_eval<kop_sgn_zp,  argrule_generic, 1>);
+  parser_.set_func("sqr",     &op_eval<kop_sqr,     argrule_generic, 1>);
+  parser_.set_func("cubic",   &op_eval<kop_cubic,   argrule_generic, 1>);
+  parser_.set_func("sqrt",    &op_eval<kop_sqrt,    argrule_float, 1>);
+  parser_.set_func("sqrt_z",  &op_eval<kop_sqrt_z,  argrule_float, 1>);
+  parser_.set_func("cbrt",    &op_eval<kop_cbrt,    argrule_float, 1>);
+  parser_.set_func("rsqrt",   &op_eval<kop_rsqrt,   argrule_float, 1>);
+  parser_.set_func("rsqrt_z", &op_eval<kop_rsqrt_z, argrule_float, 1>);
+  parser_.set_func("rcbrt",   &op_eval<kop_rcbrt,   argrule_float, 1>);
+  parser_.set_func("rcbrt_z", &op_eval<kop_rcbrt_z, argrule_float, 1>);
+  parser_.set_func("exp",     &op_eval<kop_exp,     argrule_float, 1>);
+  parser_.set_func("exp2",    &op_eval<kop_exp2,    argrule_float, 1>);
+  parser_.set_func("ln",      &op_eval<kop_ln,      argrule_float, 1>);
+  parser_.set_func("log2",    &op_eval<kop_log2,    argrule_float, 1>);
+  parser_.set_func("log10",   &op_eval<kop_log10,   argrule_float, 1>);
+  parser_.set_func("pow",     &op_eval<kop_pow,     argrule_float, 2>);
+
+  // add higher level composite functions
+  parser_.set_func("lerp",         &op_eval<kop_lerp,         argrule_float, 3>);
+  parser_.set_func("smoothstep",   &op_eval<kop_smoothstep,   argrule_float, 1>);
+  parser_.set_func("smootherstep", &op_eval<kop_smootherstep, argrule_float, 1>);
+
+  // setup input streams. uniform streams are compiled as constants
+  for(usize_t si=0; si<num_streams_; ++si)
+  {
+    const vbuf_expression_stream &s=streams_[si];
+    var_t v;
+    v.type=s.is_int?ktype_int:ktype_float;
+    v.num_elems=s.num_elems;
+    if(s.num_vals>1)
+    {
+      stream &ks=kernel_.m_streams.push_back();
+      ks.data=(const uint32_t*)s.data;
+      ks.src_idx=uint32_t(si);
+      ks.num_elems=s.num_elems;
+      ks.row=0xffff;
+      v.kind=kvkind_stream;
+      v.kernel=&kernel_;
+      v.row=uint16_t(kernel_.m_streams.size()-1);
+    }
+    else
+    {
+      v.kind=kvkind_const;
+      mem_copy(v.vals, s.data, s.num_elems*sizeof(uint32_t));
+    }
+    parser_.set_var(s.name, v);
+  }
+}
+//----
+
+bool vbuf_kernel::compiler::emit_store(vbuf_kernel &kernel_, const var_t &v_, e_vtx_element_type type_, unsigned offset_)
+{
+  // store the first component of the value to the vertex element
+  if(!v_.is_valid())
+    return false;
+  instruction ins;
+  mem_zero(&ins, sizeof(ins));
+  ins.op=kop_store;
+  ins.type=v_.type;
+  ins.num_elems=1;
+  ins.args[0]=operand_row(kernel_, v_);
+  ins.dst=uint16_t(offset_);
+  ins.aux=type_;
+  kernel_.m_program.push_back(ins);
+  return true;
+}
+//----
+
+uint16_t vbuf_kernel::compiler::alloc_rows(vbuf_kernel &kernel_, unsigned num_rows_)
+{
+  // rows past the 16-bit range fail the compilation in compile()
+  uint16_t row=uint16_t(kernel_.m_num_rows);
+  kernel_.m_num_rows+=num_rows_;
+  return row;
+}
+//----
+
+uint16_t vbuf_kernel::compiler::operand_row(vbuf_kernel &kernel_, const var_t &v_)
+{
+  switch(v_.kind)
+  {
+    case kvkind_const:
+    {
+      // share rows of scalar constants and allocate vector constants to consecutive rows
+      if(v_.num_elems==1)
+        for(const const_row &c:kernel_.m_consts)
+          if(c.value==v_.vals[0])
+            return c.row;
+      uint16_t row=alloc_rows(kernel_, v_.num_elems);
+      for(unsigned ei=0; ei<v_.num_elems; ++ei)
+      {
+        const_row &c=kernel_.m_consts.push_back();
+        c.row=uint16_t(row+ei);
+        c.value=v_.vals[ei];
+      }
+      return row;
+    }
+
+    case kvkind_stream:
+    {
+      // load the stream to rows at first use
+      stream &s=kernel_.m_streams[v_.row];
+      if(s.row==0xffff)
+      {
+        s.row=alloc_rows(kernel_, s.num_elems);
+        instruction ins;
+        mem_zero(&ins, sizeof(ins));
+        ins.op=kop_load;
+        ins.num_elems=s.num_elems;
+        ins.dst=s.row;
+        ins.aux=v_.row;
+        kernel_.m_program.push_back(ins);
+      }
+      return uint16_t(s.row+v_.elem_offset);
+    }
+
+    case kvkind_reg: return v_.row;
+  }
+  PFC_ERROR_NOT_IMPL();
+  return 0;
+}
+//----
+
+vbuf_kernel::compiler::var_t vbuf_kernel::compiler::evaluate(instruction &ins_, const var_t *args_, unsigned num_args_, uint8_t res_type_)
+{
+  // find kernel from non-constant arguments
+  vbuf_kernel *kernel=0;
+  for(unsigned ai=0; ai<num_args_; ++ai)
+    if(args_[ai].kind!=kvkind_const)
+      kernel=args_[ai].kernel;
+  var_t res;
+  res.type=res_type_;
+  res.num_elems=ins_.num_elems;
+  if(!kernel)
+  {
+    // fold constant expression by executing the instruction for a single value
+    uint32_t rows[16]={0};
+    for(unsigned ai=0; ai<num_args_; ++ai)
+    {
+      ins_.args[ai]=uint16_t(ai*4);
+      mem_copy(rows+ai*4, args_[ai].vals, sizeof(args_[ai].vals));
+    }
+    ins_.dst=12;
+    exec_instruction(ins_, rows, 1, 1);
+    res.kind=kvkind_const;
+    mem_copy(res.vals, rows+12, sizeof(res.vals));
+    return res;
+  }
+
+  // emit the instruction
+  for(unsigned ai=0; ai<num_args_; ++ai)
+    ins_.args[ai]=operand_row(*kernel, args_[ai]);
+  ins_.dst=alloc_rows(*kernel, ins_.num_elems);
+  kernel->m_program.push_back(ins_);
+  res.kind=kvkind_reg;
+  res.kernel=kernel;
+  res.row=ins_.dst;
+  return res;
+}
+//----
+
+vbuf_kernel::compiler::var_t vbuf_kernel::compiler::convert(const var_t &v_, uint8_t type_)
+{
+  if(v_.type==type_)
+    return v_;
+  instruction ins;
+  mem_zero(&ins, sizeof(ins));
+  ins.op=type_==ktype_float?kop_itof:kop_ftoi;
+  ins.type=v_.type;
+  ins.num_elems=v_.num_elems;
+  return evaluate(ins, &v_, 1, type_);
+}
+//----
+
+bool vbuf_kernel::compiler::get_args(int num_args_, unsigned num_expected_args_, var_stack_t &vstack_, var_t *args_)
+{
+  if(num_args_==int(num_expected_args_))
+  {
+    // check if any of the args is invalid
+    usize_t sarg_idx=vstack_.size()-num_expected_args_;
+    const var_t *svs=vstack_.data()+sarg_idx;
+    for(unsigned i=0; i<num_expected_args_; ++i)
+      if(!svs[i].is_valid())
+        goto invalid_arg;
+
+    // get requested number of arguments
+    vstack_.get(sarg_idx, args_, num_expected_args_);
+    vstack_.remove_back(num_args_);
+    return true;
+  }
+
+  // replace args with invalid arg
+  invalid_arg:
+  vstack_.remove_back(num_args_);
+  vstack_.push_back();
+  return false;
+}
+//----
+
+void vbuf_kernel::compiler::op_dot(int num_args_, var_stack_t &vstack_)
+{
+  // get the top two values from the variable stack
+  var_t sv1=vstack_.back();
+  vstack_.pop_back();
+  var_t &sv0=vstack_.back();
+
+  // check for single component accessor
+  if(sv0.is_valid() && sv1.kind==kvkind_str && sv1.str_len==1)
+  {
+    unsigned comp_idx=4;
+    switch(*sv1.str)
+    {
+      case 'x': case 'r': comp_idx=0; break;
+      case 'y': case 'g': comp_idx=1; break;
+      case 'z': case 'b': comp_idx=2; break;
+      case 'w': case 'a': comp_idx=3; break;
+    }
+    if(comp_idx<sv0.num_elems)
+    {
+      switch(sv0.kind)
+      {
+        case kvkind_const:  sv0.vals[0]=sv0.vals[comp_idx]; break;
+        case kvkind_stream: sv0.elem_offset+=uint8_t(comp_idx); break;
+        case kvkind_reg:    sv0.row+=uint16_t(comp_idx); break;
+      }
+      sv0.num_elems=1;
+      return;
+    }
+  }
+
+  // reset the value to invalid
+  sv0=var_t();
+}
+//----
+
+void vbuf_kernel::compiler::op_ternary(int num_args_, var_stack_t &vstack_)
+{
+  // get the top three values from the variable stack
+  var_t sv[3];
+  if(!get_args(num_args_, 3, vstack_, sv))
+    return;
+
+  // select the value at compile time for constant condition
+  if(sv[0].kind==kvkind_const)
+  {
+    vstack_.push_back(sv[0].vals[0]&(sv[0].type==ktype_float?0x7fffffff:0xffffffff)?sv[1]:sv[2]);
+    return;
+  }
+
+  // check for proper values and convert mixed types to float
+  if(sv[1].num_elems!=1 && sv[2].num_elems!=1 && sv[1].num_elems!=sv[2].num_elems)
+  {
+    vstack_.push_back();
+    return;
+  }
+  if(sv[1].type!=sv[2].type)
+  {
+    sv[1]=convert(sv[1], ktype_float);
+    sv[2]=convert(sv[2], ktype_float);
+  }
+
+  // select per value
+  instruction ins;
+  mem_zero(&ins, sizeof(ins));
+  ins.op=kop_select;
+  ins.type=sv[1].type;
+  ins.aux=sv[0].type;
+  ins.num_elems=max(sv[1].num_elems, sv[2].num_elems);
+  ins.bcast_mask=uint8_t(1|(sv[1].num_elems==1?2:0)|(sv[2].num_elems==1?4:0));
+  vstack_.push_back(evaluate(ins, sv, 3, sv[1].type));
+}
+//----
+
+template<unsigned Op, unsigned Rule, unsigned NumArgs>
+void vbuf_kernel::compiler::op_eval(int num_args_, var_stack_t &vstack_)
+{
+  // get the arguments and check for proper element counts
+  var_t sv[NumArgs];
+  if(!get_args(num_args_, NumArgs, vstack_, sv))
+    return;
+  uint8_t num_elems=1;
+  bool has_float=false, has_int=false;
+  for(unsigned ai=0; ai<NumArgs; ++ai)
+  {
+    if(sv[ai].num_elems!=1 && num_elems!=1 && sv[ai].num_elems!=num_elems)
+    {
+      vstack_.push_back();
+      return;
+    }
+    num_elems=max(num_elems, sv[ai].num_elems);
+    if(sv[ai].type==ktype_float)
+      has_float=true;
+    else
+      has_int=true;
+  }
+
+  // resolve operand and result types
+  uint8_t op_type=has_float?ktype_float:ktype_int, res_type=op_type;
+  if(   (Rule==argrule_float && has_int)
+     || (Rule==argrule_int && has_float))
+  {
+    vstack_.push_back();
+    return;
+  }
+  if(Rule==argrule_cmp)
+    res_type=ktype_int;
+  for(unsigned ai=0; ai<NumArgs; ++ai)
+    sv[ai]=convert(sv[ai], op_type);
+
+  // emit or fold the instruction
+  instruction ins;
+  mem_zero(&ins, sizeof(ins));
+  ins.op=Op;
+  ins.type=op_type;
+  ins.num_elems=num_elems;
+  for(unsigned ai=0; ai<NumArgs; ++ai)
+    if(sv[ai].num_elems==1)
+      ins.bcast_mask|=1<<ai;
+  vstack_.push_back(evaluate(ins, sv, NumArgs, res_type));
+}
+//----
+
+template<unsigned Type, bool IsVec>
+void vbuf_kernel::compiler::func_conv(int num_args_, var_stack_t &vstack_)
+{
+  // get the arguments (single argument for scalars, max 4 non-empty arguments for vectors)
+  var_t sv[4];
+  if(num_args_<1 || num_args_>(IsVec?4:1))
+  {
+    vstack_.remove_back(num_args_);
+    vstack_.push_back();
+    return;
+  }
+  if(!get_args(num_args_, num_args_, vstack_, sv))
+    return;
+
+  // convert scalar or single vector argument
+  if(!IsVec || num_args_==1)
+  {
+    if(!IsVec)
+      sv[0].num_elems=1;
+    vstack_.push_back(convert(sv[0], Type));
+    return;
+  }
+
+  // check the vector size
+  unsigned num_elems=0;
+  bool is_const=true;
+  for(int ai=0; ai<num_args_; ++ai)
+  {
+    sv[ai]=convert(sv[ai], Type);
+    num_elems+=sv[ai].num_elems;
+    is_const&=sv[ai].kind==kvkind_const;
+  }
+  if(num_elems>4)
+  {
+    vstack_.push_back();
+    return;
+  }
+
+  // concatenate argument components
+  var_t &res=vstack_.push_back();
+  res.type=Type;
+  res.num_elems=uint8_t(num_elems);
+  if(is_const)
+  {
+    res.kind=kvkind_const;
+    unsigned ei=0;
+    for(int ai=0; ai<num_args_; ++ai)
+      for(unsigned aei=0; aei<sv[ai].num_elems; ++aei)
+        res.vals[ei++]=sv[ai].vals[aei];
+    return;
+  }
+  vbuf_kernel *kernel=0;
+  for(int ai=0; ai<num_args_; ++ai)
+    if(sv[ai].kind!=kvkind_const)
+      kernel=sv[ai].kernel;
+  res.kind=kvkind_reg;
+  res.kernel=kernel;
+  res.row=alloc_rows(*kernel, num_elems);
+  uint16_t row=res.row;
+  for(int ai=0; ai<num_args_; ++ai)
+  {
+    instruction ins;
+    mem_zero(&ins, sizeof(ins));
+    ins.op=kop_copy;
+    ins.type=uint8_t(Type);
+    ins.num_elems=sv[ai].num_elems;
+    ins.dst=row;
+    ins.args[0]=operand_row(*kernel, sv[ai]);
+    kernel->m_program.push_back(ins);
+    row+=sv[ai].num_elems;
+  }
+}
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_kernel
+//============================================================================
+vbuf_kernel::vbuf_kernel()
+{
+  m_num_rows=0;
+  m_vtx_size=0;
+}
+//----
+
+bool vbuf_kernel::compile(const vtx_format &vfmt_, const vbuf_expression_stream *streams_, usize_t num_streams_)
+{
+  // compile vertex element expressions to a single program
+  m_program.clear();
+  m_consts.clear();
+  m_streams.clear();
+  m_num_rows=0;
+  m_vtx_size=0;
+  kernel_parser_t parser;
+  compiler::init_parser(parser, *this, streams_, num_streams_);
+  for(const vtx_element &elem_: vfmt_.elements)
+  {
+    kernel_value v=parser.evaluate(elem_.expr.c_str());
+    if(!compiler::emit_store(*this, v, elem_.type, m_vtx_size))
+      return false;
+    m_vtx_size+=vtx_element_type_size(elem_.type);
+  }
+
+  // fall back to expression evaluation if the rows exceed the 16-bit row indices
+  if(m_num_rows>max_rows)
+    return false;
+  return true;
+}
+//----
+
+void vbuf_kernel::set_stream_data(const vbuf_expression_stream *streams_, usize_t num_streams_)
+{
+  // rebind per-vertex stream data (streams in the same order as for compile())
+  for(stream &s:m_streams)
+  {
+    PFC_ASSERT(s.src_idx<num_streams_);
+    s.data=(const uint32_t*)streams_[s.src_idx].data;
+  }
+}
+//----
+
+void vbuf_kernel::execute(void *scratch_, uint8_t *vbuf_, uint32_t first_vtx_, uint32_t num_vtx_) const
+{
+  // initialize constant rows
+  uint32_t *rows=(uint32_t*)scratch_;
+  for(const const_row &c:m_consts)
+  {
+    uint32_t *row=rows+c.row*block_size;
+    for(unsigned i=0; i<block_size; ++i)
+      row[i]=c.value;
+  }
+
+  // run the program for blocks of vertices
+  for(uint32_t block_start=0; block_start<num_vtx_; block_start+=block_size)
+  {
+    unsigned n=min<uint32_t>(block_size, num_vtx_-block_start);
+    uint8_t *block_vbuf=vbuf_+usize_t(block_start)*m_vtx_size;
+    for(const instruction &ins:m_program)
+      switch(ins.op)
+      {
+        case kop_load:
+        {
+          // transpose interleaved stream data to rows
+          const stream &s=m_streams[ins.aux];
+          const uint32_t *src=s.data+usize_t(first_vtx_+block_start)*s.num_elems;
+          for(unsigned ei=0; ei<s.num_elems; ++ei)
+          {
+            uint32_t *row=rows+(ins.dst+ei)*block_size;
+            for(unsigned i=0; i<n; ++i)
+              row[i]=src[i*s.num_elems+ei];
+          }
+        } break;
+
+        case kop_store:
+        {
+          // write vertex element for the block
+          const uint32_t *row=rows+ins.args[0]*block_size;
+          if(ins.type==ktype_float)
+            exec_store(e_vtx_element_type(ins.aux), (const float32_t*)row, block_vbuf+ins.dst, m_vtx_size, n);
+          else
+            exec_store(e_vtx_element_type(ins.aux), (const int32_t*)row, block_vbuf+ins.dst, m_vtx_size, n);
+        } break;
+
+        default: exec_instruction(ins, rows, block_size, n);
+      }
+  }
+}
+//----------------------------------------------------------------------------
@@ -0,0 +1,106 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_VBUF_KERNEL_H
+#define PFC_MESHLETE_VBUF_KERNEL_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "geo_setup.h"
+#include "vbuf_expr.h"
+
+// new
+class vbuf_kernel;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_kernel
+//============================================================================
+// Vertex format compiled to a program evaluating all element expressions of
+// the format for blocks of vertices at once. Intermediate values live in
+// small per-block SoA register rows instead of full vertex array temporaries
+// and the elements are written directly to the interleaved vertex buffer.
+class vbuf_kernel
+{
+public:
+  // construction
+  vbuf_kernel();
+  bool compile(const pfc::vtx_format&, const vbuf_expression_stream*, pfc::usize_t num_streams_);
+  //--------------------------------------------------------------------------
+
+  // execution
+  void set_stream_data(const vbuf_expression_stream*, pfc::usize_t num_streams_);
+  PFC_INLINE pfc::usize_t scratch_size() const;
+  void execute(void *scratch_, uint8_t *vbuf_, uint32_t first_vtx_, uint32_t num_vtx_) const;
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // instruction
+  //==========================================================================
+  // load: aux=stream index, store: dst=vertex byte offset, aux=element type,
+  // select: aux=condition type
+  struct instruction
+  {
+    uint8_t op;
+    uint8_t type;
+    uint8_t num_elems;
+    uint8_t bcast_mask;
+    uint16_t dst;
+    uint16_t args[3];
+    uint32_t aux;
+  };
+  //--------------------------------------------------------------------------
+
+private:
+  enum {block_size=64};
+  enum {max_rows=65536};  // rows are addressed with 16-bit indices
+  struct compiler;
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // const_row
+  //==========================================================================
+  struct const_row
+  {
+    uint16_t row;
+    uint32_t value;
+  };
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // stream
+  //==========================================================================
+  struct stream
+  {
+    const uint32_t *data;
+    uint32_t src_idx;  // index of the source stream the kernel was compiled with
+    uint8_t num_elems;
+    uint16_t row;
+  };
+  //--------------------------------------------------------------------------
+
+  pfc::array<instruction> m_program;
+  pfc::array<const_row> m_consts;
+  pfc::array<stream> m_streams;
+  unsigned m_num_rows;
+  unsigned m_vtx_size;
+};
+//----------------------------------------------------------------------------
+
+PFC_INLINE pfc::usize_t vbuf_kernel::scratch_size() const
+{
+  return m_num_rows*block_size*sizeof(uint32_t);
+}
+//----------------------------------------------------------------------------
+
+//============================================================================
+#endif
@@ -0,0 +1,269 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#include "vbuf_simd.h"
+#include "sxp_src/core/math/math.h"
+#if PFC_BUILDOP_VBUF_SIMD==1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define VBUF_SIMD_AVX2
+#else
+#define VBUF_SIMD_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+using namespace pfc;
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// locals
+//============================================================================
+namespace
+{
+  #include "vbuf_expr_ops.inc"
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // kernel loop generators
+  //==========================================================================
+  // SIMD loop for full vectors followed by the scalar operator for the tail
+  #define VBUF_SIMD_F32_1ARG(func__, target__, vec_t__, width__, load__, store__, simd_expr__, op__)\
+    target__ void func__(float32_t *res_, const float32_t *v_, usize_t n_)\
+    {\
+      usize_t i=0;\
+      for(; i+width__<=n_; i+=width__)\
+      {\
+        vec_t__ v=load__(v_+i);\
+        store__(res_+i, simd_expr__);\
+      }\
+      for(; i<n_; ++i)\
+        res_[i]=op__()(v_[i]);\
+    }
+  #define VBUF_SIMD_F32_2ARG(func__, target__, vec_t__, width__, load__, store__, simd_expr__, op__)\
+    target__ void func__(float32_t *res_, const float32_t *v0_, const float32_t *v1_, usize_t n_)\
+    {\
+      usize_t i=0;\
+      for(; i+width__<=n_; i+=width__)\
+      {\
+        vec_t__ v0=load__(v0_+i), v1=load__(v1_+i);\
+        store__(res_+i, simd_expr__);\
+      }\
+      for(; i<n_; ++i)\
+        res_[i]=op__()(v0_[i], v1_[i]);\
+    }
+  #define VBUF_SIMD_F32_3ARG(func__, target__, vec_t__, width__, load__, store__, simd_expr__, op__)\
+    target__ void func__(float32_t *res_, const float32_t *v0_, const float32_t *v1_, const float32_t *v2_, usize_t n_)\
+    {\
+      usize_t i=0;\
+      for(; i+width__<=n_; i+=width__)\
+      {\
+        vec_t__ v0=load__(v0_+i), v1=load__(v1_+i), v2=load__(v2_+i);\
+        store__(res_+i, simd_expr__);\
+      }\
+      for(; i<n_; ++i)\
+        res_[i]=op__()(v0_[i], v1_[i], v2_[i]);\
+    }
+  #define VBUF_SIMD_I32_2ARG(func__, target__, vec_t__, width__, load__, store__, simd_expr__, op__)\
+    target__ void func__(int32_t *res_, const int32_t *v0_, const int32_t *v1_, usize_t n_)\
+    {\
+      usize_t i=0;\
+      for(; i+width__<=n_; i+=width__)\
+      {\
+        vec_t__ v0=load__((const vec_t__*)(v0_+i)), v1=load__((const vec_t__*)(v1_+i));\
+        store__((vec_t__*)(res_+i), simd_expr__);\
+      }\
+      for(; i<n_; ++i)\
+        res_[i]=op__()(v0_[i], v1_[i]);\
+    }
+  //--------------------------------------------------------------------------
+
+#if PFC_BUILDOP_VBUF_SIMD==1
+  //==========================================================================
+  // SSE2 kernels
+  //==========================================================================
+  PFC_INLINE __m128 sse2_select(__m128 mask_, __m128 v0_, __m128 v1_)
+  {
+    return _mm_or_ps(_mm_and_ps(mask_, v0_), _mm_andnot_ps(mask_, v1_));
+  }
+  //----
+
+  PFC_INLINE __m128i sse2_select(__m128i mask_, __m128i v0_, __m128i v1_)
+  {
+    return _mm_or_si128(_mm_and_si128(mask_, v0_), _mm_andnot_si128(mask_, v1_));
+  }
+  //----
+
+  PFC_INLINE __m128 sse2_trunc(__m128 v_)
+  {
+    // truncate through int conversion preserving the sign (values >=2^23 are integral)
+    const __m128 sign_mask=_mm_set1_ps(-0.0f);
+    __m128 t=_mm_or_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(v_)), _mm_and_ps(v_, sign_mask));
+    return sse2_select(_mm_cmplt_ps(_mm_andnot_ps(sign_mask, v_), _mm_set1_ps(8388608.0f)), t, v_);
+  }
+  //----
+
+  PFC_INLINE __m128 sse2_floor(__m128 v_)
+  {
+    __m128 t=sse2_trunc(v_);
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v_), _mm_set1_ps(1.0f)));
+  }
+  //----
+
+  PFC_INLINE __m128 sse2_round(__m128 v_)
+  {
+    // round half away from zero
+    const __m128 sign_mask=_mm_set1_ps(-0.0f);
+    __m128 t=sse2_trunc(v_);
+    __m128 frac=_mm_andnot_ps(sign_mask, _mm_sub_ps(v_, t));
+    __m128 one=_mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(v_, sign_mask));
+    return sse2_select(_mm_cmpge_ps(frac, _mm_set1_ps(0.5f)), _mm_add_ps(t, one), t);
+  }
+  //----
+
+  VBUF_SIMD_F32_2ARG(sse2_add_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps(v0, v1), vbuf_op_add)
+  VBUF_SIMD_F32_2ARG(sse2_sub_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_sub_ps(v0, v1), vbuf_op_sub)
+  VBUF_SIMD_F32_2ARG(sse2_mul_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps(v0, v1), vbuf_op_mul)
+  VBUF_SIMD_F32_2ARG(sse2_div_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_and_ps(_mm_cmpneq_ps(v1, _mm_setzero_ps()), _mm_div_ps(v0, v1)), vbuf_op_div)
+  VBUF_SIMD_F32_2ARG(sse2_min_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_min_ps(v0, v1), vbuf_op_min)
+  VBUF_SIMD_F32_2ARG(sse2_max_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_max_ps(v0, v1), vbuf_op_max)
+  VBUF_SIMD_F32_3ARG(sse2_clamp_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, sse2_select(_mm_cmplt_ps(v0, v1), v1, sse2_select(_mm_cmpgt_ps(v0, v2), v2, v0)), vbuf_op_clamp)
+  VBUF_SIMD_F32_3ARG(sse2_lerp_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_add_ps(v0, _mm_mul_ps(_mm_sub_ps(v1, v0), v2)), vbuf_op_lerp)
+  VBUF_SIMD_F32_1ARG(sse2_floor_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, sse2_floor(v), vbuf_op_floor)
+  VBUF_SIMD_F32_1ARG(sse2_round_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, sse2_round(v), vbuf_op_round)
+  VBUF_SIMD_F32_1ARG(sse2_sqrt_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_sqrt_ps(v), vbuf_op_sqrt)
+  VBUF_SIMD_F32_1ARG(sse2_smoothstep_f32, , __m128, 4, _mm_loadu_ps, _mm_storeu_ps, _mm_mul_ps(_mm_mul_ps(v, v), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), v))), vbuf_op_smoothstep)
+  VBUF_SIMD_I32_2ARG(sse2_add_i32, , __m128i, 4, _mm_loadu_si128, _mm_storeu_si128, _mm_add_epi32(v0, v1), vbuf_op_add)
+  VBUF_SIMD_I32_2ARG(sse2_sub_i32, , __m128i, 4, _mm_loadu_si128, _mm_storeu_si128, _mm_sub_epi32(v0, v1), vbuf_op_sub)
+  VBUF_SIMD_I32_2ARG(sse2_min_i32, , __m128i, 4, _mm_loadu_si128, _mm_storeu_si128, sse2_select(_mm_cmplt_epi32(v0, v1), v0, v1), vbuf_op_min)
+  VBUF_SIMD_I32_2ARG(sse2_max_i32, , __m128i, 4, _mm_loadu_si128, _mm_storeu_si128, sse2_select(_mm_cmpgt_epi32(v0, v1), v0, v1), vbuf_op_max)
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // AVX2 kernels
+  //==========================================================================
+  VBUF_SIMD_AVX2 PFC_INLINE __m256 avx2_round(__m256 v_)
+  {
+    // round half away from zero
+    const __m256 sign_mask=_mm256_set1_ps(-0.0f);
+    __m256 t=_mm256_round_ps(v_, _MM_FROUND_TO_ZERO|_MM_FROUND_NO_EXC);
+    __m256 frac=_mm256_andnot_ps(sign_mask, _mm256_sub_ps(v_, t));
+    __m256 one=_mm256_or_ps(_mm256_set1_ps(1.0f), _mm256_and_ps(v_, sign_mask));
+    return _mm256_blendv_ps(t, _mm256_add_ps(t, one), _mm256_cmp_ps(frac, _mm256_set1_ps(0.5f), _CMP_GE_OQ));
+  }
+  //----
+
+  VBUF_SIMD_F32_2ARG(avx2_add_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps(v0, v1), vbuf_op_add)
+  VBUF_SIMD_F32_2ARG(avx2_sub_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sub_ps(v0, v1), vbuf_op_sub)
+  VBUF_SIMD_F32_2ARG(avx2_mul_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps(v0, v1), vbuf_op_mul)
+  VBUF_SIMD_F32_2ARG(avx2_div_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_and_ps(_mm256_cmp_ps(v1, _mm256_setzero_ps(), _CMP_NEQ_UQ), _mm256_div_ps(v0, v1)), vbuf_op_div)
+  VBUF_SIMD_F32_2ARG(avx2_min_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_min_ps(v0, v1), vbuf_op_min)
+  VBUF_SIMD_F32_2ARG(avx2_max_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_max_ps(v0, v1), vbuf_op_max)
+  VBUF_SIMD_F32_3ARG(avx2_clamp_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_blendv_ps(_mm256_blendv_ps(v0, v2, _mm256_cmp_ps(v0, v2, _CMP_GT_OQ)), v1, _mm256_cmp_ps(v0, v1, _CMP_LT_OQ)), vbuf_op_clamp)
+  VBUF_SIMD_F32_3ARG(avx2_lerp_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_add_ps(v0, _mm256_mul_ps(_mm256_sub_ps(v1, v0), v2)), vbuf_op_lerp)
+  VBUF_SIMD_F32_1ARG(avx2_floor_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_round_ps(v, _MM_FROUND_TO_NEG_INF|_MM_FROUND_NO_EXC), vbuf_op_floor)
+  VBUF_SIMD_F32_1ARG(avx2_round_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, avx2_round(v), vbuf_op_round)
+  VBUF_SIMD_F32_1ARG(avx2_sqrt_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_sqrt_ps(v), vbuf_op_sqrt)
+  VBUF_SIMD_F32_1ARG(avx2_smoothstep_f32, VBUF_SIMD_AVX2, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_mul_ps(_mm256_mul_ps(v, v), _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(_mm256_set1_ps(2.0f), v))), vbuf_op_smoothstep)
+  VBUF_SIMD_I32_2ARG(avx2_add_i32, VBUF_SIMD_AVX2, __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_add_epi32(v0, v1), vbuf_op_add)
+  VBUF_SIMD_I32_2ARG(avx2_sub_i32, VBUF_SIMD_AVX2, __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_sub_epi32(v0, v1), vbuf_op_sub)
+  VBUF_SIMD_I32_2ARG(avx2_mul_i32, VBUF_SIMD_AVX2, __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_mullo_epi32(v0, v1), vbuf_op_mul)
+  VBUF_SIMD_I32_2ARG(avx2_min_i32, VBUF_SIMD_AVX2, __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_min_epi32(v0, v1), vbuf_op_min)
+  VBUF_SIMD_I32_2ARG(avx2_max_i32, VBUF_SIMD_AVX2, __m256i, 8, _mm256_loadu_si256, _mm256_storeu_si256, _mm256_max_epi32(v0, v1), vbuf_op_max)
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // cpu_supports_avx2
+  //==========================================================================
+  bool cpu_supports_avx2()
+  {
+#ifdef _MSC_VER
+    // check for AVX2 and OS support for saving YMM registers
+    int regs[4];
+    __cpuid(regs, 0);
+    if(regs[0]<7)
+      return false;
+    __cpuid(regs, 1);
+    if(!(regs[2]&(1<<27)) || !(regs[2]&(1<<28)) || (_xgetbv(0)&6)!=6)
+      return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1]&(1<<5))!=0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2")!=0;
+#endif
+  }
+#endif // PFC_BUILDOP_VBUF_SIMD
+  //--------------------------------------------------------------------------
+
+  //==========================================================================
+  // init_vbuf_simd_funcs
+  //==========================================================================
+  vbuf_simd_funcs init_vbuf_simd_funcs()
+  {
+    vbuf_simd_funcs funcs;
+    mem_zero(&funcs, sizeof(funcs));
+    funcs.isa_name="scalar";
+#if PFC_BUILDOP_VBUF_SIMD==1
+    if(cpu_supports_avx2())
+    {
+      funcs.isa_name="AVX2";
+      funcs.add_f32=&avx2_add_f32;
+      funcs.sub_f32=&avx2_sub_f32;
+      funcs.mul_f32=&avx2_mul_f32;
+      funcs.div_f32=&avx2_div_f32;
+      funcs.min_f32=&avx2_min_f32;
+      funcs.max_f32=&avx2_max_f32;
+      funcs.clamp_f32=&avx2_clamp_f32;
+      funcs.lerp_f32=&avx2_lerp_f32;
+      funcs.floor_f32=&avx2_floor_f32;
+      funcs.round_f32=&avx2_round_f32;
+      funcs.sqrt_f32=&avx2_sqrt_f32;
+      funcs.smoothstep_f32=&avx2_smoothstep_f32;
+      funcs.add_i32=&avx2_add_i32;
+      funcs.sub_i32=&avx2_sub_i32;
+      funcs.mul_i32=&avx2_mul_i32;
+      funcs.min_i32=&avx2_min_i32;
+      funcs.max_i32=&avx2_max_i32;
+    }
+    else
+    {
+      // SSE2 is always available on x64
+      funcs.isa_name="SSE2";
+      funcs.add_f32=&sse2_add_f32;
+      funcs.sub_f32=&sse2_sub_f32;
+      funcs.mul_f32=&sse2_mul_f32;
+      funcs.div_f32=&sse2_div_f32;
+      funcs.min_f32=&sse2_min_f32;
+      funcs.max_f32=&sse2_max_f32;
+      funcs.clamp_f32=&sse2_clamp_f32;
+      funcs.lerp_f32=&sse2_lerp_f32;
+      funcs.floor_f32=&sse2_floor_f32;
+      funcs.round_f32=&sse2_round_f32;
+      funcs.sqrt_f32=&sse2_sqrt_f32;
+      funcs.smoothstep_f32=&sse2_smoothstep_f32;
+      funcs.add_i32=&sse2_add_i32;
+      funcs.sub_i32=&sse2_sub_i32;
+      funcs.min_i32=&sse2_min_i32;
+      funcs.max_i32=&sse2_max_i32;
+    }
+#endif
+    return funcs;
+  }
+} // namespace <anonymous>
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_simd
+//============================================================================
+const vbuf_simd_funcs &vbuf_simd()
+{
+  static const vbuf_simd_funcs s_funcs=init_vbuf_simd_funcs();
+  return s_funcs;
+}
+//----------------------------------------------------------------------------
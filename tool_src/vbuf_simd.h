@@ -0,0 +1,55 @@
+//============================================================================
+// Meshlete - Meshlet-based 3D object converter
+//
+// Copyright (c) 2022, Jarkko Lempiainen
+// All rights reserved.
+//============================================================================
+
+#ifndef PFC_MESHLETE_VBUF_SIMD_H
+#define PFC_MESHLETE_VBUF_SIMD_H
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// interface
+//============================================================================
+// external
+#include "sxp_src/core/core.h"
+
+// new
+struct vbuf_simd_funcs;
+const vbuf_simd_funcs &vbuf_simd();
+// build config
+#if defined(__x86_64__) || defined(_M_X64)
+#define PFC_BUILDOP_VBUF_SIMD 1
+#else
+#define PFC_BUILDOP_VBUF_SIMD 0
+#endif
+//----------------------------------------------------------------------------
+
+
+//============================================================================
+// vbuf_simd_funcs
+//============================================================================
+// SIMD kernels for contiguous arrays of vertex buffer expression values,
+// selected at runtime for the best instruction set supported by the CPU. The
+// results match the component-wise operators in vbuf_expr_ops.inc. Null for
+// operators without a SIMD kernel for the instruction set.
+struct vbuf_simd_funcs
+{
+  typedef void(*f32_1arg_t)(pfc::float32_t *res_, const pfc::float32_t *v_, pfc::usize_t n_);
+  typedef void(*f32_2arg_t)(pfc::float32_t *res_, const pfc::float32_t *v0_, const pfc::float32_t *v1_, pfc::usize_t n_);
+  typedef void(*f32_3arg_t)(pfc::float32_t *res_, const pfc::float32_t *v0_, const pfc::float32_t *v1_, const pfc::float32_t *v2_, pfc::usize_t n_);
+  typedef void(*i32_2arg_t)(int32_t *res_, const int32_t *v0_, const int32_t *v1_, pfc::usize_t n_);
+  //--------------------------------------------------------------------------
+
+  const char *isa_name;
+  f32_2arg_t add_f32, sub_f32, mul_f32, div_f32, min_f32, max_f32;
+  f32_3arg_t clamp_f32, lerp_f32;
+  f32_1arg_t floor_f32, round_f32, sqrt_f32, smoothstep_f32;
+  i32_2arg_t add_i32, sub_i32, mul_i32, min_i32, max_i32;
+};
+//----------------------------------------------------------------------------
+
+//============================================================================
+#endif